@@ -22,6 +22,16 @@
  *    * Fixed header includes for Arduino 1.0
  *    * Added support for digital blackout
  *    * Made dmxBuffer available externally
+ *    * Added an optional hardware USART transmitter (DMX_USE_USART)
+ *    * Double buffered the universe so frames only change on a frame boundary
+ *    * Added a frame boundary callback
+ *    * Added a per-slot output filter (curves, masters, effects)
+ *    * Added a frame scheduler: break/MAB lengths, frame period, start code
+ *      and auto-trim
+ *    * Added optional timing probe pins (DMX_PROBE_FRAME_PIN, DMX_PROBE_ISR_PIN)
+ *    * Added a count of frames sent
+ *    * Added frame period and break latency measurements (frameStats())
+ *    * Added a timed dmxSendByte() for host builds without the AVR assembler
  *
  *    Alterations commented as // (ajcord)
  */
@@ -30,15 +40,43 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include <util/delay.h>
+#include <util/delay_basic.h> // (ajcord) For the settable break and MAB
 #include "Arduino.h" // (ajcord) Make it work with Arduino 1.0
 #include "DmxSimple.h"
 
 /** dmxBuffer contains a software copy of all the DMX channels.
   */
 volatile uint8_t dmxBuffer[DMX_SIZE];
+/** (ajcord) dmxOutput is the front buffer that is actually transmitted.
+  * dmxBuffer is copied into it when dmxState wraps to 0 after a commit, so
+  * a frame never mixes old and new values.
+  */
+volatile uint8_t dmxOutput[DMX_SIZE];
+static volatile uint8_t dmxCommitPending = 0;
+static volatile uint8_t dmxWriting = 0;
+static volatile uint8_t dmxCommitHeld = 0; // (ajcord) See holdCommit()
+static uint8_t dmxCommitLanded = 0; // (ajcord) Whether this frame boundary swapped in a commit
+static DmxFrameCallback dmxFrameCallback = 0;
+static DmxSlotFilter dmxSlotFilter = 0;
 static uint16_t dmxMax = 16; /* Default to sending the first 16 channels */
+static uint16_t dmxLimit = 16; // (ajcord) dmxMax before auto-trim
+static uint16_t dmxTop = 0; // (ajcord) Highest non-zero channel in the last frame
+static uint8_t dmxTrim = 0; // (ajcord) Whether auto-trim is on
+static uint16_t dmxTrimFloor = 0; // (ajcord) Auto-trim never goes below this many channels
+static volatile uint32_t dmxFrameCount = 0; // (ajcord) Frames sent since power up
+static uint8_t dmxStartCode = 0; // (ajcord) Start code sent before the slots
+static uint16_t dmxBreakTime = DMX_DEFAULT_BREAK; // (ajcord) Frame timing (us)
+static uint16_t dmxMabTime = DMX_DEFAULT_MAB;
+static uint32_t dmxFramePeriod = DMX_MIN_PERIOD;
+static uint16_t dmxFrameGap = 0;
+static uint32_t dmxFrameStart = 0; // (ajcord) micros() at the last break
+static uint32_t dmxFrameEnd = 0; // (ajcord) micros() after the last slot
+static uint8_t dmxStatsPrimed = 0; // (ajcord) Whether dmxFrameStart is from the last frame
+static DmxFrameStats dmxStats; // (ajcord) See frameStats()
+static uint32_t dmxPeriodTotal = 0; // (ajcord) Sum of dmxStats.frames periods
 static uint8_t dmxStarted = 0;
 static uint16_t dmxState = 0;
+static uint16_t dmxFilterBits = 0; // (ajcord) Bit periods the last slot took to work out
 
 static volatile uint8_t *dmxPort;
 static uint8_t dmxBit = 0;
@@ -55,6 +93,266 @@ uint8_t dmxModulate(int, int);
 uint8_t dmxGetValue(int);
 void dmxStartDigitalBlackout();
 void dmxStopDigitalBlackout();
+static void dmxFrameDone();
+void dmxBeginWrite();
+void dmxEndWrite();
+void dmxHoldCommit(uint8_t hold);
+void dmxCommit();
+
+// (ajcord) New function
+/** Works out the byte to send for a slot: the front buffer value passed
+ * through the slot filter, or 0 during a digital blackout.
+ */
+static inline uint8_t dmxSlotValue(uint16_t slot)
+{
+  if (digitalBlackoutEnabled) return 0;
+  uint8_t value = dmxOutput[slot];
+  if (dmxSlotFilter) value = dmxSlotFilter(slot, value);
+  return value;
+}
+
+// (ajcord) Timing probes. The pin numbers are constants, so each of these
+// folds down to a single sbi/cbi.
+#define DMX_PROBE_PORT(pin) (*((pin) < 8 ? &PORTD : (pin) < 14 ? &PORTB : &PORTC))
+#define DMX_PROBE_BIT(pin) _BV((pin) < 8 ? (pin) : (pin) < 14 ? (pin) - 8 : (pin) - 14)
+#ifdef DMX_PROBE_FRAME_PIN
+#define FRAME_PROBE_HIGH() (DMX_PROBE_PORT(DMX_PROBE_FRAME_PIN) |= DMX_PROBE_BIT(DMX_PROBE_FRAME_PIN))
+#define FRAME_PROBE_LOW() (DMX_PROBE_PORT(DMX_PROBE_FRAME_PIN) &= ~DMX_PROBE_BIT(DMX_PROBE_FRAME_PIN))
+#else
+#define FRAME_PROBE_HIGH()
+#define FRAME_PROBE_LOW()
+#endif
+#ifdef DMX_PROBE_ISR_PIN
+#define ISR_PROBE_HIGH() (DMX_PROBE_PORT(DMX_PROBE_ISR_PIN) |= DMX_PROBE_BIT(DMX_PROBE_ISR_PIN))
+#define ISR_PROBE_LOW() (DMX_PROBE_PORT(DMX_PROBE_ISR_PIN) &= ~DMX_PROBE_BIT(DMX_PROBE_ISR_PIN))
+#else
+#define ISR_PROBE_HIGH()
+#define ISR_PROBE_LOW()
+#endif
+
+// (ajcord) New function
+/** Makes the timing probe pins outputs
+ */
+static void dmxProbeBegin()
+{
+#ifdef DMX_PROBE_FRAME_PIN
+  pinMode(DMX_PROBE_FRAME_PIN, OUTPUT);
+  FRAME_PROBE_LOW();
+#endif
+#ifdef DMX_PROBE_ISR_PIN
+  pinMode(DMX_PROBE_ISR_PIN, OUTPUT);
+  ISR_PROBE_LOW();
+#endif
+}
+
+// (ajcord) New function
+/** Whether the frame scheduler lets the next break start: the frame period
+ * has passed since the last break and the gap since the last slot.
+ */
+static inline bool dmxFrameDue()
+{
+  uint32_t now = micros();
+  return now - dmxFrameStart >= dmxFramePeriod &&
+         now - dmxFrameEnd >= dmxFrameGap;
+}
+
+// (ajcord) New function
+/** Busy-waits a number of microseconds that is only known at run time
+ */
+static void dmxDelay(uint16_t us)
+{
+  while (us > 1000) {
+    _delay_loop_2(1000 * (F_CPU / 4000000)); // 4 cycles per loop
+    us -= 1000;
+  }
+  if (us) _delay_loop_2(us * (F_CPU / 4000000));
+}
+
+// (ajcord) New function
+/** Timestamps the start of a break, and measures the frame period and how
+ * late the break is compared to when the frame scheduler first allowed it.
+ * Only called from the transmit interrupts (or before they start).
+ */
+static inline void dmxFrameStarted()
+{
+  uint32_t now = micros();
+  if (dmxStatsPrimed) {
+    uint32_t period = now - dmxFrameStart;
+    uint32_t due = max(dmxFramePeriod, dmxFrameEnd - dmxFrameStart + dmxFrameGap);
+    uint32_t late = period > due ? (period - due) >> 5 : 0;
+    uint8_t bucket = 0;
+    while (late && bucket < DMX_LATENCY_BUCKETS - 1) {
+      late >>= 1;
+      bucket++;
+    }
+    if (dmxStats.latency[bucket] != 0xFFFF) dmxStats.latency[bucket]++;
+
+    if (!dmxStats.frames || period < dmxStats.minPeriod) dmxStats.minPeriod = period;
+    if (period > dmxStats.maxPeriod) dmxStats.maxPeriod = period;
+    // Halve the running sum before it overflows, so the average keeps going
+    if (dmxStats.frames == 0xFFFF || dmxPeriodTotal + period < dmxPeriodTotal) {
+      dmxStats.frames >>= 1;
+      dmxPeriodTotal >>= 1;
+    }
+    dmxStats.frames++;
+    dmxPeriodTotal += period;
+  }
+  dmxFrameStart = now;
+  dmxStatsPrimed = 1;
+}
+
+// (ajcord) Hardware USART transmitter
+#if DMX_USE_USART
+
+#if !defined(__AVR_ATmega168__) && !defined(__AVR_ATmega168P__) && !defined(__AVR_ATmega328P__)
+#error "DMX_USE_USART only supports the ATmega168/328P USART"
+#endif
+
+/* Slots go out at 250 kbaud, 8N2. The break is a 0x00 sent at a slower rate:
+ * the start bit and 8 data bits hold the line low for the break, then the two
+ * stop bits give the mark after break before the start code. At the default
+ * 100 kbaud that is a 90us break and a 20us MAB. A longer MAB is made up with
+ * a short busy-wait.
+ *
+ * While the frame scheduler holds the next frame back, the line idles at mark
+ * with the USART idle, and the TIMER2 overflow (about every 2ms, as set up by
+ * the Arduino core) checks when the break can start.
+ */
+#define DMX_BAUD_UBRR   (F_CPU / 16 / 250000 - 1)
+#define BREAK_BAUD_UBRR (F_CPU / 16 / 100000 - 1)
+#define DMX_TX_PIN      1
+
+static volatile uint8_t dmxInBreak = 0;
+static uint16_t dmxBreakUbrr = BREAK_BAUD_UBRR; // (ajcord) Sets the break length
+static uint16_t dmxMabExtra = 0; // (ajcord) MAB beyond the two stop bits (us)
+
+/** Sets the break baud rate and the extra MAB from dmxBreakTime and dmxMabTime
+ */
+static void dmxSetTiming()
+{
+  // The break is 9 bit times at the break baud rate, rounded to the nearest
+  uint32_t ubrr = ((uint32_t)(F_CPU / 16) * dmxBreakTime / 1000000 + 4) / 9;
+  if (ubrr < 1) ubrr = 1;
+  if (ubrr > 4096) ubrr = 4096;
+  uint16_t stopBits = 2 * ubrr * 1000000 / (F_CPU / 16);
+  uint8_t oldSREG = SREG;
+  cli();
+  dmxBreakUbrr = ubrr - 1;
+  dmxMabExtra = dmxMabTime > stopBits ? dmxMabTime - stopBits : 0;
+  SREG = oldSREG;
+}
+
+/** Starts the break. Only call while the USART is idle.
+ */
+static void dmxStartBreak()
+{
+  FRAME_PROBE_HIGH();
+  dmxFrameStarted();
+  dmxInBreak = 1;
+  UBRR0 = dmxBreakUbrr;
+  UDR0 = 0;
+}
+
+/** Initialise the DMX engine
+ */
+void dmxBegin()
+{
+  dmxStarted = 1;
+  dmxProbeBegin(); // (ajcord)
+
+  // Idle the line at mark while the USART is off
+  pinMode(DMX_TX_PIN, OUTPUT);
+  digitalWrite(DMX_TX_PIN, HIGH);
+
+  UCSR0A = 0;
+  UCSR0C = _BV(USBS0) | _BV(UCSZ01) | _BV(UCSZ00); // 8N2
+  UCSR0B = _BV(TXEN0) | _BV(TXCIE0);
+
+  // Start the first frame with a break
+  dmxState = 0;
+  dmxStartBreak();
+}
+
+/** Stop the DMX engine
+ * Turns off the USART and its interrupts
+ */
+void dmxEnd()
+{
+  UCSR0B = 0;
+  TIMSK2 &= ~_BV(TOIE2);
+  dmxStarted = 0;
+  dmxStatsPrimed = 0; // (ajcord) The next break doesn't end a frame period
+  dmxMax = 0;
+}
+
+/** Transmit complete interrupt
+ * Fires when the last slot of a frame has fully left the shift register (start
+ * the break) and when the break byte has (start the next frame).
+ */
+ISR(USART_TX_vect)
+{
+  ISR_PROBE_HIGH();
+  if (!dmxInBreak) {
+    if (!dmxFrameDue()) {
+      // Too early for the next frame: idle at mark until TIMER2 starts it
+      UCSR0B = _BV(TXEN0);
+      TIMSK2 |= _BV(TOIE2);
+      ISR_PROBE_LOW();
+      return;
+    }
+    dmxStartBreak();
+  } else {
+    dmxInBreak = 0;
+    UBRR0 = DMX_BAUD_UBRR;
+    if (dmxMabExtra) dmxDelay(dmxMabExtra);
+    UDR0 = dmxStartCode;
+    dmxState = 1;
+    UCSR0B = _BV(TXEN0) | _BV(UDRIE0);
+  }
+  ISR_PROBE_LOW();
+}
+
+/** Data register empty interrupt
+ * Feeds the next slot while the previous one is still being shifted out.
+ */
+ISR(USART_UDRE_vect)
+{
+  ISR_PROBE_HIGH();
+  if (dmxState > dmxMax) {
+    // Frame done. Prepare the next one with other interrupts allowed, then
+    // wait for the last slot to finish and send a break.
+    dmxState = 0;
+    dmxFrameEnd = micros();
+    FRAME_PROBE_LOW();
+    UCSR0B = _BV(TXEN0);
+    sei();
+    dmxFrameDone();
+    cli();
+    UCSR0B = _BV(TXEN0) | _BV(TXCIE0);
+    ISR_PROBE_LOW();
+    return;
+  }
+  UDR0 = dmxSlotValue(dmxState-1);
+  UCSR0A = _BV(TXC0); // Only the last slot of the frame may set TXC
+  dmxState++;
+  ISR_PROBE_LOW();
+}
+
+/** Frame scheduler poll
+ * Only enabled while the line idles between frames. Starts the break once
+ * the frame scheduler allows it.
+ */
+ISR(TIMER2_OVF_vect)
+{
+  if (!dmxFrameDue()) return;
+  ISR_PROBE_HIGH();
+  TIMSK2 &= ~_BV(TOIE2);
+  UCSR0B = _BV(TXEN0) | _BV(TXCIE0);
+  dmxStartBreak();
+  ISR_PROBE_LOW();
+}
+
+#else
 
 /* TIMER2 has a different register mapping on the ATmega8.
  * The modern chips (168, 328P, 1280) use identical mappings.
@@ -94,6 +392,7 @@ void dmxBegin()
 
   // Set DMX pin to output
   pinMode(dmxPin,OUTPUT);
+  dmxProbeBegin(); // (ajcord)
 
   // Initialise DMX frame interrupt
   //
@@ -120,9 +419,11 @@ void dmxEnd()
 {
   TIMER2_INTERRUPT_DISABLE();
   dmxStarted = 0;
+  dmxStatsPrimed = 0; // (ajcord) The next break doesn't end a frame period
   dmxMax = 0;
 }
 
+#if defined(__AVR__)
 /** Transmit a complete DMX byte
  * We have no serial port for DMX, so everything is timed using an exact
  * number of instruction cycles.
@@ -167,6 +468,28 @@ void dmxSendByte(volatile uint8_t value)
       [value] "r" (value)
   );
 }
+#else
+// (ajcord) Host builds (see src/host) can't count instruction cycles, so the
+// same 11 bits go out with delays on the simulated clock, interrupts off.
+void dmxSendByte(volatile uint8_t value)
+{
+  cli();
+  *dmxPort &= ~dmxBit; // Start bit
+  uint16_t bits = value | 0x300; // 8 data bits, LSB first, then 2 stop bits
+  for (uint8_t i = 0; i < 10; i++) {
+    _delay_us(4);
+    if (bits & 1) *dmxPort |= dmxBit;
+    else *dmxPort &= ~dmxBit;
+    bits >>= 1;
+  }
+  _delay_us(4);
+  sei();
+}
+#endif
+
+// (ajcord) Timer 0 runs the Arduino clock with a 64 prescaler, so each count
+// is 64 CPU cycles: one DMX bit period at 16 MHz.
+#define DMX_BITS_PER_TIMER0_COUNT ((16000000UL + F_CPU - 1) / F_CPU)
 
 /** DmxSimple interrupt routine
  * Transmit a chunk of DMX signal every timer overflow event.
@@ -184,46 +507,91 @@ ISR(TIMER2_OVF_vect,ISR_NOBLOCK) {
 
   // Prevent this interrupt running recursively
   TIMER2_INTERRUPT_DISABLE();
+  ISR_PROBE_HIGH(); // (ajcord)
 
-  uint16_t bitsLeft = F_CPU / 31372; // DMX Bit periods per timer tick
-  bitsLeft >>=2; // 25% CPU usage
+  const uint16_t budget = (F_CPU / 31372) >> 2; // DMX bit periods per timer tick, 25% CPU usage
+  uint16_t bitsLeft = budget;
   while (1) {
     if (dmxState == 0) {
       // Next thing to send is reset pulse and start code
-      // which takes 35 bit periods
-      uint8_t i;
-      if (bitsLeft < 35) break;
-      bitsLeft-=35;
+      // (ajcord) once the frame scheduler allows it. The break and MAB take
+      // a bit period per 4us and the start code 11. A reset longer than the
+      // whole budget still goes out, as the first thing in a tick.
+      if (!dmxFrameDue()) break;
+      uint16_t resetBits = (dmxBreakTime + dmxMabTime) / 4 + 11;
+      if (bitsLeft < resetBits && bitsLeft != budget) break;
+      bitsLeft = bitsLeft > resetBits ? bitsLeft - resetBits : 0;
+      dmxFrameStarted();
+      FRAME_PROBE_HIGH();
       *dmxPort &= ~dmxBit;
-      for (i=0; i<11; i++) _delay_us(8);
+      dmxDelay(dmxBreakTime);
       *dmxPort |= dmxBit;
-      _delay_us(8);
-      dmxSendByte(0);
+      dmxDelay(dmxMabTime);
+      dmxSendByte(dmxStartCode);
     } else {
       // Now send a channel which takes 11 bit periods
-      if (bitsLeft < 11) break;
-      bitsLeft-=11;
-      dmxSendByte(!digitalBlackoutEnabled ? dmxBuffer[dmxState-1] : 0); // (ajcord) Added digital blackout conditional
+      // (ajcord) plus the time to work it out through the slot filter, timed
+      // on timer 0. The last slot's time is the guess for this one. A slot
+      // longer than the whole budget still goes out, one per tick.
+      if (bitsLeft < 11 + dmxFilterBits && bitsLeft != budget) break;
+      uint8_t filterStart = TCNT0;
+      uint8_t value = dmxSlotValue(dmxState-1); // (ajcord) Blackout and slot filter
+      dmxFilterBits = (uint8_t)(TCNT0 - filterStart) * DMX_BITS_PER_TIMER0_COUNT;
+      bitsLeft = bitsLeft > 11 + dmxFilterBits ? bitsLeft - 11 - dmxFilterBits : 0;
+      dmxSendByte(value);
     }
     // Successfully completed that stage - move state machine forward
     dmxState++;
     if (dmxState > dmxMax) {
       dmxState = 0; // Send next frame
+      dmxFrameEnd = micros();
+      FRAME_PROBE_LOW(); // (ajcord)
+      dmxFrameDone();
       break;
     }
   }
   
   // Enable interrupts for the next transmission chunk
+  ISR_PROBE_LOW(); // (ajcord)
   TIMER2_INTERRUPT_ENABLE();
 }
 
+#endif // DMX_USE_USART
+
+// (ajcord) New function
+/** Called by the transmitter each time dmxState wraps to 0
+ * Swaps in the back buffer if a commit is waiting, then runs the frame
+ * callback. Skipped while something is halfway through changing dmxBuffer.
+ */
+static void dmxFrameDone()
+{
+  dmxFrameCount++; // (ajcord)
+  if (dmxWriting) return;
+  dmxCommitLanded = dmxCommitPending && !dmxCommitHeld;
+  if (dmxCommitLanded) {
+    for (uint16_t i = 0; i < DMX_SIZE; i++) dmxOutput[i] = dmxBuffer[i];
+    dmxCommitPending = 0;
+  }
+  if (dmxFrameCallback) dmxFrameCallback();
+  if (dmxTrim) {
+    // Send up to the highest non-zero channel, but keep the channels that
+    // were on in the last frame for one more so they are seen going to 0.
+    uint16_t top = dmxLimit;
+    while (top > 1 && top > dmxTrimFloor && !dmxOutput[top-1]) top--;
+    dmxMax = max(top, dmxTop);
+    dmxTop = top;
+  }
+}
+
 uint8_t dmxWrite(int channel, uint8_t value) {  // --> uint8_t replaces void as return value
   uint8_t oldValue = 0;				// --> buffer for return value
   if (!dmxStarted) dmxBegin(); 
   if ((channel > 0) && (channel <= DMX_SIZE)) {
     dmxMax = max((unsigned)channel, dmxMax); 
+    dmxLimit = max((unsigned)channel, dmxLimit); // (ajcord)
     oldValue = dmxBuffer[channel-1];		// --> remember previous value
     dmxBuffer[channel-1] = value; 
+    dmxCommit(); // (ajcord)
   } 
   return oldValue; 				// --> return previous value
 } 
@@ -235,6 +603,7 @@ void dmxMaxChannel(int channel) {
     dmxMax = 0;
   } else {
     dmxMax = min(channel, DMX_SIZE);
+    dmxLimit = dmxMax; // (ajcord)
     if (!dmxStarted) dmxBegin();
   }
 }
@@ -245,7 +614,10 @@ uint8_t dmxModulate(int channel, int offset)
   if (!dmxStarted) dmxBegin();
   if ((channel > 0) && (channel <= DMX_SIZE)) {
     dmxMax = max((unsigned)channel, dmxMax); 
-    return (dmxBuffer[channel-1] = max(min(offset + dmxBuffer[channel-1], 255), 0));
+    dmxLimit = max((unsigned)channel, dmxLimit); // (ajcord)
+    dmxBuffer[channel-1] = max(min(offset + dmxBuffer[channel-1], 255), 0);
+    dmxCommit(); // (ajcord)
+    return dmxBuffer[channel-1];
   }
   return 0;
 }
@@ -269,11 +641,46 @@ void dmxStopDigitalBlackout() {
   digitalBlackoutEnabled = false;
 }
 
+// (ajcord) New function
+void dmxBeginWrite() {
+  dmxWriting = 1;
+}
+
+// (ajcord) New function
+void dmxEndWrite() {
+  dmxWriting = 0;
+}
+
+// (ajcord) New function
+/** Unlike beginWrite, fades and effects keep running from the frame callback
+ * while commits are held, so this suits dmxBuffer being filled over a long
+ * time (such as while a packet is still arriving).
+ */
+void dmxHoldCommit(uint8_t hold) {
+  dmxCommitHeld = hold;
+  if (!hold && dmxCommitPending && !dmxStarted) {
+    // No frame boundary is coming to pick the commit up
+    for (uint16_t i = 0; i < DMX_SIZE; i++) dmxOutput[i] = dmxBuffer[i];
+    dmxCommitPending = 0;
+  }
+}
+
+// (ajcord) New function
+void dmxCommit() {
+  if (!dmxStarted && !dmxCommitHeld) {
+    // No frames are going out, so there is nothing to tear
+    for (uint16_t i = 0; i < DMX_SIZE; i++) dmxOutput[i] = dmxBuffer[i];
+    return;
+  }
+  dmxCommitPending = 1;
+}
+
 /* C++ wrapper */
 
 
 /** Set output pin
  * @param pin Output digital pin to use
+ * (ajcord) Has no effect with DMX_USE_USART, which always uses TX (pin 1).
  */
 void DmxSimpleClass::usePin(uint8_t pin) {
   bool restartRequired = dmxStarted;
@@ -325,4 +732,131 @@ void DmxSimpleClass::stopDigitalBlackout() {
   dmxStopDigitalBlackout();
 }
 
+// (ajcord) New function
+void DmxSimpleClass::beginWrite() {
+  dmxBeginWrite();
+}
+
+// (ajcord) New function
+void DmxSimpleClass::endWrite() {
+  dmxEndWrite();
+}
+
+// (ajcord) New function
+void DmxSimpleClass::holdCommit(bool hold) {
+  dmxHoldCommit(hold);
+}
+
+// (ajcord) New function
+void DmxSimpleClass::commit() {
+  dmxCommit();
+}
+
+// (ajcord) New function
+bool DmxSimpleClass::committing() {
+  return dmxCommitPending;
+}
+
+// (ajcord) New function
+/** Only meaningful in the frame callback
+ */
+bool DmxSimpleClass::frameCommitted() {
+  return dmxCommitLanded;
+}
+
+// (ajcord) New function
+void DmxSimpleClass::onFrame(DmxFrameCallback callback) {
+  dmxFrameCallback = callback;
+}
+
+// (ajcord) New function
+void DmxSimpleClass::onSlot(DmxSlotFilter filter) {
+  dmxSlotFilter = filter;
+}
+
+/** (ajcord) Set the break and mark after break lengths
+ * @param breakTime Break length in microseconds
+ * @param mabTime Mark after break length in microseconds
+ * With DMX_USE_USART the break is rounded to a whole baud rate divisor, and
+ * the MAB is at least two bit times at that rate.
+ */
+void DmxSimpleClass::timing(uint16_t breakTime, uint16_t mabTime) {
+  dmxBreakTime = breakTime;
+  dmxMabTime = mabTime;
+#if DMX_USE_USART
+  dmxSetTiming();
+#endif
+}
+
+/** (ajcord) Set the frame scheduler
+ * @param period Shortest time from one break to the next in microseconds
+ *               (at least DMX_MIN_PERIOD)
+ * @param gap Shortest mark between the last slot and the next break in
+ *            microseconds
+ * Frames start when both have passed. While waiting, the line idles at mark.
+ */
+void DmxSimpleClass::framePeriod(uint32_t period, uint16_t gap) {
+  uint8_t oldSREG = SREG;
+  cli();
+  dmxFramePeriod = max(period, (uint32_t)DMX_MIN_PERIOD);
+  dmxFrameGap = gap;
+  SREG = oldSREG;
+}
+
+// (ajcord) New function
+void DmxSimpleClass::startCode(uint8_t code) {
+  dmxStartCode = code;
+}
+
+/** (ajcord) Turn auto-trim on or off
+ * With auto-trim, each frame ends after the highest non-zero channel (up to
+ * the maxChannel() limit), so small rigs refresh faster. Levels are looked at
+ * before the slot filter.
+ */
+void DmxSimpleClass::autoTrim(bool enabled) {
+  uint8_t oldSREG = SREG;
+  cli();
+  dmxTrim = enabled;
+  dmxTop = dmxLimit;
+  if (!enabled && dmxStarted) dmxMax = dmxLimit;
+  SREG = oldSREG;
+}
+
+/** (ajcord) Keep channels in frames even if their levels are 0
+ * Auto-trim only looks at dmxOutput, so a slot filter that puts levels on
+ * channels at 0 sets this from the frame callback. (Channels past the
+ * maxChannel() limit are still not sent.)
+ * @param channels How many channels auto-trim always sends
+ */
+void DmxSimpleClass::trimFloor(uint16_t channels) {
+  dmxTrimFloor = channels;
+}
+
+/** (ajcord) Number of frames sent since power up
+ * Wraps after 2^32 frames (about 60 days at the fastest frame rate).
+ */
+uint32_t DmxSimpleClass::frames() {
+  uint8_t oldSREG = SREG;
+  cli();
+  uint32_t count = dmxFrameCount;
+  SREG = oldSREG;
+  return count;
+}
+
+/** (ajcord) Copy out the frame timing measured since the last reset
+ * avgPeriod is worked out here from the running sum kept by the transmitter.
+ * @param reset Whether to start measuring again afterwards
+ */
+void DmxSimpleClass::frameStats(DmxFrameStats &stats, bool reset) {
+  uint8_t oldSREG = SREG;
+  cli();
+  stats = dmxStats;
+  stats.avgPeriod = dmxStats.frames ? dmxPeriodTotal / dmxStats.frames : 0;
+  if (reset) {
+    memset(&dmxStats, 0, sizeof(dmxStats));
+    dmxPeriodTotal = 0;
+  }
+  SREG = oldSREG;
+}
+
 DmxSimpleClass DmxSimple;
@@ -19,6 +19,15 @@
  *
  *    * Added support for digital blackout
  *    * Made dmxBuffer available externally
+ *    * Added an optional hardware USART transmitter (DMX_USE_USART)
+ *    * Double buffered the universe so frames only change on a frame boundary
+ *    * Added a frame boundary callback
+ *    * Added a per-slot output filter (curves, masters, effects)
+ *    * Added a frame scheduler: break/MAB lengths, frame period, start code
+ *      and auto-trim
+ *    * Added optional timing probe pins (DMX_PROBE_FRAME_PIN, DMX_PROBE_ISR_PIN)
+ *    * Added a count of frames sent
+ *    * Added frame period and break latency measurements (frameStats())
  *
  *    Alterations commented as // (ajcord)
  */
@@ -34,6 +43,51 @@
 #define DMX_SIZE 512
 //#endif
 
+// (ajcord) Set DMX_USE_USART to 1 to transmit DMX from the ATmega328P USART
+// (TX, pin 1) instead of bit-banging the pin set by usePin(). The USART sends
+// a full universe at the spec rate with almost no CPU time, but the serial
+// port can no longer be used for anything else.
+#ifndef DMX_USE_USART
+#define DMX_USE_USART 0
+#endif
+
+// (ajcord) Timing probes for a scope or logic analyzer (ATmega168/328P only).
+// Define either to a free Arduino pin number to enable it:
+//    DMX_PROBE_FRAME_PIN goes high at the start of each break and low after
+//       the last slot, so its rising edges give the frame period and jitter.
+//    DMX_PROBE_ISR_PIN is high while a DMX transmit interrupt runs.
+// Each probe costs one instruction per edge; undefined, they cost nothing.
+//#define DMX_PROBE_FRAME_PIN 14 // A0
+//#define DMX_PROBE_ISR_PIN 15 // A1
+
+// (ajcord) Frame timing defaults, in microseconds. The minimum period is the
+// shortest break-to-break time DMX512 allows.
+#define DMX_DEFAULT_BREAK 88
+#define DMX_DEFAULT_MAB 8
+#define DMX_MIN_PERIOD 1204
+
+// (ajcord) Called at every frame boundary, after any commit
+typedef void (*DmxFrameCallback)(void);
+
+// (ajcord) Called from the transmit interrupt for every slot, in order, with
+// the slot index (0-511) and its dmxOutput value. Returns the byte to send.
+// Keep it short: it runs once per slot.
+typedef uint8_t (*DmxSlotFilter)(uint16_t, uint8_t);
+
+// (ajcord) Frame timing measured by the transmitter from micros() at each
+// break. Times are in microseconds. latency counts how late breaks started
+// after the frame scheduler allowed them: bucket 0 is under 32us, each one
+// after it covers twice the time of the one before, and the last is 2048us
+// and over. Mostly this is time spent waiting for the transmit interrupt.
+#define DMX_LATENCY_BUCKETS 8
+struct DmxFrameStats {
+  uint16_t frames;      // Frame periods in the average
+  uint32_t minPeriod;   // Break to break
+  uint32_t avgPeriod;
+  uint32_t maxPeriod;
+  uint16_t latency[DMX_LATENCY_BUCKETS]; // Stop at 0xFFFF
+};
+
 class DmxSimpleClass
 {
   public:
@@ -46,9 +100,30 @@ class DmxSimpleClass
     uint8_t getValue(int);          // returns current value of given channel
     void startDigitalBlackout();    // (ajcord) Starts a digital blackout
     void stopDigitalBlackout();     // (ajcord) Stops a digital blackout
+    void beginWrite();              // (ajcord) Holds off commits while dmxBuffer is being changed
+    void endWrite();                // (ajcord) Allows commits again
+    void holdCommit(bool);          // (ajcord) Holds off commits without stopping the frame callback
+    void commit();                  // (ajcord) Sends dmxBuffer from the next frame on
+    bool committing();              // (ajcord) Whether a commit is still waiting for the frame boundary
+    bool frameCommitted();          // (ajcord) Whether the frame starting now has a commit in it
+    void onFrame(DmxFrameCallback); // (ajcord) Sets the frame boundary callback
+    void onSlot(DmxSlotFilter);     // (ajcord) Sets the per-slot output filter
+    void timing(uint16_t, uint16_t); // (ajcord) Sets the break and mark after break lengths (us)
+    void framePeriod(uint32_t, uint16_t); // (ajcord) Sets the minimum frame period and the mark between frames (us)
+    void startCode(uint8_t);        // (ajcord) Sets the start code sent before the slots
+    void autoTrim(bool);            // (ajcord) Stops each frame after the highest non-zero channel
+    void trimFloor(uint16_t);       // (ajcord) Sets how many channels auto-trim always sends
+    uint32_t frames();              // (ajcord) Number of frames sent since power up
+    void frameStats(DmxFrameStats &, bool); // (ajcord) Gets (and optionally resets) the frame timing
 };
 extern DmxSimpleClass DmxSimple;
 
-extern volatile uint8_t dmxBuffer[DMX_SIZE]; // (ajcord) Moved here so it is available to other files.
+// (ajcord) Moved here so it is available to other files.
+// This is the back buffer: changes to it are only transmitted once they are
+// committed, and then starting on a frame boundary.
+extern volatile uint8_t dmxBuffer[DMX_SIZE];
+// (ajcord) The front buffer that is actually transmitted. Only change it from
+// the frame callback.
+extern volatile uint8_t dmxOutput[DMX_SIZE];
 
 #endif
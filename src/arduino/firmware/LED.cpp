@@ -28,17 +28,12 @@
  ******************************************************************************/
 
 #include "Arduino.h"
+#include <util/atomic.h>
 
 #include "LED.h"
 #include "firmware.h"
 #include "status.h"
 
-/******************************************************************************
- * Internal constants
- ******************************************************************************/
-
-#define MILLISECONDS_PER_BLINK    100
-
 /******************************************************************************
  * Function definitions
  ******************************************************************************/
@@ -52,6 +47,7 @@ void LEDClass::begin(void) {
   pinMode(LED_PIN, OUTPUT);
   ledPattern = NORMAL_LED_PATTERN;
   ledDuration = NORMAL_LED_DURATION;
+  ledStep = 0;
   previousPattern = 0;
   previousDuration = 0;
 }
@@ -59,16 +55,15 @@ void LEDClass::begin(void) {
 /**
  * blinkLED - Blinks the LED according to the previously set pattern.
  *
- * This function should be called at least 10 times per second.
+ * This function should be called every MILLISECONDS_PER_BLINK. It is run
+ * by the scheduler from the timer interrupt.
  */
 void LEDClass::update(void) {
-  if (millis() % MILLISECONDS_PER_BLINK) { //Only change state every 100ms
-    return;
-  }
-
   //Get the bit for the new state
-  uint8_t bit = (millis() / MILLISECONDS_PER_BLINK) % ledDuration;
-  bool newState = (ledPattern >> bit) & 0x0001;
+  if (++ledStep >= ledDuration) {
+    ledStep = 0;
+  }
+  bool newState = (ledPattern >> ledStep) & 0x0001;
 
   //Turn the LED on or off
   digitalWrite(LED_PIN, newState);
@@ -78,23 +73,24 @@ void LEDClass::update(void) {
  * chooseLEDPattern - Chooses the pattern to display based on the status flags.
  */
 void LEDClass::choosePattern(void) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { //update() may be showing the pattern
+    if (Status.test(DEBUG_STATUS)) {
+      ledPattern = DEBUG_LED_PATTERN;
+      ledDuration = DEBUG_LED_DURATION;
 
-  if (Status.test(DEBUG_STATUS)) {
-    ledPattern = DEBUG_LED_PATTERN;
-    ledDuration = DEBUG_LED_DURATION;
-
-  } else if (Status.test(ERROR_STATUS)) {
-    ledPattern = ERROR_LED_PATTERN;
-    ledDuration = ERROR_LED_DURATION;
+    } else if (Status.test(ERROR_STATUS)) {
+      ledPattern = ERROR_LED_PATTERN;
+      ledDuration = ERROR_LED_DURATION;
 
-  } else if (Status.test(SENT_SHUT_DOWN_WARNING_STATUS)) {
-    ledPattern = SOS_LED_PATTERN;
-    ledDuration = SOS_LED_DURATION;
+    } else if (Status.test(SENT_SHUT_DOWN_WARNING_STATUS)) {
+      ledPattern = SOS_LED_PATTERN;
+      ledDuration = SOS_LED_DURATION;
 
-  } else { //All systems nominal
-    ledPattern = NORMAL_LED_PATTERN;
-    ledDuration = NORMAL_LED_DURATION;
+    } else { //All systems nominal
+      ledPattern = NORMAL_LED_PATTERN;
+      ledDuration = NORMAL_LED_DURATION;
 
+    }
   }
 }
 
@@ -40,6 +40,7 @@
 
 //Each pattern bit is 0.1 seconds. The LSbit occurs first.
 //Duration is the periodicity in tenths of seconds.
+#define MILLISECONDS_PER_BLINK          100
 #define NORMAL_LED_PATTERN              0b000001111111111
 #define NORMAL_LED_DURATION             15
 
@@ -65,6 +66,7 @@ class LEDClass {
     private:
         uint32_t ledPattern;
         uint32_t ledDuration;
+        uint8_t ledStep; //The pattern bit showing
 
         uint32_t previousPattern;
         uint32_t previousDuration;
@@ -0,0 +1,314 @@
+/**
+ * DMX-84
+ * Universe compression code
+ *
+ * This file contains the code for the run-length and delta encodings used to
+ * send channel data over the link. The RLE command (0x2A) carries channel
+ * values; the delta command (0x2B) carries the XOR of the new values with the
+ * current ones, so unchanged channels become long runs of zero. Both use the
+ * same token stream, and both are decoded straight into dmxBuffer.
+ *
+ * The encoder is plain C++ with no Arduino dependencies so the same file can
+ * be built into host-side tools.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "codec.h"
+
+/******************************************************************************
+ * Internal constants
+ ******************************************************************************/
+
+//Bytes before the tokens in an RLE or delta packet: command, start lo, start hi
+#define PACKET_HEADER_LENGTH  3
+
+//Shortest repeat worth a run token in the middle of literals
+#define MIN_RUN_LENGTH        3
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**
+ * decode - Applies a token stream to a universe
+ *
+ * Parameters:
+ *    volatile uint8_t *universe: the channels to write
+ *    uint16_t start: the first channel the stream covers
+ *    const uint8_t *data: the tokens
+ *    uint16_t length: the number of token bytes
+ *    bool patch: true to XOR the values in, false to store them
+ * Returns:
+ *    true if the whole stream was applied, false if it was truncated or ran
+ *    past the end of the universe. Bytes before the bad token are still
+ *    applied.
+ */
+bool CodecClass::decode(volatile uint8_t *universe, uint16_t start,
+    const uint8_t *data, uint16_t length, bool patch) {
+  CodecStream stream;
+  openStream(&stream, start, patch);
+  for (uint16_t i = 0; i < length; i++) {
+    if (!feed(&stream, universe, data[i])) {
+      return false;
+    }
+  }
+  return closeStream(&stream);
+}
+
+/**
+ * openStream - Starts decoding a token stream a byte at a time
+ *
+ * Parameters:
+ *    CodecStream *stream: the decoder state to set up
+ *    uint16_t start: the first channel the stream covers
+ *    bool patch: true to XOR the values in, false to store them
+ *
+ * Lets a packet be decoded as it arrives, without keeping it.
+ */
+void CodecClass::openStream(CodecStream *stream, uint16_t start, bool patch) {
+  stream->channel = start;
+  stream->literals = 0;
+  stream->run = 0;
+  stream->patch = patch;
+  stream->failed = false;
+}
+
+/**
+ * feed - Decodes the next byte of a token stream
+ *
+ * Parameters:
+ *    CodecStream *stream: the decoder state
+ *    volatile uint8_t *universe: the channels to write
+ *    uint8_t byte: the next byte of the stream
+ * Returns:
+ *    false if this or an earlier token ran past the end of the universe.
+ *    The rest of the stream is then ignored.
+ */
+bool CodecClass::feed(CodecStream *stream, volatile uint8_t *universe,
+    uint8_t byte) {
+  if (stream->failed) {
+    return false;
+  }
+  
+  uint8_t count;
+  if (stream->literals) {
+    stream->literals--;
+    count = 1;
+  } else if (stream->run) {
+    count = stream->run;
+    stream->run = 0;
+  } else {
+    //A control byte. Check the whole token fits before any of it is written.
+    uint8_t length = byte & CODEC_RUN_FLAG ? byte - (CODEC_RUN_FLAG - 1) :
+        byte + 1;
+    if (stream->channel + length > CODEC_UNIVERSE_SIZE) {
+      stream->failed = true;
+      return false;
+    }
+    if (byte & CODEC_RUN_FLAG) {
+      stream->run = length;
+    } else {
+      stream->literals = length;
+    }
+    return true;
+  }
+  
+  for (uint8_t j = 0; j < count; j++) {
+    if (stream->patch) {
+      universe[stream->channel] ^= byte;
+    } else {
+      universe[stream->channel] = byte;
+    }
+    stream->channel++;
+  }
+  return true;
+}
+
+/**
+ * closeStream - Checks that a token stream ended cleanly
+ *
+ * Parameter:
+ *    const CodecStream *stream: the decoder state
+ * Returns:
+ *    true if every token was whole and within the universe
+ */
+bool CodecClass::closeStream(const CodecStream *stream) {
+  return !stream->failed && !stream->literals && !stream->run;
+}
+
+/**
+ * encode - Encodes channel values as a token stream
+ *
+ * Parameters:
+ *    const uint8_t *values: the channel values to encode
+ *    const uint8_t *base: values to XOR against (delta), or 0 for plain RLE
+ *    uint16_t count: the number of channels to encode
+ *    uint8_t *out: where to put the tokens, or 0 to only measure them
+ *    uint16_t outSize: the space available at out
+ *    uint16_t *consumed: set to the number of channels encoded (may be 0)
+ * Returns:
+ *    the number of bytes written. Only whole tokens are written, so when out
+ *    fills up, *consumed tells where the next stream should start.
+ */
+uint16_t CodecClass::encode(const uint8_t *values, const uint8_t *base,
+    uint16_t count, uint8_t *out, uint16_t outSize, uint16_t *consumed) {
+  uint16_t pos = 0;
+  uint16_t i = 0;
+  while (i < count) {
+    //Measure the repeat starting here
+    uint8_t first = value(values, base, i);
+    uint16_t run = 1;
+    while (i + run < count && run < CODEC_MAX_TOKEN &&
+        value(values, base, i + run) == first) {
+      run++;
+    }
+    
+    if (run >= MIN_RUN_LENGTH || i + run == count) {
+      //Run token
+      if (pos + 2 > outSize) {
+        break;
+      }
+      if (out) {
+        out[pos] = run + (CODEC_RUN_FLAG - 1);
+        out[pos + 1] = first;
+      }
+      pos += 2;
+      i += run;
+      continue;
+    }
+    
+    //Literal token: take values until a worthwhile run begins
+    uint16_t literal = 0;
+    while (i + literal < count && literal < CODEC_MAX_TOKEN) {
+      uint16_t j = i + literal;
+      if (j + MIN_RUN_LENGTH <= count &&
+          value(values, base, j) == value(values, base, j + 1) &&
+          value(values, base, j) == value(values, base, j + 2)) {
+        break;
+      }
+      literal++;
+    }
+    if (pos + 1 + literal > outSize) {
+      if (pos + 2 > outSize) {
+        break;
+      }
+      literal = outSize - pos - 1; //Send what fits
+    }
+    if (out) {
+      out[pos] = literal - 1;
+      for (uint16_t j = 0; j < literal; j++) {
+        out[pos + 1 + j] = value(values, base, i + j);
+      }
+    }
+    pos += 1 + literal;
+    i += literal;
+  }
+  *consumed = i;
+  return pos;
+}
+
+/**
+ * pack - Builds the smallest packet that brings a receiver to a universe
+ *
+ * Parameters:
+ *    const uint8_t *universe: the 512 channel values to send
+ *    const uint8_t *last: the 512 values the receiver already has, or 0 if
+ *                         unknown
+ *    uint8_t *out: where to put the packet (CODEC_MAX_PACKET bytes)
+ * Returns:
+ *    the packet length, or 0 if the receiver is already up to date
+ *
+ * Tries the raw (0x27), RLE (0x2A) and, if last is known, delta (0x2B) forms.
+ * When last is known, unchanged channels at either end are left out. A delta
+ * is only used if it fits in CODEC_MAX_PATCH bytes.
+ */
+uint16_t CodecClass::pack(const uint8_t *universe, const uint8_t *last,
+    uint8_t *out) {
+  uint16_t first = 0;
+  uint16_t end = CODEC_UNIVERSE_SIZE;
+  if (last) {
+    while (first < end && universe[first] == last[first]) {
+      first++;
+    }
+    if (first == end) {
+      return 0; //Nothing changed
+    }
+    while (universe[end - 1] == last[end - 1]) {
+      end--;
+    }
+  }
+  
+  //Anything that doesn't beat the raw packet is not worth finishing
+  uint16_t count = end - first;
+  uint16_t limit = CODEC_MAX_PACKET - PACKET_HEADER_LENGTH - 1;
+  uint16_t consumed;
+  uint16_t rleLength = encode(universe + first, 0, count, 0, limit,
+      &consumed);
+  bool rleFits = (consumed == count);
+  uint16_t deltaLength = 0;
+  bool deltaFits = false;
+  uint16_t patchLimit = CODEC_MAX_PATCH - PACKET_HEADER_LENGTH;
+  if (last) {
+    deltaLength = encode(universe + first, last + first, count, 0,
+        patchLimit, &consumed);
+    deltaFits = (consumed == count);
+  }
+  
+  if (deltaFits && (!rleFits || deltaLength < rleLength)) {
+    out[0] = CODEC_DELTA_CMD;
+    out[1] = first & 0xFF;
+    out[2] = first >> 8;
+    return PACKET_HEADER_LENGTH + encode(universe + first, last + first,
+        count, out + PACKET_HEADER_LENGTH, patchLimit, &consumed);
+  } else if (rleFits) {
+    out[0] = CODEC_RLE_CMD;
+    out[1] = first & 0xFF;
+    out[2] = first >> 8;
+    return PACKET_HEADER_LENGTH + encode(universe + first, 0, count,
+        out + PACKET_HEADER_LENGTH, limit, &consumed);
+  } else {
+    out[0] = CODEC_RAW_CMD;
+    for (uint16_t i = 0; i < CODEC_UNIVERSE_SIZE; i++) {
+      out[i + 1] = universe[i];
+    }
+    return CODEC_MAX_PACKET;
+  }
+}
+
+/**
+ * value - Gets the value to encode for a channel
+ *
+ * Parameters:
+ *    const uint8_t *values: the channel values
+ *    const uint8_t *base: values to XOR against, or 0
+ *    uint16_t i: the channel index
+ * Returns:
+ *    the channel value, XORed with the base value if there is one
+ */
+uint8_t CodecClass::value(const uint8_t *values, const uint8_t *base,
+    uint16_t i) {
+  return base ? values[i] ^ base[i] : values[i];
+}
+
+CodecClass Codec;
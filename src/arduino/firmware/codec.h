@@ -0,0 +1,99 @@
+/**
+ * DMX-84
+ * Universe compression header
+ *
+ * This file contains the external defines and prototypes for the run-length
+ * and delta encodings used to send channel data over the link.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CODEC_H
+#define CODEC_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <inttypes.h>
+
+/******************************************************************************
+ * External constants
+ ******************************************************************************/
+
+#define CODEC_UNIVERSE_SIZE   512
+
+//Commands carrying channel data
+#define CODEC_RAW_CMD         0x27 //512 raw values
+#define CODEC_RLE_CMD         0x2A //Run-length coded values from a start channel
+#define CODEC_DELTA_CMD       0x2B //Run-length coded XOR patch from a start channel
+
+//Largest packet pack() can produce (the raw form, which it never exceeds)
+#define CODEC_MAX_PACKET      (1 + CODEC_UNIVERSE_SIZE)
+
+//Largest XOR patch packet pack() produces. Patches aren't streamed, so they
+//must fit in the adapter's receive ring (RX_QUEUE_LENGTH in link.h).
+#define CODEC_MAX_PATCH       262
+
+/* Token format shared by the RLE and delta commands. Each token is a control
+ * byte followed by its data:
+ *    0x00-0x7F: (control + 1) literal bytes follow
+ *    0x80-0xFF: one byte follows, repeated (control - 0x7F) times
+ */
+#define CODEC_RUN_FLAG        0x80
+#define CODEC_MAX_TOKEN       128
+
+/******************************************************************************
+ * External types
+ ******************************************************************************/
+
+//A token stream being decoded a byte at a time (see CodecClass::feed)
+struct CodecStream {
+  uint16_t channel;     //The next channel to write
+  uint8_t literals;     //Literal bytes still to come in this token
+  uint8_t run;          //Length of the run whose value comes next
+  bool patch;
+  bool failed;
+};
+
+/******************************************************************************
+ * Class definition
+ ******************************************************************************/
+
+class CodecClass {
+    public:
+        bool decode(volatile uint8_t *universe, uint16_t start,
+            const uint8_t *data, uint16_t length, bool patch);
+        void openStream(CodecStream *stream, uint16_t start, bool patch);
+        bool feed(CodecStream *stream, volatile uint8_t *universe,
+            uint8_t byte);
+        bool closeStream(const CodecStream *stream);
+        uint16_t encode(const uint8_t *values, const uint8_t *base,
+            uint16_t count, uint8_t *out, uint16_t outSize,
+            uint16_t *consumed);
+        uint16_t pack(const uint8_t *universe, const uint8_t *last,
+            uint8_t *out);
+
+    private:
+        uint8_t value(const uint8_t *values, const uint8_t *base, uint16_t i);
+};
+
+extern CodecClass Codec;
+
+#endif
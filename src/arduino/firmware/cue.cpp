@@ -0,0 +1,152 @@
+/**
+ * DMX-84
+ * Cue queue code
+ *
+ * This file contains the code for holding commands until a set time, so a
+ * change sent as several packets can be applied all at once.
+ *
+ * Last modified October 15, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include <DmxSimple.h>
+
+#include "cue.h"
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**
+ * add - Queues a command packet to run at a set time.
+ *
+ * Parameters:
+ *    uint8_t unit: CUE_MILLISECONDS or CUE_FRAMES
+ *    uint32_t time: when to run it, in unit (a time already passed runs
+ *                   right away)
+ *    const uint8_t *data: the command packet
+ *    uint8_t length: the length of data (1-CUE_DATA_LENGTH)
+ * Returns:
+ *    bool added: false if there is no room left
+ */
+bool CueClass::add(uint8_t unit, uint32_t time, const uint8_t *data,
+    uint8_t length) {
+  uint8_t size = CUE_HEADER_LENGTH + length;
+  if (length == 0 || size > CUE_POOL_LENGTH - used) {
+    return false;
+  }
+
+  //Go after every cue in the same unit that isn't later than this one
+  uint8_t at = 0;
+  for (uint8_t r = 0; r < used; r = next(r)) {
+    if (pool[r + 4] == unit && (int32_t)(timeAt(r) - time) > 0) {
+      break;
+    }
+    at = next(r);
+  }
+
+  memmove(pool + at + size, pool + at, used - at);
+  used += size;
+  pool[at] = time & 0xFF;
+  pool[at + 1] = (time >> 8) & 0xFF;
+  pool[at + 2] = (time >> 16) & 0xFF;
+  pool[at + 3] = time >> 24;
+  pool[at + 4] = unit;
+  pool[at + 5] = length;
+  memcpy(pool + at + CUE_HEADER_LENGTH, data, length);
+  return true;
+}
+
+/**
+ * take - Removes the first command whose time has come from the queue.
+ *
+ * Parameter:
+ *    uint8_t *data: where to put the command packet (CUE_DATA_LENGTH bytes)
+ * Returns:
+ *    uint8_t length: the length of the command, or 0 if none is due
+ */
+uint8_t CueClass::take(uint8_t *data) {
+  uint32_t now = millis();
+  uint32_t frame = DmxSimple.frames();
+  for (uint8_t r = 0; r < used; r = next(r)) {
+    uint32_t time = pool[r + 4] == CUE_FRAMES ? frame : now;
+    if ((int32_t)(time - timeAt(r)) < 0) {
+      continue;
+    }
+    uint8_t length = pool[r + 5];
+    uint8_t end = next(r);
+    memcpy(data, pool + r + CUE_HEADER_LENGTH, length);
+    memmove(pool + r, pool + end, used - end);
+    used -= end - r;
+    return length;
+  }
+  return 0;
+}
+
+/**
+ * clear - Drops every waiting command.
+ */
+void CueClass::clear(void) {
+  used = 0;
+}
+
+/**
+ * waiting - Counts the waiting commands.
+ *
+ * Returns:
+ *    uint8_t count: the number of commands in the queue
+ */
+uint8_t CueClass::waiting(void) {
+  uint8_t count = 0;
+  for (uint8_t r = 0; r < used; r = next(r)) {
+    count++;
+  }
+  return count;
+}
+
+/**
+ * timeAt - Reads the time of a record.
+ *
+ * Parameter:
+ *    uint8_t record: the offset of the record in pool
+ * Returns:
+ *    uint32_t time: when it runs
+ */
+uint32_t CueClass::timeAt(uint8_t record) {
+  return pool[record] | (uint32_t)pool[record + 1] << 8 |
+      (uint32_t)pool[record + 2] << 16 | (uint32_t)pool[record + 3] << 24;
+}
+
+/**
+ * next - Finds the record after a record.
+ *
+ * Parameter:
+ *    uint8_t record: the offset of the record in pool
+ * Returns:
+ *    uint8_t next: the offset of the next record (used if it was the last)
+ */
+uint8_t CueClass::next(uint8_t record) {
+  return record + CUE_HEADER_LENGTH + pool[record + 5];
+}
+
+CueClass Cue; //Create a public Cue instance
@@ -0,0 +1,77 @@
+/**
+ * DMX-84
+ * Cue queue header
+ *
+ * This file contains the external defines and prototypes for holding
+ * commands until a set time.
+ *
+ * Last modified October 15, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CUE_H
+#define CUE_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <inttypes.h>
+
+/******************************************************************************
+ * External constants
+ ******************************************************************************/
+
+//Bytes kept for waiting commands. Each takes its length plus CUE_HEADER_LENGTH.
+#define CUE_POOL_LENGTH       64
+#define CUE_HEADER_LENGTH     6 //Time (4 bytes), unit, length
+#define CUE_DATA_LENGTH       (CUE_POOL_LENGTH - CUE_HEADER_LENGTH) //Longest
+
+//What a cue's time counts
+#define CUE_MILLISECONDS      0 //millis()
+#define CUE_FRAMES            1 //DmxSimple.frames()
+
+/******************************************************************************
+ * Class definition
+ ******************************************************************************/
+
+/* Holds command packets until a time on the device clock. The queue is kept
+ * in time order (cues in frames and in milliseconds are kept apart, since
+ * they can't be compared), and cues with the same time stay in the order
+ * they were added.
+ */
+class CueClass {
+    public:
+        bool add(uint8_t unit, uint32_t time, const uint8_t *data,
+            uint8_t length);
+        uint8_t take(uint8_t *data);
+        void clear(void);
+        uint8_t waiting(void);
+
+    private:
+        uint32_t timeAt(uint8_t record);
+        uint8_t next(uint8_t record);
+
+        //Records back to back, in time order: time, unit, length, data
+        uint8_t pool[CUE_POOL_LENGTH];
+        uint8_t used;
+};
+
+extern CueClass Cue;
+
+#endif
@@ -0,0 +1,312 @@
+/**
+ * DMX-84
+ * Dimmer curve code
+ *
+ * This file contains the code for the dimmer curves applied to channels as
+ * they are transmitted.
+ *
+ * Curves are set on ranges of channels and applied from the DmxSimple slot
+ * filter, so everything before transmission (commands, fades, effects) works
+ * with linear levels. The built-in curves are lookup tables in PROGMEM that
+ * the compiler fills in. The user curve is kept in EEPROM so it survives a
+ * power cycle, and is read straight from there.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#include <DmxSimple.h>
+
+#include "firmware.h"
+#include "curve.h"
+
+/******************************************************************************
+ * Internal constants
+ ******************************************************************************/
+
+#define CURVE_TABLE_LENGTH    256
+
+//Spacing of the cached user curve points
+#define USER_POINT_SHIFT      4
+
+/* Compile-time curve formulas. Each maps a level 0-255 to a level 0-255. */
+static constexpr long isqrt(long n, long lo, long hi) {
+  return lo == hi ? lo :
+      ((lo + hi + 1) / 2) * ((lo + hi + 1) / 2) <= n ?
+          isqrt(n, (lo + hi + 1) / 2, hi) : isqrt(n, lo, (lo + hi + 1) / 2 - 1);
+}
+
+static constexpr uint8_t squareLaw(long x) {
+  return (x * x + 127) / 255;
+}
+
+static constexpr uint8_t inverseSquareLaw(long x) {
+  return (isqrt(4 * 255 * x, 0, 1021) + 1) / 2; //round(sqrt(255 x))
+}
+
+static constexpr uint8_t smoothstep(long x) {
+  return (x * x * (3 * 255 - 2 * x) + 65025 / 2) / 65025;
+}
+
+#define REPEAT_8(f, x)        f(x), f(x + 1), f(x + 2), f(x + 3), \
+                              f(x + 4), f(x + 5), f(x + 6), f(x + 7)
+#define REPEAT_64(f, x)       REPEAT_8(f, x), REPEAT_8(f, x + 8), \
+                              REPEAT_8(f, x + 16), REPEAT_8(f, x + 24), \
+                              REPEAT_8(f, x + 32), REPEAT_8(f, x + 40), \
+                              REPEAT_8(f, x + 48), REPEAT_8(f, x + 56)
+#define REPEAT_256(f)         REPEAT_64(f, 0), REPEAT_64(f, 64), \
+                              REPEAT_64(f, 128), REPEAT_64(f, 192)
+
+static const uint8_t squareTable[CURVE_TABLE_LENGTH] PROGMEM = {
+  REPEAT_256(squareLaw)
+};
+
+static const uint8_t inverseSquareTable[CURVE_TABLE_LENGTH] PROGMEM = {
+  REPEAT_256(inverseSquareLaw)
+};
+
+static const uint8_t sTable[CURVE_TABLE_LENGTH] PROGMEM = {
+  REPEAT_256(smoothstep)
+};
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**
+ * begin - Loads the user curve points. Call once at power up.
+ */
+void CurveClass::begin(void) {
+  rangeCount = 0;
+  cursor = 0;
+  lastSlot = 0;
+  cacheUserPoints();
+}
+
+/**
+ * set - Gives a range of channels a curve.
+ *
+ * Parameters:
+ *    uint16_t first: the first channel
+ *    uint16_t count: the number of channels
+ *    uint8_t curve: CURVE_* (CURVE_LINEAR removes any curve)
+ *    uint8_t param: the threshold for CURVE_SWITCHED, otherwise unused
+ * Returns:
+ *    bool set: false if the range is invalid or it would take more than
+ *              CURVE_RANGES ranges (nothing is changed then)
+ *
+ * Replaces the curve of any channels in the range that already had one.
+ */
+bool CurveClass::set(uint16_t first, uint16_t count, uint8_t curve,
+    uint8_t param) {
+  if (first >= DMX_SIZE || count == 0 || count > DMX_SIZE - first ||
+      curve > CURVE_SWITCHED) {
+    return false;
+  }
+  uint16_t end = first + count;
+
+  //Cut the new range out of the old ones. A range can split in two.
+  Range updated[CURVE_RANGES + 2];
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < rangeCount; i++) {
+    Range r = ranges[i];
+    if (r.end <= first || r.first >= end) {
+      updated[n++] = r;
+    } else {
+      if (r.first < first) {
+        updated[n] = r;
+        updated[n++].end = first;
+      }
+      if (r.end > end) {
+        updated[n] = r;
+        updated[n++].first = end;
+      }
+    }
+    if (n > CURVE_RANGES) {
+      return false;
+    }
+  }
+  if (curve != CURVE_LINEAR) {
+    //Insert in order
+    uint8_t i = n;
+    while (i > 0 && updated[i - 1].first > first) {
+      updated[i] = updated[i - 1];
+      i--;
+    }
+    updated[i].first = first;
+    updated[i].end = end;
+    updated[i].curve = curve;
+    updated[i].param = param;
+    n++;
+  }
+  if (n > CURVE_RANGES) {
+    return false;
+  }
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    for (uint8_t i = 0; i < n; i++) {
+      ranges[i] = updated[i];
+    }
+    rangeCount = n;
+    cursor = 0;
+  }
+  return true;
+}
+
+/**
+ * clear - Makes every channel linear again.
+ */
+void CurveClass::clear(void) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    rangeCount = 0;
+    cursor = 0;
+  }
+}
+
+/**
+ * setUserTable - Writes part of the user curve to EEPROM.
+ *
+ * Parameters:
+ *    uint8_t offset: the first input level to set
+ *    const uint8_t *levels: the output levels
+ *    uint16_t length: the number of levels (cut off at the end of the table)
+ *
+ * Writing EEPROM takes about 3.3 ms per changed byte.
+ */
+void CurveClass::setUserTable(uint8_t offset, const uint8_t *levels,
+    uint16_t length) {
+  if (length > CURVE_TABLE_LENGTH - offset) {
+    length = CURVE_TABLE_LENGTH - offset;
+  }
+  eeprom_update_block(levels,
+      (void *)(uintptr_t)(CURVE_EEPROM_START + offset), length);
+  cacheUserPoints();
+}
+
+/**
+ * apply - Puts a level through the curve of its channel.
+ *
+ * Parameters:
+ *    uint16_t slot: the channel index (0-511)
+ *    uint8_t level: the linear level
+ * Returns:
+ *    uint8_t level: the level to transmit
+ *
+ * Called from the DMX transmit interrupt for every slot. Slots come in order,
+ * so the range lookup just walks forward and costs the same for every slot.
+ * The time taken, a user curve's EEPROM read included, is counted against
+ * the bit-banged transmitter's budget like the rest of the slot filter.
+ */
+uint8_t CurveClass::apply(uint16_t slot, uint8_t level) {
+  if (slot < lastSlot) {
+    cursor = 0; //New frame
+  }
+  lastSlot = slot;
+  while (cursor < rangeCount && slot >= ranges[cursor].end) {
+    cursor++;
+  }
+  if (cursor == rangeCount || slot < ranges[cursor].first) {
+    return level; //Linear
+  }
+
+  switch (ranges[cursor].curve) {
+    case CURVE_SQUARE: {
+      return pgm_read_byte(&squareTable[level]);
+    }
+
+    case CURVE_INVERSE_SQUARE: {
+      return pgm_read_byte(&inverseSquareTable[level]);
+    }
+
+    case CURVE_S: {
+      return pgm_read_byte(&sTable[level]);
+    }
+
+    case CURVE_USER: {
+      return userLevel(level);
+    }
+
+    case CURVE_SWITCHED: {
+      return level >= ranges[cursor].param ? 0xFF : 0;
+    }
+
+    default: {
+      return level;
+    }
+  }
+}
+
+/**
+ * userLevel - Looks up a level in the user curve.
+ *
+ * Parameter:
+ *    uint8_t level: the linear level
+ * Returns:
+ *    uint8_t level: the curved level
+ *
+ * Reads the EEPROM registers directly, since this runs in the transmit
+ * interrupt. The main loop may be partway through its own EEPROM access, so
+ * the address and data registers are put back afterwards. While an EEPROM
+ * write is in progress nothing can be read, so the level is interpolated from
+ * the cached points instead.
+ */
+uint8_t CurveClass::userLevel(uint8_t level) {
+  if (EECR & _BV(EEPE)) {
+    uint8_t i = level >> USER_POINT_SHIFT;
+    uint8_t fraction = level & ((1 << USER_POINT_SHIFT) - 1);
+    int16_t step = userPoints[i + 1] - userPoints[i];
+    return userPoints[i] + ((step * fraction) >> USER_POINT_SHIFT);
+  }
+
+  uint16_t address = EEAR;
+  uint8_t data = EEDR;
+  EEAR = CURVE_EEPROM_START + level;
+  EECR |= _BV(EERE);
+  uint8_t curved = EEDR;
+  EEAR = address;
+  EEDR = data;
+  return curved;
+}
+
+/**
+ * cacheUserPoints - Copies every 16th user curve entry (and the last) to RAM.
+ */
+void CurveClass::cacheUserPoints(void) {
+  uint8_t points[sizeof(userPoints)];
+  for (uint8_t i = 0; i < sizeof(userPoints) - 1; i++) {
+    uint16_t address = CURVE_EEPROM_START + (i << USER_POINT_SHIFT);
+    points[i] = eeprom_read_byte((const uint8_t *)(uintptr_t)address);
+  }
+  points[sizeof(userPoints) - 1] = eeprom_read_byte(
+      (const uint8_t *)(CURVE_EEPROM_START + CURVE_TABLE_LENGTH - 1));
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    for (uint8_t i = 0; i < sizeof(userPoints); i++) {
+      userPoints[i] = points[i];
+    }
+  }
+}
+
+CurveClass Curve;
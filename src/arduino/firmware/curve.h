@@ -0,0 +1,90 @@
+/**
+ * DMX-84
+ * Dimmer curve header
+ *
+ * This file contains the external defines and prototypes for the dimmer
+ * curves applied to channels as they are transmitted.
+ *
+ * Last modified October 15, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CURVE_H
+#define CURVE_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <inttypes.h>
+
+/******************************************************************************
+ * External constants
+ ******************************************************************************/
+
+//Curves
+#define CURVE_LINEAR          0
+#define CURVE_SQUARE          1 //Square law
+#define CURVE_INVERSE_SQUARE  2
+#define CURVE_S               3 //Smoothstep
+#define CURVE_USER            4 //256-entry table uploaded with 0x81
+#define CURVE_SWITCHED        5 //Full at or above param, else off (non-dim)
+
+//Number of channel ranges that can have a curve other than linear
+#define CURVE_RANGES          8
+
+/******************************************************************************
+ * Class definition
+ ******************************************************************************/
+
+class CurveClass {
+    public:
+        void begin(void);
+        bool set(uint16_t first, uint16_t count, uint8_t curve,
+            uint8_t param = 0);
+        void clear(void);
+        void setUserTable(uint8_t offset, const uint8_t *levels,
+            uint16_t length);
+        uint8_t apply(uint16_t slot, uint8_t level);
+
+    private:
+        uint8_t userLevel(uint8_t level);
+        void cacheUserPoints(void);
+
+        //Sorted, non-overlapping ranges [first, end)
+        struct Range {
+            uint16_t first;
+            uint16_t end;
+            uint8_t curve;
+            uint8_t param;
+        };
+
+        Range ranges[CURVE_RANGES];
+        uint8_t rangeCount;
+
+        //Where apply() is in the ranges; slots come in order every frame
+        uint8_t cursor;
+        uint16_t lastSlot;
+
+        //Every 16th entry of the user table, for while the EEPROM is busy
+        uint8_t userPoints[17];
+};
+
+extern CurveClass Curve;
+
+#endif
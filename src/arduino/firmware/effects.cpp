@@ -0,0 +1,337 @@
+/**
+ * DMX-84
+ * Effects engine code
+ *
+ * This file contains the code for running waveform effects and chases on
+ * ranges of channels.
+ *
+ * Effects are applied to each channel as it is transmitted, like the masters
+ * and curves, so dmxOutput keeps the look as of the last commit (and fade).
+ * Each effect channel is sent as its dmxOutput level plus the waveform scaled
+ * by the effect depth, so the look underneath sets the floor, and a channel
+ * goes back to that level as soon as its effect stops. A channel used by more
+ * than one effect gets the last one. Phases move on, and effects start, change
+ * and stop, only in the frame callback, so a whole frame is sent with the
+ * same ones.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#include <DmxSimple.h>
+
+#include "effects.h"
+
+/******************************************************************************
+ * Internal constants
+ ******************************************************************************/
+
+/* Half a sine cycle in 128 steps, 0-127, worked out by the compiler with
+ * Bhaskara's approximation sin(pi t) ~ 16t(1-t) / (5 - 4t(1-t)), t = x/128.
+ * (Within about 1 step of the real thing.)
+ */
+#define BHASKARA_TERM(x)      (4L * (x) * (128 - (x)))
+#define SINE_ENTRY(x)         ((127L * 4 * BHASKARA_TERM(x) + \
+                                (5L * 16384 - BHASKARA_TERM(x)) / 2) / \
+                               (5L * 16384 - BHASKARA_TERM(x)))
+#define SINE_8(x)             SINE_ENTRY(x), SINE_ENTRY(x + 1), \
+                              SINE_ENTRY(x + 2), SINE_ENTRY(x + 3), \
+                              SINE_ENTRY(x + 4), SINE_ENTRY(x + 5), \
+                              SINE_ENTRY(x + 6), SINE_ENTRY(x + 7)
+#define SINE_32(x)            SINE_8(x), SINE_8(x + 8), SINE_8(x + 16), \
+                              SINE_8(x + 24)
+
+static const uint8_t halfSine[128] PROGMEM = {
+  SINE_32(0), SINE_32(32), SINE_32(64), SINE_32(96)
+};
+
+//rate is in hundredths of a cycle per second; phase has 65536 steps a cycle.
+//65536 / 100000 per millisecond is about 671 / 1024.
+#define RATE_SCALE            671
+#define RATE_SHIFT            10
+
+//Longest gap between frames that is counted (keeps the math in 32 bits)
+#define MAX_FRAME_TIME        50
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**
+ * begin - Stops every effect. Call once at power up.
+ */
+void EffectsClass::begin(void) {
+  running = 0;
+  wanted = 0;
+  changeSlot = EFFECT_COUNT;
+  lastFrame = millis();
+}
+
+/**
+ * set - Starts, changes or stops an effect from the next frame.
+ *
+ * Parameters:
+ *    uint8_t slot: which effect (0 to EFFECT_COUNT - 1)
+ *    uint8_t waveform: EFFECT_* (EFFECT_OFF stops it)
+ *    uint16_t first: the first channel
+ *    uint16_t count: the number of channels
+ *    uint16_t rate: speed in hundredths of a cycle per second
+ *    uint16_t spread: phase offset between neighboring channels, in
+ *                     1/65536ths of a cycle
+ *    uint8_t depth: how far above the base level the effect reaches
+ *    uint8_t param: waveform-specific (see effects.h)
+ * Returns:
+ *    bool valid: false if the slot or channels are out of range
+ *
+ * Changing a running effect keeps its phase, so it doesn't jump. apply() is
+ * still reading a running effect until the frame ends, so the change waits in
+ * change for frame() to make. There is room for one: if another running
+ * effect is changed in the same frame, the first change is made at once.
+ */
+bool EffectsClass::set(uint8_t slot, uint8_t waveform, uint16_t first,
+    uint16_t count, uint16_t rate, uint16_t spread, uint8_t depth,
+    uint8_t param) {
+  if (slot >= EFFECT_COUNT || first >= DMX_SIZE || count > DMX_SIZE - first) {
+    return false;
+  }
+  if (waveform == EFFECT_OFF) {
+    stop(slot);
+    return true;
+  }
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    Settings *e = &effects[slot];
+    if (running & _BV(slot)) {
+      if (changeSlot != EFFECT_COUNT && changeSlot != slot) {
+        (Settings &)effects[changeSlot] = change;
+      }
+      changeSlot = slot;
+      e = &change;
+    } else {
+      effects[slot].phase = 0;
+    }
+    e->waveform = waveform;
+    e->param = param;
+    e->depth = depth;
+    e->first = first;
+    e->count = count;
+    e->rate = rate;
+    e->spread = spread;
+    wanted |= _BV(slot);
+  }
+  return true;
+}
+
+/**
+ * stop - Stops an effect from the next frame. Its channels go back to their
+ * dmxOutput levels.
+ *
+ * Parameter:
+ *    uint8_t slot: which effect
+ */
+void EffectsClass::stop(uint8_t slot) {
+  if (slot >= EFFECT_COUNT) {
+    return;
+  }
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    wanted &= ~_BV(slot);
+    if (changeSlot == slot) {
+      changeSlot = EFFECT_COUNT;
+    }
+  }
+}
+
+/**
+ * stopAll - Stops every effect from the next frame.
+ */
+void EffectsClass::stopAll(void) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    wanted = 0;
+    changeSlot = EFFECT_COUNT;
+  }
+}
+
+/**
+ * frame - Makes the changes set() and stop() asked for and advances every
+ * running effect.
+ *
+ * Called from the DMX frame callback.
+ */
+void EffectsClass::frame(void) {
+  uint32_t now = millis();
+  uint32_t elapsed = now - lastFrame;
+  lastFrame = now;
+  if (elapsed > MAX_FRAME_TIME) {
+    elapsed = MAX_FRAME_TIME;
+  }
+
+  for (uint8_t slot = 0; slot < EFFECT_COUNT; slot++) {
+    if (running & _BV(slot)) {
+      Effect &e = effects[slot];
+      e.phase += (elapsed * e.rate * RATE_SCALE) >> RATE_SHIFT;
+    }
+  }
+  if (changeSlot != EFFECT_COUNT) {
+    (Settings &)effects[changeSlot] = change; //Keeping the phase
+    changeSlot = EFFECT_COUNT;
+  }
+  running = wanted;
+
+  //The next frame starts at each effect's first channel
+  for (uint8_t slot = 0; slot < EFFECT_COUNT; slot++) {
+    Effect &e = effects[slot];
+    e.next = 0;
+    e.at = e.phase;
+    e.step = 0;
+  }
+}
+
+/**
+ * apply - Adds the running effects to a channel's level.
+ *
+ * Parameters:
+ *    uint16_t slot: the channel index (0-511)
+ *    uint8_t base: the channel's level in dmxOutput
+ * Returns:
+ *    uint8_t level: the level with the effects on it
+ *
+ * Called from the DMX transmit interrupt for every slot. Slots come in order,
+ * so each effect's phase and chase step just move on by one channel, with
+ * no multiply or divide. After a slot that was skipped (a frame cut short,
+ * or sent without the frame callback) seek() finds the place again.
+ */
+uint8_t EffectsClass::apply(uint16_t slot, uint8_t base) {
+  uint8_t active = running;
+  if (!active) {
+    return base;
+  }
+  uint8_t result = base;
+  Effect *e = effects;
+  for (uint8_t bit = 1; bit < _BV(EFFECT_COUNT); bit <<= 1, e++) {
+    if (!(active & bit)) {
+      continue;
+    }
+    uint16_t channel = slot - e->first; //Wraps if slot is below the effect
+    if (channel >= e->count) {
+      continue;
+    }
+    if (channel != e->next) {
+      seek(*e, channel);
+    }
+    uint16_t wave = level(e->waveform, e->param, e->at, channel, e->step);
+    uint16_t value = base + ((wave * (e->depth + 1)) >> 8);
+    result = value > 0xFF ? 0xFF : value;
+
+    e->next++;
+    e->at += e->spread;
+    if (++e->step >= e->param) {
+      e->step = 0;
+    }
+  }
+  return result;
+}
+
+/**
+ * seek - Moves an effect's place in its channels, for apply().
+ *
+ * Parameters:
+ *    Effect &e: the effect
+ *    uint16_t channel: index of the channel apply() is on
+ */
+void EffectsClass::seek(Effect &e, uint16_t channel) {
+  e.next = channel;
+  e.at = e.phase + (uint32_t)channel * e.spread;
+  e.step = e.param ? channel % e.param : 0;
+}
+
+/**
+ * top - Works out how many channels the running effects reach, so auto-trim
+ * doesn't cut them off where the levels underneath are 0.
+ *
+ * Returns:
+ *    uint16_t channels: one past the highest channel of any running effect
+ *                       (0 if none are running)
+ */
+uint16_t EffectsClass::top(void) {
+  uint16_t channels = 0;
+  for (uint8_t i = 0; i < EFFECT_COUNT; i++) {
+    if ((running & _BV(i)) && effects[i].depth &&
+        effects[i].first + effects[i].count > channels) {
+      channels = effects[i].first + effects[i].count;
+    }
+  }
+  return channels;
+}
+
+/**
+ * level - Works out a waveform's level at a point in its cycle.
+ *
+ * Parameters:
+ *    uint8_t waveform: EFFECT_*
+ *    uint8_t param: waveform-specific (see effects.h)
+ *    uint32_t phase: cycles in the top 16 bits, position in the low 16
+ *    uint16_t channel: index of the channel within the effect
+ *    uint8_t step: the channel's index within its chase group
+ * Returns:
+ *    uint8_t level: 0-255
+ */
+uint8_t EffectsClass::level(uint8_t waveform, uint8_t param, uint32_t phase,
+    uint16_t channel, uint8_t step) {
+  uint8_t position = (phase >> 8) & 0xFF;
+  switch (waveform) {
+    case EFFECT_SINE: {
+      uint8_t half = pgm_read_byte(&halfSine[position & 0x7F]);
+      return (position & 0x80) ? 128 - half : 128 + half;
+    }
+
+    case EFFECT_RAMP: {
+      return position;
+    }
+
+    case EFFECT_SQUARE: {
+      return position < param ? 0xFF : 0;
+    }
+
+    case EFFECT_RANDOM: {
+      //Hash the cycle number and channel so each gets its own level per cycle
+      uint16_t x = (phase >> 16) * 0x9E37 + channel * 0x79B9;
+      x ^= x >> 7;
+      x *= 0x2F6B;
+      return x >> 8;
+    }
+
+    case EFFECT_CHASE: {
+      //Channel n of every group of param is on during step n
+      uint8_t steps = param ? param : 1;
+      return step == ((position * steps) >> 8) ? 0xFF : 0;
+    }
+
+    default: {
+      return 0;
+    }
+  }
+}
+
+EffectsClass Effects;
@@ -0,0 +1,107 @@
+/**
+ * DMX-84
+ * Effects engine header
+ *
+ * This file contains the external defines and prototypes for running
+ * waveform effects and chases on ranges of channels.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <inttypes.h>
+
+/******************************************************************************
+ * External constants
+ ******************************************************************************/
+
+//Number of effects that can run at once
+#define EFFECT_COUNT          4
+
+//Waveforms
+#define EFFECT_OFF            0
+#define EFFECT_SINE           1
+#define EFFECT_RAMP           2
+#define EFFECT_SQUARE         3 //param = duty cycle (0-255); short = strobe
+#define EFFECT_RANDOM         4 //New random level every cycle
+#define EFFECT_CHASE          5 //param = number of steps
+
+/******************************************************************************
+ * Class definition
+ ******************************************************************************/
+
+class EffectsClass {
+    public:
+        void begin(void);
+        bool set(uint8_t slot, uint8_t waveform, uint16_t first,
+            uint16_t count, uint16_t rate, uint16_t spread, uint8_t depth,
+            uint8_t param);
+        void stop(uint8_t slot);
+        void stopAll(void);
+        void frame(void);
+        uint8_t apply(uint16_t slot, uint8_t base);
+        uint16_t top(void);
+
+    private:
+        uint8_t level(uint8_t waveform, uint8_t param, uint32_t phase,
+            uint16_t channel, uint8_t step);
+
+        struct Settings {
+            uint8_t waveform;
+            uint8_t param;
+            uint8_t depth;
+            uint16_t first;
+            uint16_t count;
+            uint16_t rate; //Hundredths of a cycle per second
+            uint16_t spread; //Phase offset per channel (1/65536 cycle)
+        };
+
+        struct Effect : Settings {
+            uint32_t phase; //Cycles in the top 16 bits, position in the low
+
+            //Where apply() is in the effect's channels; slots come in order
+            //every frame, so each channel's phase is the last one's plus
+            //spread
+            uint16_t next; //Channel index apply() expects next
+            uint32_t at; //Its phase
+            uint8_t step; //Its index within a chase group
+        };
+
+        void seek(Effect &e, uint16_t channel);
+
+        Effect effects[EFFECT_COUNT];
+        volatile uint8_t running; //Effects apply() uses this frame (bitmap)
+        volatile uint8_t wanted; //Effects to run from the next frame
+
+        //A change to a running effect, made at the next frame (see set())
+        Settings change;
+        volatile uint8_t changeSlot; //EFFECT_COUNT if none
+
+        uint32_t lastFrame; //millis() at the last frame
+};
+
+extern EffectsClass Effects;
+
+#endif
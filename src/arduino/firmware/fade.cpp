@@ -0,0 +1,264 @@
+/**
+ * DMX-84
+ * Crossfade engine code
+ *
+ * This file contains the code for fading the transmitted universe (dmxOutput)
+ * to the contents of dmxBuffer.
+ *
+ * The fade runs from the DmxSimple frame callback, once per frame. Rather than
+ * keeping a copy of the starting look, each frame moves every channel the
+ * right fraction of its remaining distance to the target, so the fade needs no
+ * memory per channel and follows changes made to dmxBuffer while it runs.
+ * Channels going up use the up time and delay, channels going down use the
+ * down time and delay.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include <util/atomic.h>
+#include <DmxSimple.h>
+
+#include "fade.h"
+
+/******************************************************************************
+ * Internal constants
+ ******************************************************************************/
+
+//Fade times are given in tenths of a second
+#define MILLISECONDS_PER_TIME_UNIT  100
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**
+ * start - Starts fading the output to the contents of dmxBuffer.
+ *
+ * Parameters:
+ *    uint16_t upTime: tenths of a second for rising channels to arrive
+ *    uint16_t downTime: tenths of a second for falling channels to arrive
+ *    uint16_t upDelay: tenths of a second before rising channels start
+ *    uint16_t downDelay: tenths of a second before falling channels start
+ *
+ * Replaces any fade in progress, starting from the current output.
+ */
+void FadeClass::start(uint16_t upTime, uint16_t downTime,
+    uint16_t upDelay, uint16_t downDelay) {
+  uint16_t from, to;
+  span(&from, &to);
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    first = from;
+    last = to;
+    this->upTime = (uint32_t)upTime * MILLISECONDS_PER_TIME_UNIT;
+    this->downTime = (uint32_t)downTime * MILLISECONDS_PER_TIME_UNIT;
+    this->upDelay = (uint32_t)upDelay * MILLISECONDS_PER_TIME_UNIT;
+    this->downDelay = (uint32_t)downDelay * MILLISECONDS_PER_TIME_UNIT;
+    upDone = 0;
+    downDone = 0;
+    if (!dither) {
+      dither = 0xACE1; //Any nonzero LFSR seed
+    }
+    startTime = millis();
+    fading = true;
+  }
+}
+
+/**
+ * stop - Stops the fade, holding the output where it is.
+ */
+void FadeClass::stop(void) {
+  fading = false;
+}
+
+/**
+ * follow - Takes in channels whose target changed while the fade runs. Call
+ * after changing dmxBuffer, from the main loop.
+ */
+void FadeClass::follow(void) {
+  if (!fading) {
+    return;
+  }
+  uint16_t from, to;
+  span(&from, &to);
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (from < first) {
+      first = from;
+    }
+    if (to > last) {
+      last = to;
+    }
+  }
+}
+
+/**
+ * active - Tests whether a fade is running.
+ *
+ * Returns:
+ *    bool fading: true until both directions have arrived
+ */
+bool FadeClass::active(void) {
+  return fading;
+}
+
+/**
+ * upProgress - Gets the progress of the rising channels.
+ *
+ * Returns:
+ *    uint8_t progress: 0 (not started) to 255 (arrived)
+ */
+uint8_t FadeClass::upProgress(void) {
+  uint32_t done;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    done = upDone;
+  }
+  return fading ? (done * 255) >> 16 : 255;
+}
+
+/**
+ * downProgress - Gets the progress of the falling channels.
+ *
+ * Returns:
+ *    uint8_t progress: 0 (not started) to 255 (arrived)
+ */
+uint8_t FadeClass::downProgress(void) {
+  uint32_t done;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    done = downDone;
+  }
+  return fading ? (done * 255) >> 16 : 255;
+}
+
+/**
+ * frame - Moves every channel that isn't at its target one frame closer.
+ *
+ * Called from the DMX frame callback. Only the channels from first to last
+ * are looked at, and those narrow to the ones still moving, so a fade of a
+ * few channels doesn't hold the interrupt up for all 512.
+ */
+void FadeClass::frame(void) {
+  if (!fading) {
+    return;
+  }
+
+  uint32_t elapsed = millis() - startTime;
+  uint32_t upFraction = fraction(elapsed, upDelay, upTime, upDone);
+  uint32_t downFraction = fraction(elapsed, downDelay, downTime, downDone);
+
+  uint16_t from = DMX_SIZE, to = 0; //Channels still moving after this frame
+  for (uint16_t i = first; i < last; i++) {
+    uint8_t current = dmxOutput[i];
+    uint8_t target = dmxBuffer[i];
+    if (current == target) {
+      continue;
+    }
+
+    bool rising = target > current;
+    uint8_t distance = rising ? target - current : current - target;
+    uint32_t f = rising ? upFraction : downFraction;
+
+    uint8_t step;
+    if (f == FADE_COMPLETE) {
+      step = distance;
+    } else {
+      //Q8.8 step; dither the fractional part so small steps average out right
+      uint16_t exact = ((uint32_t)distance * f) >> 8;
+      dither = (dither >> 1) ^ (-(dither & 1) & 0xB400); //Galois LFSR
+      step = (exact >> 8) + ((exact & 0xFF) > (dither & 0xFF) ? 1 : 0);
+    }
+
+    dmxOutput[i] = rising ? current + step : current - step;
+    if (step != distance) {
+      if (from == DMX_SIZE) {
+        from = i;
+      }
+      to = i + 1;
+    }
+  }
+  first = from;
+  last = to;
+
+  if (upDone == FADE_COMPLETE && downDone == FADE_COMPLETE) {
+    fading = false;
+  }
+}
+
+/**
+ * fraction - Works out how much of the remaining distance to cover this frame.
+ *
+ * Parameters:
+ *    uint32_t elapsed: milliseconds since the fade started
+ *    uint32_t delay: milliseconds before this direction starts moving
+ *    uint32_t time: milliseconds this direction takes once it starts
+ *    volatile uint32_t &done: Q0.16 progress as of the last frame (updated)
+ * Returns:
+ *    uint32_t fraction: Q0.16 fraction of the remaining distance to move
+ */
+uint32_t FadeClass::fraction(uint32_t elapsed, uint32_t delay, uint32_t time,
+    volatile uint32_t &done) {
+  if (elapsed < delay) {
+    return 0;
+  }
+  elapsed -= delay;
+  while (time > 0xFFFF) {
+    //Keep elapsed << 16 from overflowing on long fades
+    time >>= 1;
+    elapsed >>= 1;
+  }
+
+  uint32_t progress = elapsed >= time ? FADE_COMPLETE :
+      (elapsed << 16) / time;
+  if (progress == FADE_COMPLETE) {
+    done = FADE_COMPLETE;
+    return FADE_COMPLETE;
+  }
+  if (progress <= done) {
+    return 0;
+  }
+
+  uint32_t f = ((progress - done) << 16) / (FADE_COMPLETE - done);
+  done = progress;
+  return f;
+}
+
+/**
+ * span - Finds the channels whose output isn't at its target.
+ *
+ * Parameters:
+ *    uint16_t *from: set to the first (DMX_SIZE if none)
+ *    uint16_t *to: set to one past the last (0 if none)
+ */
+void FadeClass::span(uint16_t *from, uint16_t *to) {
+  uint16_t i = 0;
+  while (i < DMX_SIZE && dmxOutput[i] == dmxBuffer[i]) {
+    i++;
+  }
+  *from = i;
+  uint16_t j = DMX_SIZE;
+  while (j > i && dmxOutput[j - 1] == dmxBuffer[j - 1]) {
+    j--;
+  }
+  *to = i < DMX_SIZE ? j : 0;
+}
+
+FadeClass Fade; //Create a public Fade instance
@@ -0,0 +1,83 @@
+/**
+ * DMX-84
+ * Crossfade engine header
+ *
+ * This file contains the external defines and prototypes for fading the
+ * transmitted universe to the contents of dmxBuffer.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FADE_H
+#define FADE_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <inttypes.h>
+
+/******************************************************************************
+ * External constants
+ ******************************************************************************/
+
+//Fade progress is a Q0.16 fraction; this is "all the way"
+#define FADE_COMPLETE         0x10000UL
+
+/******************************************************************************
+ * Class definition
+ ******************************************************************************/
+
+class FadeClass {
+    public:
+        void start(uint16_t upTime, uint16_t downTime,
+            uint16_t upDelay = 0, uint16_t downDelay = 0);
+        void stop(void);
+        void follow(void);
+        bool active(void);
+        uint8_t upProgress(void);
+        uint8_t downProgress(void);
+        void frame(void);
+
+    private:
+        uint32_t fraction(uint32_t elapsed, uint32_t delay, uint32_t time,
+            volatile uint32_t &done);
+        void span(uint16_t *from, uint16_t *to);
+
+        volatile bool fading;
+        uint32_t startTime;
+        uint32_t upTime;
+        uint32_t downTime;
+        uint32_t upDelay;
+        uint32_t downDelay;
+
+        //The channels that may still be moving (first to last - 1)
+        uint16_t first;
+        uint16_t last;
+
+        //Q0.16 progress reached by the last frame in each direction
+        volatile uint32_t upDone;
+        volatile uint32_t downDone;
+
+        uint16_t dither;
+};
+
+extern FadeClass Fade;
+
+#endif
@@ -0,0 +1,127 @@
+/**
+ * DMX-84
+ * Fast pin access header
+ *
+ * This file contains a template for accessing a digital pin through its
+ * PORT/PIN/DDR registers. The pin number is resolved at compile time, so each
+ * access compiles down to a single sbi/cbi/sbis instruction instead of a call
+ * to digitalRead/digitalWrite/pinMode.
+ *
+ * Last modified October 15, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FASTPIN_H
+#define FASTPIN_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "Arduino.h"
+
+/******************************************************************************
+ * Class definition
+ ******************************************************************************/
+
+#if defined(__AVR_ATmega168__) || defined(__AVR_ATmega168P__) || defined(__AVR_ATmega328P__)
+
+/* Arduino pin numbering on the 168/328P:
+ *    0-7   = PORTD bits 0-7
+ *    8-13  = PORTB bits 0-5
+ *    14-19 = PORTC bits 0-5 (A0-A5)
+ * Since pin is a template parameter, the conditionals below are folded away
+ * by the compiler and only the register access remains.
+ */
+template <uint8_t pin>
+class FastPin {
+    public:
+        static inline bool read(void) {
+          return (pinReg() & mask()) ? true : false;
+        }
+
+        static inline void high(void) {
+          portReg() |= mask();
+        }
+
+        static inline void low(void) {
+          portReg() &= ~mask();
+        }
+
+        //Drives the pin low (open collector "pull")
+        static inline void pull(void) {
+          portReg() &= ~mask();
+          ddrReg() |= mask();
+        }
+
+        //Makes the pin an input with the pullup enabled
+        static inline void release(void) {
+          ddrReg() &= ~mask();
+          portReg() |= mask();
+        }
+
+    private:
+        static inline uint8_t mask(void) {
+          return _BV(pin < 8 ? pin : (pin < 14 ? pin - 8 : pin - 14));
+        }
+
+        static inline volatile uint8_t &portReg(void) {
+          return pin < 8 ? PORTD : (pin < 14 ? PORTB : PORTC);
+        }
+
+        static inline volatile uint8_t &pinReg(void) {
+          return pin < 8 ? PIND : (pin < 14 ? PINB : PINC);
+        }
+
+        static inline volatile uint8_t &ddrReg(void) {
+          return pin < 8 ? DDRD : (pin < 14 ? DDRB : DDRC);
+        }
+};
+
+#else
+
+//Fallback for other boards: same interface, Arduino core speed.
+template <uint8_t pin>
+class FastPin {
+    public:
+        static inline bool read(void) {
+          return digitalRead(pin) == HIGH;
+        }
+
+        static inline void high(void) {
+          digitalWrite(pin, HIGH);
+        }
+
+        static inline void low(void) {
+          digitalWrite(pin, LOW);
+        }
+
+        static inline void pull(void) {
+          pinMode(pin, OUTPUT);
+          digitalWrite(pin, LOW);
+        }
+
+        static inline void release(void) {
+          pinMode(pin, INPUT);
+          digitalWrite(pin, HIGH);
+        }
+};
+
+#endif
+
+#endif
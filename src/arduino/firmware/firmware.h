@@ -4,7 +4,7 @@
  *
  * This file contains the external defines and prototypes for the main firmware.
  *
- * Last modified November 5, 2014
+ * Last modified October 16, 2026
  *
  *
  * Copyright (C) 2014  Alex Cordonnier
@@ -31,6 +31,9 @@
  ******************************************************************************/
 
 #include "Arduino.h"
+#include <DmxSimple.h>
+
+#include "trace.h"
 
 /******************************************************************************
  * External constants
@@ -38,16 +41,83 @@
 
 //Pins and hardware
 #define LED_PIN               9
-#define DMX_OUT_PIN           10
+#define DMX_OUT_PIN           10 //Ignored if DMX_USE_USART (always TX, pin 1)
 #define TI_RING_PIN           4
 #define TI_TIP_PIN            6
+//#define LINK_PROBE_PIN      16 //A2: high while the link is busy (timing probe)
+
+//EEPROM layout: scenes, then the user dimmer curve in the last 256 bytes
+#define SCENE_EEPROM_START    0
+#define SCENE_EEPROM_END      CURVE_EEPROM_START
+#define CURVE_EEPROM_START    (E2END + 1 - 256)
 
 //Compile-time options:
 //AUTO_SHUT_DOWN_ENABLED > 0 enables auto shutdown.
-//SERIAL_DEBUG_ENABLED > 0 enables serial input and output to a PC.
+//SERIAL_DEBUG_ENABLED > 0 enables serial input and output to a PC, which
+//dmxbridge, cmdbench and tracedump (../../pc) need.
+//SHOW_FEATURES_ENABLED > 0 builds the cue queue, effects, dimmer curves and
+//group masters.
+//TRACE_ENABLED > 0 sends binary trace records (see trace.h) to the PC instead
+//of the text messages, which take far too long to print at SERIAL_SPEED.
+//TRACE_DEFAULT_LEVEL is the trace level at power up (0xF2 changes it).
+//LINK_FAULTS_ENABLED > 0 adds the link fault injection command (0xF7), for
+//testing how the calculator side recovers. Leave it off for shows.
 //LED_MODE_* defines which LED flash pattern to use normally.
+//The DMX output backend is chosen by DMX_USE_USART in DmxSimple.h.
 #define AUTO_SHUT_DOWN_ENABLED      1
+#if DMX_USE_USART
+#undef SERIAL_DEBUG_ENABLED
+#define SERIAL_DEBUG_ENABLED        0 //The USART is busy sending DMX
+#elif !defined(SERIAL_DEBUG_ENABLED)
 #define SERIAL_DEBUG_ENABLED        1
+#endif
+#ifndef SHOW_FEATURES_ENABLED
+#define SHOW_FEATURES_ENABLED       1
+#endif
+#define TRACE_ENABLED               SERIAL_DEBUG_ENABLED
+#define TRACE_DEFAULT_LEVEL         TRACE_COMMANDS
+#ifndef LINK_FAULTS_ENABLED
+#define LINK_FAULTS_ENABLED         0
+#endif
+
+/******************************************************************************
+ * Serial stand-ins
+ ******************************************************************************/
+
+//Swallows whatever is printed to it, so the printing compiles away
+class NullSerialClass {
+    public:
+        void begin(uint32_t) {}
+        void end(void) {}
+        void flush(void) {}
+        int available(void) { return 0; }
+        int availableForWrite(void) { return 0; }
+        int read(void) { return -1; }
+        size_t write(uint8_t) { return 0; }
+        size_t write(const uint8_t *, size_t) { return 0; }
+        size_t println(void) { return 0; }
+        template <typename T> size_t print(T, int = DEC) { return 0; }
+        template <typename T> size_t println(T, int = DEC) { return 0; }
+};
+
+#if !SERIAL_DEBUG_ENABLED
+/* Without serial debugging HardwareSerial must not be linked in: its buffers
+ * take RAM, and with DMX_USE_USART DmxSimple owns the USART interrupts.
+ * Debug output is swallowed by this stand-in instead.
+ */
+static NullSerialClass NullSerial __attribute__((unused));
+#define Serial NullSerial
+#endif
+
+/* Debug is where the text messages go. While tracing, they are dropped and
+ * the trace records take their place.
+ */
+#if TRACE_ENABLED
+static NullSerialClass NullDebug __attribute__((unused));
+#define Debug NullDebug
+#else
+#define Debug Serial
+#endif
 
 /******************************************************************************
  * External function prototypes
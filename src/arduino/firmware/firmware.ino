@@ -5,7 +5,7 @@
  * This file contains the code that processes received commands and generally
  * manages the Arduino.
  *
- * Last modified November 5, 2014
+ * Last modified October 16, 2026
  *
  *
  * Copyright (C) 2014  Alex Cordonnier
@@ -37,6 +37,16 @@
 #include "status.h"
 #include "link.h"
 #include "LED.h"
+#include "fade.h"
+#include "codec.h"
+#include "scene.h"
+#include "effects.h"
+#include "curve.h"
+#include "master.h"
+#include "sink.h"
+#include "scheduler.h"
+#include "telemetry.h"
+#include "cue.h"
 
 /******************************************************************************
  * Internal constants
@@ -45,11 +55,17 @@
 //DMX
 #define MAX_DMX               512
 #define DEFAULT_MAX_CHANNELS  128
+#define READBACK_CHUNK_LENGTH 64 //Token bytes per compressed readback reply
+
+//Batches
+#define BATCH_REPLY_LENGTH    32 //Room for the gathered replies of one batch
 
 //System timeouts (milliseconds)
 #define AUTO_SHUT_DOWN_TIME             21600000 //6 hours
 #define AUTO_SHUT_DOWN_WARN_TIME        (AUTO_SHUT_DOWN_TIME - 60000) //5:59 hrs
 #define RESTRICTED_MODE_TIMEOUT         1000
+#define TIMEOUT_CHECK_PERIOD            100 //How often manageTimeouts() runs
+#define FADE_WAIT_TIMEOUT               2000 //A 0x50 waiting for its look
 
 //Protocol version
 #define PROTOCOL_VERSION_MAJOR          0
@@ -66,8 +82,22 @@
  ******************************************************************************/
 
 static bool setMaxChannel(uint16_t newMaxChannel = DEFAULT_MAX_CHANNELS);
+//Kept out of line so their buffers are only on the stack while they run
+static void runBatch(void) __attribute__((noinline));
+static void sendChannels(uint16_t startChannel) __attribute__((noinline));
+static void sendStats(void) __attribute__((noinline));
+static void sendFrameStats(void) __attribute__((noinline));
 static void startTransmitDMX(void);
 static void stopTransmitDMX(void);
+static void frameDone(void);
+static void blinkLED(void);
+static bool writesEeprom(uint8_t cmd);
+static bool changesChannels(uint8_t cmd);
+#if SHOW_FEATURES_ENABLED
+//Out of line too, so its cue buffer isn't on loop()'s stack all the time
+static void runCues(void) __attribute__((noinline));
+static uint8_t slotFilter(uint16_t slot, uint8_t level);
+#endif
 
 /******************************************************************************
  * Internal global variables
@@ -75,6 +105,13 @@ static void stopTransmitDMX(void);
 
 uint16_t maxChannel;
 
+bool autoCommit = true; //Whether each packet's changes are committed right away
+
+//A fade waiting for the packets that make up its look (see 0x50)
+uint8_t fadePackets = 0; //Channel data packets still to come (0 if none)
+uint16_t fadeTime; //Tenths of a second
+uint32_t fadeWaitTime; //When the 0x50 or the last of its packets came
+
 uint32_t enteredRestrictedMode = 0; //The time that restricted mode was entered
 uint32_t lastCmdReceived = 0; //The time the last command was received
 
@@ -88,26 +125,58 @@ uint32_t lastCmdReceived = 0; //The time the last command was received
  * Note: This function is called once at power up.
  */
 void setup() {
+#if TRACE_ENABLED
+  Trace.level = TRACE_DEFAULT_LEVEL;
+#endif
   Status.reset(); //No flags initially set
 
   //Set up DMX
   DmxSimple.usePin(DMX_OUT_PIN); //Set the pin to transmit DMX on
   startTransmitDMX(); //Enable DMX
   setMaxChannel(DEFAULT_MAX_CHANNELS); //Set the max channels to transmit
+  DmxSimple.onFrame(frameDone); //Per-frame work (fades and effects)
+#if SHOW_FEATURES_ENABLED
+  Curve.begin();
+  Master.begin();
+  Effects.begin();
+  DmxSimple.onSlot(slotFilter); //Per-slot work (effects, masters, curves)
+#endif
 
+  Scene.begin(); //Formats the scene memory on first use
   LED.begin(); //Initialize the LED
   Link.begin(); //Initialize the calculator link
 
-  Serial.println(F("Ready"));
+  //Periodic work
+  Scheduler.begin();
+  Scheduler.add(blinkLED, MILLISECONDS_PER_BLINK, TASK_IN_INTERRUPT);
+  Scheduler.add(manageTimeouts, TIMEOUT_CHECK_PERIOD, TASK_IN_LOOP);
+
+  Debug.println(F("Ready"));
+  TRACE(TRACE_ERRORS, TRACE_EVENT_BOOT);
 }
 
 /**
- * loop - Receives packets and processes the received commands.
+ * loop - Does housekeeping and processes any commands received in the
+ * background.
  *
  * Note: This function is called in a forever loop in main().
  */
 void loop() {
-  uint8_t cmd = Link.receive();
+  Scheduler.run();
+  Link.update();
+#if SHOW_FEATURES_ENABLED
+  runCues();
+#endif
+
+  if (!Link.receive()) {
+#if TRACE_ENABLED
+    Trace.drain(); //Idle, so there is time to send the trace
+#endif
+    return; //Nothing new from the calculator
+  }
+  uint8_t cmd = Link.packetData[0];
+  TRACE(TRACE_COMMANDS, TRACE_EVENT_COMMAND, cmd, Link.packetLength);
+  Telemetry.count(STAT_COMMANDS);
 
   /* We received a command, so remember the timestamp and clear the shutdown 
    * warning status.
@@ -119,7 +188,39 @@ void loop() {
     Status.clear(SENT_SHUT_DOWN_WARNING_STATUS);
   }
 
-  processCommand(cmd);
+  /* Commands change the back buffer. Hold off commits while a packet is being
+   * applied so the next frame boundary never lands halfway through it. The
+   * hold stops the frame callback too, so the long EEPROM writes that leave
+   * the back buffer alone run without it, and fades and effects keep going.
+   */
+  bool fadeWaiting = fadePackets; //Not counting a 0x50 that starts waiting
+  if (Link.packetStreamed) {
+    //The channel data was written to the back buffer as it arrived
+    if (!Link.packetData[1]) {
+      Error.set(INVALID_VALUE_ERROR);
+    }
+  } else if (writesEeprom(cmd)) {
+    processCommand(cmd);
+  } else {
+    DmxSimple.beginWrite();
+    processCommand(cmd);
+    DmxSimple.endWrite();
+  }
+  TRACE(TRACE_COMMANDS, TRACE_EVENT_COMMAND_DONE, cmd);
+  Fade.follow(); //A running fade takes in what changed
+  if (fadeWaiting && fadePackets && changesChannels(cmd) &&
+      (!Link.packetStreamed || Link.packetData[1])) {
+    fadeWaitTime = millis();
+    if (!--fadePackets) {
+      Fade.start(fadeTime, fadeTime); //The whole look is in; fade to it
+    }
+  }
+  if (autoCommit && !Fade.active() && !fadePackets) {
+    //(A running fade already follows the back buffer; a commit would cut it.
+    //One waiting for its look would start from part of it.)
+    DmxSimple.commit();
+  }
+  Status.clear(SERIAL_DIAGNOSTICS_STATUS); //Only set while handling a serial command
 }
 
 /**
@@ -133,7 +234,7 @@ void processCommand(uint8_t cmd) {
     case 0x00: {
       //Heartbeat
       Link.send(&cmd, 1); //Echo the command to acknowledge it
-      Serial.println(F("Heartbeat"));
+      Debug.println(F("Heartbeat"));
       break;
     }
     
@@ -144,9 +245,81 @@ void processCommand(uint8_t cmd) {
       enteredRestrictedMode = millis();
 
       Link.send(&cmd, 1); //Echo the command to acknowledge it
-      Serial.println(F("/!\\ Now in restricted mode"));
+      Debug.println(F("/!\\ Now in restricted mode"));
+      break;
+    }
+    
+    case 0x02: {
+      //Runs a batch of commands, each prefixed by its length
+      //Any replies are gathered into one packet: 0x02, then for each reply
+      //its length and data, in command order.
+      runBatch();
+      break;
+    }
+    
+#if SHOW_FEATURES_ENABLED
+    case 0x03: {
+      //Runs a command at a set time
+      //Unit (0 milliseconds, 1 DMX frames), time (32 bits LSB first, on the
+      //clock 0x04 reads), then the command packet. Commands due together
+      //are committed in the same frame. 0x03 FF drops every waiting command.
+      if (Link.packetLength == 2 && Link.packetData[1] == 0xFF) {
+        Cue.clear();
+        
+        Debug.println(F("Cleared cues"));
+        break;
+      }
+      uint8_t unit = Link.packetData[1];
+      uint8_t inner = Link.packetLength < 7 ? cmd : Link.packetData[6];
+      if (unit > CUE_FRAMES || inner == cmd ||
+          inner == 0x02 || inner == 0xF0 || inner == 0xF1 || inner == 0xF3 ||
+          Link.packetLength - 6 > CUE_DATA_LENGTH) {
+        //No command, a nested cue, a batch, one that would shut down, a
+        //timing run, or too long
+        Error.set(INVALID_VALUE_ERROR);
+        break;
+      }
+      uint32_t time = Link.packetData[2] | (uint32_t)Link.packetData[3] << 8 |
+          (uint32_t)Link.packetData[4] << 16 | (uint32_t)Link.packetData[5] << 24;
+      if (!Cue.add(unit, time, Link.packetData + 6, Link.packetLength - 6)) {
+        Error.set(INVALID_VALUE_ERROR); //No room
+        break;
+      }
+      
+      Debug.print(F("Cued command "));
+      Debug.print(inner, HEX);
+      Debug.print(F(" at "));
+      Debug.print(time);
+      Debug.println(unit == CUE_FRAMES ? F(" frames") : F(" ms"));
+      break;
+    }
+    
+    case 0x04: {
+      //Reply with the device clock: millis() and the DMX frame count (32 bits
+      //each, LSB first), then the number of waiting cues
+      uint32_t now = millis();
+      uint32_t frame = DmxSimple.frames();
+      uint8_t packet[] = {
+        cmd,
+        (uint8_t)(now & 0xFF),
+        (uint8_t)((now & 0xFF00) >> 8),
+        (uint8_t)((now & 0xFF0000) >> 16),
+        (uint8_t)((now & 0xFF000000) >> 24),
+        (uint8_t)(frame & 0xFF),
+        (uint8_t)((frame & 0xFF00) >> 8),
+        (uint8_t)((frame & 0xFF0000) >> 16),
+        (uint8_t)((frame & 0xFF000000) >> 24),
+        Cue.waiting()
+      };
+      Link.send(packet, sizeof(packet));
+      
+      Debug.print(F("Clock: "));
+      Debug.print(now);
+      Debug.print(F(" ms, frame "));
+      Debug.println(frame);
       break;
     }
+#endif
     
     case 0x10:
     case 0x11: {
@@ -155,10 +328,10 @@ void processCommand(uint8_t cmd) {
       uint16_t newValue = Link.packetData[2];
       dmxBuffer[channel] = newValue;
       
-      Serial.print(F("Updated channel "));
-      Serial.print(channel);
-      Serial.print(F(" to "));
-      Serial.println(newValue);
+      Debug.print(F("Updated channel "));
+      Debug.print(channel);
+      Debug.print(F(" to "));
+      Debug.println(newValue);
       break;
     }
     
@@ -170,8 +343,8 @@ void processCommand(uint8_t cmd) {
         dmxBuffer[channel]++;
       }
             
-      Serial.print(F("Incremented channel "));
-      Serial.println(channel);
+      Debug.print(F("Incremented channel "));
+      Debug.println(channel);
       break;
     }
     
@@ -183,8 +356,8 @@ void processCommand(uint8_t cmd) {
         dmxBuffer[channel]--;
       }
       
-      Serial.print(F("Decremented channel "));
-      Serial.println(channel);
+      Debug.print(F("Decremented channel "));
+      Debug.println(channel);
       break;
     }
     
@@ -197,10 +370,10 @@ void processCommand(uint8_t cmd) {
         dmxBuffer[channel] += incrementAmount;
       }
             
-      Serial.print(F("Incremented channel "));
-      Serial.print(channel);
-      Serial.print(F(" by "));
-      Serial.println(incrementAmount);
+      Debug.print(F("Incremented channel "));
+      Debug.print(channel);
+      Debug.print(F(" by "));
+      Debug.println(incrementAmount);
       break;
     }
     
@@ -215,40 +388,39 @@ void processCommand(uint8_t cmd) {
         dmxBuffer[channel] = 0;
       }
             
-      Serial.print(F("Decremented channel "));
-      Serial.print(channel);
-      Serial.print(F(" by "));
-      Serial.println(decrementAmount);
+      Debug.print(F("Decremented channel "));
+      Debug.print(channel);
+      Debug.print(F(" by "));
+      Debug.println(decrementAmount);
       break;
     }
     
     case 0x20:
-    case 0x21: {
-      //Sets 256 channels at once
-      for (uint16_t i = 0; i < 256; i++) {
-        dmxBuffer[i | (cmd & 1) << 8] = Link.packetData[i + 1];
-      }
-      Serial.println(F("Updated 256 channels"));
-      break;
-    }
-    
+    case 0x21:
     case 0x22:
-    case 0x23: {
-      //Sets a block of channels at once
-      uint16_t startChannel = Link.packetData[1] | (Link.packetData[0] & 1) << 8; //The first channel of the block
-      uint8_t length = Link.packetData[2]; //The number of channels to set
-      //Check that the parameters won't go past the end of the universe
-      if (startChannel + length > MAX_DMX) {
-        Error.set(INVALID_VALUE_ERROR);
-        length = MAX_DMX - startChannel; //Don't go above channel 512
+    case 0x23:
+    case 0x27:
+    case 0x2A:
+    case 0x2B:
+    case 0x2C: {
+      //Channel data. Long packets are streamed straight into the universe by
+      //the link instead, through the same sink (see sink.cpp):
+      //0x20/0x21: 256 values for the low or high half of the universe
+      //0x22/0x23: start channel (bit 8 from the command), length, the values
+      //0x27: 512 values
+      //0x2A/0x2B: start channel (16 bits), then a run-length coded stream of
+      //values (0x2A) or XOR patch (0x2B). See codec.h for the format.
+      //0x2C: (channel, value) pairs in groups of up to 8. Each group starts
+      //with a byte holding bit 8 of its channels, bit 0 for its first pair
+      Sink.begin(cmd);
+      for (uint16_t i = 1; i < Link.packetLength; i++) {
+        Sink.write(Link.packetData[i]);
       }
-      for (uint16_t i = startChannel; i < length; i++) {
-        dmxBuffer[i] = Link.packetData[i + 3];
+      if (!Sink.end()) {
+        Error.set(INVALID_VALUE_ERROR);
       }
-      Serial.print(F("Updated channels "));
-      Serial.print(startChannel);
-      Serial.print(F("-"));
-      Serial.println(startChannel + length);
+      
+      Debug.println(F("Updated channels"));
       break;
     }
     
@@ -260,8 +432,8 @@ void processCommand(uint8_t cmd) {
           dmxBuffer[i] += incrementAmount;
         }
       }
-      Serial.print(F("Incremented all channels by "));
-      Serial.println(incrementAmount);
+      Debug.print(F("Incremented all channels by "));
+      Debug.println(incrementAmount);
       break;
     }
     
@@ -275,8 +447,8 @@ void processCommand(uint8_t cmd) {
           dmxBuffer[i] = 0;
         }
       }
-      Serial.print(F("Decremented all channels by "));
-      Serial.println(decrementAmount);
+      Debug.print(F("Decremented all channels by "));
+      Debug.println(decrementAmount);
       break;
     }
     
@@ -286,17 +458,57 @@ void processCommand(uint8_t cmd) {
       for (uint16_t i = 0; i < 512; i++) {
         dmxBuffer[i] = newValue; //Set each channel to the new value
       }
-      Serial.print(F("Set all channels to "));
-      Serial.println(newValue);
+      Debug.print(F("Set all channels to "));
+      Debug.println(newValue);
       break;
     }
     
-    case 0x27: {
-      //Sets 512 channels at once
-      for (uint16_t i = 0; i < 512; i++) {
-        dmxBuffer[i] = Link.packetData[i + 1];
+    case 0x28: {
+      //Commit the back buffer; it is transmitted from the next frame on
+      DmxSimple.commit();
+      
+      Debug.println(F("Committed"));
+      break;
+    }
+    
+    case 0x29: {
+      //Set the commit mode
+      //0 = changes wait for 0x28, nonzero = every packet is committed
+      autoCommit = Link.packetData[1];
+      
+      Debug.print(F("Auto-commit "));
+      Debug.println(autoCommit ? F("on") : F("off"));
+      break;
+    }
+    
+    case 0x2E: {
+      //Sets the channels picked out by a bitmap
+      //Start channel (16 bits), bitmap length, bitmap, then one value per set
+      //bit in order. Bit 0 of the first bitmap byte is the start channel.
+      uint16_t startChannel = Link.packetData[1] | Link.packetData[2] << 8;
+      uint8_t mapLength = Link.packetData[3];
+      const uint8_t *values = &Link.packetData[4 + mapLength];
+      const uint8_t *end = Link.packetData + Link.packetLength;
+      uint16_t count = 0;
+      if (Link.packetLength < 4 + mapLength) {
+        Error.set(INVALID_VALUE_ERROR); //Bitmap cut short
+        mapLength = 0;
       }
-      Serial.println(F("Updated 512 channels"));
+      for (uint16_t i = 0; i < mapLength * 8; i++) {
+        if (!(Link.packetData[4 + i / 8] & _BV(i % 8))) {
+          continue;
+        }
+        if (startChannel + i >= MAX_DMX || values >= end) {
+          Error.set(INVALID_VALUE_ERROR); //Past the universe or the packet
+          break;
+        }
+        dmxBuffer[startChannel + i] = *values++;
+        count++;
+      }
+      
+      Debug.print(F("Updated "));
+      Debug.print(count);
+      Debug.println(F(" channels"));
       break;
     }
     
@@ -306,7 +518,7 @@ void processCommand(uint8_t cmd) {
         dmxBuffer[i] = dmxBuffer[i + 256];
       }
       
-      Serial.println(F("Copied 256-511 to 0-255"));
+      Debug.println(F("Copied 256-511 to 0-255"));
       break;
     }
     
@@ -316,7 +528,7 @@ void processCommand(uint8_t cmd) {
         dmxBuffer[i + 256] = dmxBuffer[i];
       }
       
-      Serial.println(F("Copied 0-255 to 256-511"));
+      Debug.println(F("Copied 0-255 to 256-511"));
       break;
     }
     
@@ -330,7 +542,7 @@ void processCommand(uint8_t cmd) {
         dmxBuffer[i + 256] = temp;
       }
       
-      Serial.println(F("Exchanged 0-255 with 256-511"));
+      Debug.println(F("Exchanged 0-255 with 256-511"));
       break;
     }
     
@@ -341,31 +553,327 @@ void processCommand(uint8_t cmd) {
       uint8_t packet[] = {cmd, dmxBuffer[channel]};
       Link.send(packet, 2);
       
-      Serial.print(F("Channel "));
-      Serial.print(channel);
-      Serial.print(F(" is at "));
-      Serial.println(dmxBuffer[channel]);
+      Debug.print(F("Channel "));
+      Debug.print(channel);
+      Debug.print(F(" is at "));
+      Debug.println(dmxBuffer[channel]);
       break;
     }
     
     case 0x42: {
       //Reply with all channel values
-      Link.packetData[0] = cmd;
-      for (uint16_t i = 0; i < MAX_DMX; i++) {
-        Link.packetData[i + 1] = dmxBuffer[i];
-      }
-      Link.send(Link.packetData, MAX_DMX);
+      Link.send(&cmd, 1, (const uint8_t *)dmxBuffer, MAX_DMX);
       
-      Serial.println(F("Channel values:"));
+      Debug.println(F("Channel values:"));
       for (uint16_t i = 0; i < MAX_DMX; i++) {
-        Serial.print(dmxBuffer[i], HEX);
-        Serial.print(F(" "));
+        Debug.print(dmxBuffer[i], HEX);
+        Debug.print(F(" "));
       }
-      Serial.println();
+      Debug.println();
       
       break;
     }
+    
+    case 0x43: {
+      //Reply with channel values from a start channel, run-length coded
+      //The reply is a 0x2A packet; it covers as many channels as fit, so
+      //the next request starts where decoding it ends.
+      uint16_t startChannel = Link.packetData[1] | Link.packetData[2] << 8;
+      if (startChannel >= MAX_DMX) {
+        Error.set(INVALID_VALUE_ERROR);
+        break;
+      }
+      sendChannels(startChannel);
+      break;
+    }
 
+    case 0x50: {
+      //Fade the output to the back buffer
+      //Time in tenths of a second (16 bits, LSB first), then optionally the
+      //number of channel data packets that follow with the look to fade to.
+      //With that, the fade waits for them and nothing is auto-committed
+      //meanwhile, so the output doesn't snap to the new look first. The wait
+      //ends after FADE_WAIT_TIMEOUT without one (see manageTimeouts()).
+      uint16_t time = Link.packetData[1] | Link.packetData[2] << 8;
+      fadePackets = Link.packetLength > 3 ? Link.packetData[3] : 0;
+      if (fadePackets) {
+        fadeTime = time;
+        fadeWaitTime = millis();
+        Debug.print(F("Fade waiting for "));
+        Debug.println(fadePackets);
+        break;
+      }
+      Fade.start(time, time);
+      
+      Debug.print(F("Fading in "));
+      Debug.println(time);
+      break;
+    }
+    
+    case 0x51: {
+      //Split fade to the back buffer
+      //Up time, down time, up delay, down delay in tenths of a second
+      uint16_t upTime = Link.packetData[1] | Link.packetData[2] << 8;
+      uint16_t downTime = Link.packetData[3] | Link.packetData[4] << 8;
+      uint16_t upDelay = Link.packetData[5] | Link.packetData[6] << 8;
+      uint16_t downDelay = Link.packetData[7] | Link.packetData[8] << 8;
+      Fade.start(upTime, downTime, upDelay, downDelay);
+      
+      Debug.print(F("Fading up in "));
+      Debug.print(upTime);
+      Debug.print(F(" down in "));
+      Debug.println(downTime);
+      break;
+    }
+    
+    case 0x52: {
+      //Reply with fade progress (0-255 for each direction)
+      uint8_t packet[] = {
+        cmd,
+        Fade.active(),
+        Fade.upProgress(),
+        Fade.downProgress()
+      };
+      Link.send(packet, 4);
+      
+      Debug.print(F("Fade progress "));
+      Debug.print(packet[2]);
+      Debug.print(F("/"));
+      Debug.println(packet[3]);
+      break;
+    }
+    
+    case 0x53: {
+      //Stop the fade, holding the current output
+      Fade.stop();
+      fadePackets = 0; //Or the one waiting for its look
+      
+      Debug.println(F("Stopped fade"));
+      break;
+    }
+    
+    case 0x60: {
+      //Store the back buffer as a scene in EEPROM
+      uint8_t scene = Link.packetData[1];
+      if (!Scene.store(scene)) {
+        Error.set(INVALID_VALUE_ERROR); //Bad number or out of room
+        Debug.println(F("Error: scene not stored"));
+        break;
+      }
+      
+      Debug.print(F("Stored scene "));
+      Debug.println(scene);
+      break;
+    }
+    
+    case 0x61:
+    case 0x62: {
+      //Recall a scene into the back buffer
+      //0x62 fades to it; time in tenths of a second (16 bits, LSB first)
+      uint8_t scene = Link.packetData[1];
+      if (!Scene.recall(scene)) {
+        Error.set(INVALID_VALUE_ERROR); //No such scene
+        Debug.println(F("Error: no such scene"));
+        break;
+      }
+      if (cmd == 0x62) {
+        uint16_t time = Link.packetData[2] | Link.packetData[3] << 8;
+        Fade.start(time, time);
+      }
+      
+      Debug.print(F("Recalled scene "));
+      Debug.println(scene);
+      break;
+    }
+    
+    case 0x63: {
+      //Delete a scene (0xFF deletes them all)
+      uint8_t scene = Link.packetData[1];
+      if (scene == 0xFF) {
+        for (uint8_t i = 0; i < SCENE_COUNT; i++) {
+          Scene.remove(i);
+        }
+      } else if (!Scene.remove(scene)) {
+        Error.set(INVALID_VALUE_ERROR);
+      }
+      
+      Debug.print(F("Deleted scene "));
+      Debug.println(scene);
+      break;
+    }
+    
+    case 0x64: {
+      //Reply with scene memory info: scenes stored, bytes free (16 bits) and
+      //the time from the last recall command to the frame it went out in, in
+      //microseconds (32 bits, 0 if it hasn't gone out yet). LSB first.
+      uint8_t stored = Scene.count();
+      uint16_t space = Scene.freeSpace();
+      uint32_t recallTime = Scene.recallTime();
+      uint8_t packet[] = {
+        cmd,
+        stored,
+        (uint8_t)(space & 0xFF),
+        (uint8_t)(space >> 8),
+        (uint8_t)(recallTime & 0xFF),
+        (uint8_t)((recallTime >> 8) & 0xFF),
+        (uint8_t)((recallTime >> 16) & 0xFF),
+        (uint8_t)(recallTime >> 24)
+      };
+      Link.send(packet, 8);
+      
+      Debug.print(stored);
+      Debug.print(F(" scenes, "));
+      Debug.print(space);
+      Debug.print(F(" bytes free, last recall "));
+      Debug.print(recallTime);
+      Debug.println(F(" us"));
+      break;
+    }
+    
+#if SHOW_FEATURES_ENABLED
+    case 0x70: {
+      //Start, change or stop an effect
+      //Slot, waveform, first channel, channel count, rate (hundredths of a
+      //cycle per second), spread (1/65536ths of a cycle per channel), depth
+      //and a waveform parameter. 16-bit values are LSB first.
+      uint8_t slot = Link.packetData[1];
+      uint8_t waveform = Link.packetData[2];
+      uint16_t first = Link.packetData[3] | Link.packetData[4] << 8;
+      uint16_t count = Link.packetData[5] | Link.packetData[6] << 8;
+      uint16_t rate = Link.packetData[7] | Link.packetData[8] << 8;
+      uint16_t spread = Link.packetData[9] | Link.packetData[10] << 8;
+      uint8_t depth = Link.packetData[11];
+      uint8_t param = Link.packetData[12];
+      if (!Effects.set(slot, waveform, first, count, rate, spread, depth,
+          param)) {
+        Error.set(INVALID_VALUE_ERROR);
+        Debug.println(F("Error: bad effect"));
+        break;
+      }
+      
+      Debug.print(F("Effect "));
+      Debug.print(slot);
+      Debug.print(F(" now waveform "));
+      Debug.println(waveform);
+      break;
+    }
+    
+    case 0x71: {
+      //Stop all effects
+      Effects.stopAll();
+      
+      Debug.println(F("Stopped effects"));
+      break;
+    }
+    
+    case 0x80: {
+      //Set the dimmer curve of a range of channels
+      //First channel, channel count (16 bits each, LSB first), curve and a
+      //curve parameter (the threshold for switched channels)
+      uint16_t first = Link.packetData[1] | Link.packetData[2] << 8;
+      uint16_t count = Link.packetData[3] | Link.packetData[4] << 8;
+      uint8_t curve = Link.packetData[5];
+      uint8_t param = Link.packetData[6];
+      if (!Curve.set(first, count, curve, param)) {
+        Error.set(INVALID_VALUE_ERROR); //Bad range or too many ranges
+        Debug.println(F("Error: curve not set"));
+        break;
+      }
+      
+      Debug.print(F("Set curve "));
+      Debug.print(curve);
+      Debug.print(F(" on channels "));
+      Debug.print(first);
+      Debug.print(F("-"));
+      Debug.println(first + count - 1);
+      break;
+    }
+    
+    case 0x81: {
+      //Upload part of the user curve
+      //Offset of the first entry, then the entries (up to 68 per packet)
+      uint8_t offset = Link.packetData[1];
+      uint16_t length = Link.packetLength > 2 ? Link.packetLength - 2 : 0;
+      Curve.setUserTable(offset, &Link.packetData[2], length);
+      
+      Debug.print(F("Updated user curve from "));
+      Debug.println(offset);
+      break;
+    }
+    
+    case 0x82: {
+      //Make all channels linear
+      Curve.clear();
+      
+      Debug.println(F("Cleared curves"));
+      break;
+    }
+    
+    case 0x90: {
+      //Set part of a group's channel bitmap
+      //Group, offset of the first bitmap byte, then the bitmap bytes
+      uint8_t group = Link.packetData[1];
+      uint8_t offset = Link.packetData[2];
+      uint16_t length = Link.packetLength > 3 ? Link.packetLength - 3 : 0;
+      if (!Master.setBitmap(group, offset, &Link.packetData[3], length)) {
+        Error.set(INVALID_VALUE_ERROR);
+        break;
+      }
+      
+      Debug.print(F("Updated group "));
+      Debug.println(group);
+      break;
+    }
+    
+    case 0x91: {
+      //Add a range of channels to a group, or take them out
+      //Group, first channel, channel count (16 bits each, LSB first) and
+      //nonzero to add or 0 to remove
+      uint8_t group = Link.packetData[1];
+      uint16_t first = Link.packetData[2] | Link.packetData[3] << 8;
+      uint16_t count = Link.packetData[4] | Link.packetData[5] << 8;
+      bool member = Link.packetData[6];
+      if (!Master.setRange(group, first, count, member)) {
+        Error.set(INVALID_VALUE_ERROR);
+        break;
+      }
+      
+      Debug.print(member ? F("Added channels ") : F("Removed channels "));
+      Debug.print(first);
+      Debug.print(F("-"));
+      Debug.print(first + count - 1);
+      Debug.print(F(" to group "));
+      Debug.println(group);
+      break;
+    }
+    
+    case 0x93: {
+      //Set the grand master
+      uint8_t level = Link.packetData[1];
+      Master.setGrandMaster(level);
+      
+      Debug.print(F("Grand master at "));
+      Debug.println(level);
+      break;
+    }
+    
+    case 0x94:
+    case 0x95:
+    case 0x96:
+    case 0x97: {
+      //Set the submaster of group 0-3
+      uint8_t group = cmd & 0x03;
+      uint8_t level = Link.packetData[1];
+      Master.setSubmaster(group, level);
+      
+      Debug.print(F("Submaster "));
+      Debug.print(group);
+      Debug.print(F(" at "));
+      Debug.println(level);
+      break;
+    }
+#endif
+    
     case 0xDB: {
       //Toggle the LED debug pattern
       Status.toggle(DEBUG_STATUS);
@@ -376,7 +884,7 @@ void processCommand(uint8_t cmd) {
       //Stop transmitting DMX
       stopTransmitDMX();
       
-      Serial.println(F("Stopped DMX"));
+      Debug.println(F("Stopped DMX"));
       break;
     }
     
@@ -384,7 +892,7 @@ void processCommand(uint8_t cmd) {
       //Start transmitting DMX
       startTransmitDMX();
       
-      Serial.println(F("Started DMX"));
+      Debug.println(F("Started DMX"));
       break;
     }
     
@@ -398,8 +906,8 @@ void processCommand(uint8_t cmd) {
       }
       setMaxChannel(newMax); //Set the max number of channels
       
-      Serial.print(F("Max channels now "));
-      Serial.println(newMax);
+      Debug.print(F("Max channels now "));
+      Debug.println(newMax);
       break;
     }
     
@@ -408,7 +916,7 @@ void processCommand(uint8_t cmd) {
       DmxSimple.startDigitalBlackout();
       Status.set(DIGITAL_BLACKOUT_ENABLED_STATUS);
       
-      Serial.println(F("Started digital blackout"));
+      Debug.println(F("Started digital blackout"));
       break;
     }
     
@@ -417,7 +925,62 @@ void processCommand(uint8_t cmd) {
       DmxSimple.stopDigitalBlackout();
       Status.clear(DIGITAL_BLACKOUT_ENABLED_STATUS);
       
-      Serial.println(F("Stopped digital blackout"));
+      Debug.println(F("Stopped digital blackout"));
+      break;
+    }
+    
+    case 0xE6: {
+      //Set the break and mark after break lengths
+      //Break (88-1000) and MAB (8-1000) in microseconds, 16 bits each, LSB
+      //first
+      uint16_t breakTime = Link.packetData[1] | Link.packetData[2] << 8;
+      uint16_t mabTime = Link.packetData[3] | Link.packetData[4] << 8;
+      if (breakTime < 88 || breakTime > 1000 || mabTime < 8 || mabTime > 1000) {
+        Error.set(INVALID_VALUE_ERROR);
+        break;
+      }
+      DmxSimple.timing(breakTime, mabTime);
+      
+      Debug.print(F("Break "));
+      Debug.print(breakTime);
+      Debug.print(F("us, MAB "));
+      Debug.print(mabTime);
+      Debug.println(F("us"));
+      break;
+    }
+    
+    case 0xE7: {
+      //Set the target refresh rate and the gap between frames
+      //Rate in frames per second (0 for as fast as possible), then the gap in
+      //microseconds (16 bits, LSB first)
+      uint8_t rate = Link.packetData[1];
+      uint16_t gap = Link.packetData[2] | Link.packetData[3] << 8;
+      DmxSimple.framePeriod(rate ? 1000000 / rate : 0, gap);
+      
+      Debug.print(F("Refresh rate "));
+      Debug.print(rate);
+      Debug.print(F("Hz, gap "));
+      Debug.print(gap);
+      Debug.println(F("us"));
+      break;
+    }
+    
+    case 0xE8: {
+      //Set the start code
+      uint8_t code = Link.packetData[1];
+      DmxSimple.startCode(code);
+      
+      Debug.print(F("Start code "));
+      Debug.println(code, HEX);
+      break;
+    }
+    
+    case 0xE9: {
+      //Turn auto-trim on (nonzero) or off (0)
+      bool enabled = Link.packetData[1];
+      DmxSimple.autoTrim(enabled);
+      
+      Debug.println(enabled ? F("Auto-trim on") : F("Auto-trim off"));
       break;
     }
     
@@ -435,14 +998,140 @@ void processCommand(uint8_t cmd) {
       break;
     }
     
+    case 0xF2: {
+      //Set the trace level (0 off, 1 errors, 2 commands, 3 packets)
+      uint8_t level = Link.packetData[1];
+      if (level > TRACE_PACKETS) {
+        Error.set(INVALID_VALUE_ERROR);
+        break;
+      }
+#if TRACE_ENABLED
+      Trace.level = level;
+#endif
+      
+      Debug.print(F("Trace level "));
+      Debug.println(level);
+      break;
+    }
+    
+    case 0xF3: {
+      //Time a command
+      //Repeat count, then the command packet to run. Replies with the
+      //minimum, average and maximum time it took in microseconds (16 bits
+      //each, LSB first). The command really runs each time; anything it
+      //would send is dropped.
+      uint8_t *bench = Link.packetData;
+      uint16_t benchLength = Link.packetLength;
+      uint8_t repeat = bench[1] ? bench[1] : 1;
+      if (benchLength < 3 || bench[2] == cmd || bench[2] == 0x02 ||
+          bench[2] == 0xF0 || bench[2] == 0xF1) {
+        //No command, nested, a batch, or one that would shut down
+        Error.set(INVALID_VALUE_ERROR);
+        break;
+      }
+      
+      uint16_t minTime = 0xFFFF, maxTime = 0;
+      uint32_t totalTime = 0;
+      uint8_t dropped;
+      for (uint8_t i = 0; i < repeat; i++) {
+        Link.packetData = bench + 2;
+        Link.packetLength = benchLength - 2;
+        Link.collect(&dropped, 0);
+        uint32_t start = micros();
+        processCommand(Link.packetData[0]);
+        uint32_t elapsed = micros() - start;
+        Link.collected();
+        uint16_t time = elapsed > 0xFFFF ? 0xFFFF : elapsed;
+        minTime = min(minTime, time);
+        maxTime = max(maxTime, time);
+        totalTime += time;
+      }
+      Link.packetData = bench;
+      Link.packetLength = benchLength;
+      
+      uint16_t avgTime = totalTime / repeat;
+      uint8_t reply[] = {
+        cmd,
+        (uint8_t)(minTime & 0xFF), (uint8_t)(minTime >> 8),
+        (uint8_t)(avgTime & 0xFF), (uint8_t)(avgTime >> 8),
+        (uint8_t)(maxTime & 0xFF), (uint8_t)(maxTime >> 8)
+      };
+      Link.send(reply, sizeof(reply));
+      
+      Debug.print(F("Command "));
+      Debug.print(bench[2], HEX);
+      Debug.print(F(" took "));
+      Debug.print(avgTime);
+      Debug.println(F("us"));
+      break;
+    }
+    
+    case 0xF4: {
+      //Reply with the status and error flags (the errors aren't cleared),
+      //the number of counters, then the uptime in milliseconds, the
+      //temperature in thousandths of a degree C and the counters in the
+      //order of telemetry.h, all 32 bits LSB first
+      sendStats();
+      break;
+    }
+    
+    case 0xF5: {
+      //Reset the counters and the frame timing
+      Telemetry.reset();
+      DmxFrameStats unused;
+      DmxSimple.frameStats(unused, true);
+      
+      Debug.println(F("Stats reset"));
+      break;
+    }
+    
+    case 0xF6: {
+      //Reply with the DMX frame timing: the number of latency buckets, the
+      //minimum, average and maximum frame period in microseconds (32 bits
+      //each), then the latency histogram (16 bits each, see DmxSimple.h),
+      //all LSB first
+      sendFrameStats();
+      break;
+    }
+    
+#if LINK_FAULTS_ENABLED
+    case 0xF7: {
+      //Inject link faults
+      //Fault type (LINK_FAULT_* in link.h, 0 to stop), number of data
+      //packets to fault. Replies with how long it took to accept a packet
+      //after the last fault before this one, in microseconds (32 bits LSB
+      //first, 0 if none has been accepted since).
+      uint8_t fault = Link.packetData[1];
+      if (fault > LINK_FAULT_STALL) {
+        Error.set(INVALID_VALUE_ERROR);
+        break;
+      }
+      uint32_t recovery = Link.recovery();
+      Link.inject(fault, Link.packetData[2]);
+      uint8_t packet[] = {
+        cmd,
+        (uint8_t)(recovery & 0xFF),
+        (uint8_t)((recovery & 0xFF00) >> 8),
+        (uint8_t)((recovery & 0xFF0000) >> 16),
+        (uint8_t)((recovery & 0xFF000000) >> 24)
+      };
+      Link.send(packet, 5);
+      
+      Debug.print(F("Last recovery: "));
+      Debug.print(recovery);
+      Debug.println(F("us"));
+      break;
+    }
+#endif
+    
     case 0xF8: {
       //Reply with status flags
       uint8_t status = Status.get();
       uint8_t packet[] = {cmd, status};
       Link.send(packet, 2);
       
-      Serial.print(F("Status flags: "));
-      Serial.println(status, HEX);
+      Debug.print(F("Status flags: "));
+      Debug.println(status, HEX);
       break;
     }
     
@@ -452,8 +1141,8 @@ void processCommand(uint8_t cmd) {
       uint8_t packet[] = {cmd, errors};
       Link.send(packet, 2);
       
-      Serial.print(F("Error flags: "));
-      Serial.println(errors, HEX);
+      Debug.print(F("Error flags: "));
+      Debug.println(errors, HEX);
       
       Error.reset(); //Clear out the errors now that they have been reported
       break;
@@ -472,19 +1161,19 @@ void processCommand(uint8_t cmd) {
       };
       Link.send(packet, 7);
       
-      Serial.print(F("Protocol version: "));
-      Serial.print(PROTOCOL_VERSION_MAJOR);
-      Serial.print(F("."));
-      Serial.print(PROTOCOL_VERSION_MINOR);
-      Serial.print(F("."));
-      Serial.println(PROTOCOL_VERSION_PATCH);
+      Debug.print(F("Protocol version: "));
+      Debug.print(PROTOCOL_VERSION_MAJOR);
+      Debug.print(F("."));
+      Debug.print(PROTOCOL_VERSION_MINOR);
+      Debug.print(F("."));
+      Debug.println(PROTOCOL_VERSION_PATCH);
       
-      Serial.print(F("Firmware version: "));
-      Serial.print(FIRMWARE_VERSION_MAJOR);
-      Serial.print(F("."));
-      Serial.print(FIRMWARE_VERSION_MINOR);
-      Serial.print(F("."));
-      Serial.println(FIRMWARE_VERSION_PATCH);
+      Debug.print(F("Firmware version: "));
+      Debug.print(FIRMWARE_VERSION_MAJOR);
+      Debug.print(F("."));
+      Debug.print(FIRMWARE_VERSION_MINOR);
+      Debug.print(F("."));
+      Debug.println(FIRMWARE_VERSION_PATCH);
       break;
     }
     
@@ -498,12 +1187,12 @@ void processCommand(uint8_t cmd) {
       };
       Link.send(packet, 4);
       
-      Serial.print(F("Protocol version: "));
-      Serial.print(PROTOCOL_VERSION_MAJOR);
-      Serial.print(F("."));
-      Serial.print(PROTOCOL_VERSION_MINOR);
-      Serial.print(F("."));
-      Serial.println(PROTOCOL_VERSION_PATCH);
+      Debug.print(F("Protocol version: "));
+      Debug.print(PROTOCOL_VERSION_MAJOR);
+      Debug.print(F("."));
+      Debug.print(PROTOCOL_VERSION_MINOR);
+      Debug.print(F("."));
+      Debug.println(PROTOCOL_VERSION_PATCH);
       break;
     }
     
@@ -517,12 +1206,12 @@ void processCommand(uint8_t cmd) {
       };
       Link.send(packet, 4);
       
-      Serial.print(F("Firmware version: "));
-      Serial.print(FIRMWARE_VERSION_MAJOR);
-      Serial.print(F("."));
-      Serial.print(FIRMWARE_VERSION_MINOR);
-      Serial.print(F("."));
-      Serial.println(FIRMWARE_VERSION_PATCH);
+      Debug.print(F("Firmware version: "));
+      Debug.print(FIRMWARE_VERSION_MAJOR);
+      Debug.print(F("."));
+      Debug.print(FIRMWARE_VERSION_MINOR);
+      Debug.print(F("."));
+      Debug.println(FIRMWARE_VERSION_PATCH);
       break;
     }
     
@@ -531,16 +1220,16 @@ void processCommand(uint8_t cmd) {
       uint32_t temp = readTemp();
       uint8_t packet[] = {
         cmd,
-        (temp & 0xFF),
-        (temp & 0xFF00) >> 8,
-        (temp & 0xFF0000) >> 16,
-        (temp & 0xFF000000) >> 24
+        (uint8_t)(temp & 0xFF),
+        (uint8_t)((temp & 0xFF00) >> 8),
+        (uint8_t)((temp & 0xFF0000) >> 16),
+        (uint8_t)((temp & 0xFF000000) >> 24)
       };
       Link.send(packet, 5);
       
-      Serial.print(F("Current temperature: "));
-      Serial.print(temp/1000.0);
-      Serial.println(F(" C"));
+      Debug.print(F("Current temperature: "));
+      Debug.print(temp/1000.0);
+      Debug.println(F(" C"));
       break;
     }
     
@@ -549,29 +1238,166 @@ void processCommand(uint8_t cmd) {
       uint32_t uptime = millis();
       uint8_t packet[] = {
         cmd,
-        (uptime & 0xFF),
-        (uptime & 0xFF00) >> 8,
-        (uptime & 0xFF0000) >> 16,
-        (uptime & 0xFF000000) >> 24
+        (uint8_t)(uptime & 0xFF),
+        (uint8_t)((uptime & 0xFF00) >> 8),
+        (uint8_t)((uptime & 0xFF0000) >> 16),
+        (uint8_t)((uptime & 0xFF000000) >> 24)
       };
       Link.send(packet, 5);
       
-      Serial.print(F("Uptime: "));
-      Serial.print(uptime/1000.0);
-      Serial.println(F(" seconds"));
+      Debug.print(F("Uptime: "));
+      Debug.print(uptime/1000.0);
+      Debug.println(F(" seconds"));
       break;
     }
     
     default: {
       //Unknown command; set the error code
+      Telemetry.count(STAT_UNKNOWN_COMMANDS);
       Error.set(UNKNOWN_COMMAND_ERROR);
       
-      Serial.println(F("Error: unknown command"));
+      Debug.println(F("Error: unknown command"));
       break;
     }
   }
 }
 
+/**
+ * runBatch - Runs the commands of a 0x02 batch and sends back their replies
+ * together.
+ *
+ * This and the send* functions below keep their buffers out of
+ * processCommand(), so they aren't on the stack twice when a batch or a
+ * timing run calls it again.
+ */
+static void runBatch(void) {
+  uint8_t *batch = Link.packetData;
+  uint16_t batchLength = Link.packetLength;
+  uint8_t replies[BATCH_REPLY_LENGTH] = {0x02};
+  uint8_t count = 0;
+  Link.collect(replies + 1, BATCH_REPLY_LENGTH - 1);
+  
+  uint16_t i = 1;
+  while (i < batchLength) {
+    uint8_t length = batch[i];
+    if (length == 0 || i + 1 + length > batchLength ||
+        batch[i + 1] == 0x02 || batch[i + 1] == 0xF3) {
+      //Empty, cut short, nested or timed (which gathers its own replies)
+      Error.set(INVALID_VALUE_ERROR);
+      break;
+    }
+    Link.packetData = batch + i + 1;
+    Link.packetLength = length;
+    processCommand(Link.packetData[0]);
+    count++;
+    i += 1 + length;
+  }
+  
+  Link.packetData = batch;
+  Link.packetLength = batchLength;
+  uint16_t replyLength = Link.collected();
+  if (replyLength > 0) {
+    Link.send(replies, 1 + replyLength);
+  }
+  
+  Debug.print(F("Ran batch of "));
+  Debug.println(count);
+}
+
+/**
+ * sendChannels - Replies to 0x43 with the channel values from a start
+ * channel, run-length coded.
+ *
+ * Parameter:
+ *    uint16_t startChannel: the first channel (below MAX_DMX)
+ */
+static void sendChannels(uint16_t startChannel) {
+  uint8_t packet[3 + READBACK_CHUNK_LENGTH] = {
+    CODEC_RLE_CMD,
+    (uint8_t)(startChannel & 0xFF),
+    (uint8_t)(startChannel >> 8)
+  };
+  uint16_t channels;
+  uint16_t length = Codec.encode((const uint8_t *)dmxBuffer + startChannel,
+      0, MAX_DMX - startChannel, &packet[3], READBACK_CHUNK_LENGTH,
+      &channels);
+  Link.send(packet, 3 + length);
+  
+  Debug.print(F("Sent channels "));
+  Debug.print(startChannel);
+  Debug.print(F("-"));
+  Debug.print(startChannel + channels - 1);
+  Debug.print(F(" in "));
+  Debug.print(length);
+  Debug.println(F(" bytes"));
+}
+
+/**
+ * sendStats - Replies to 0xF4 with the flags, the uptime, the temperature and
+ * the counters.
+ */
+static void sendStats(void) {
+  uint32_t now = millis();
+  int32_t temp = readTemp();
+  uint8_t packet[4 + 4 * (2 + STAT_COUNT)] = {
+    0xF4,
+    Status.get(),
+    Error.get(),
+    STAT_COUNT,
+    (uint8_t)(now & 0xFF),
+    (uint8_t)((now & 0xFF00) >> 8),
+    (uint8_t)((now & 0xFF0000) >> 16),
+    (uint8_t)((now & 0xFF000000) >> 24),
+    (uint8_t)(temp & 0xFF),
+    (uint8_t)((temp & 0xFF00) >> 8),
+    (uint8_t)((temp & 0xFF0000) >> 16),
+    (uint8_t)((temp & 0xFF000000) >> 24)
+  };
+  Telemetry.read(packet + 12);
+  Link.send(packet, sizeof(packet));
+  
+  Debug.print(F("Stats: "));
+  for (uint8_t i = 12; i < sizeof(packet); i += 4) {
+    Debug.print(packet[i] | (uint32_t)packet[i + 1] << 8 |
+        (uint32_t)packet[i + 2] << 16 | (uint32_t)packet[i + 3] << 24);
+    Debug.print(F(" "));
+  }
+  Debug.println();
+}
+
+/**
+ * sendFrameStats - Replies to 0xF6 with the DMX frame timing.
+ */
+static void sendFrameStats(void) {
+  DmxFrameStats stats;
+  DmxSimple.frameStats(stats, false);
+  uint32_t periods[] = {stats.minPeriod, stats.avgPeriod, stats.maxPeriod};
+  
+  uint8_t packet[2 + sizeof(periods) + sizeof(stats.latency)];
+  uint8_t *p = packet;
+  *p++ = 0xF6;
+  *p++ = DMX_LATENCY_BUCKETS;
+  for (uint8_t i = 0; i < 3; i++) {
+    *p++ = periods[i] & 0xFF;
+    *p++ = (periods[i] >> 8) & 0xFF;
+    *p++ = (periods[i] >> 16) & 0xFF;
+    *p++ = periods[i] >> 24;
+  }
+  for (uint8_t i = 0; i < DMX_LATENCY_BUCKETS; i++) {
+    *p++ = stats.latency[i] & 0xFF;
+    *p++ = stats.latency[i] >> 8;
+  }
+  Link.send(packet, sizeof(packet));
+  
+  Debug.print(F("Frame period: "));
+  Debug.print(stats.minPeriod);
+  Debug.print(F("/"));
+  Debug.print(stats.avgPeriod);
+  Debug.print(F("/"));
+  Debug.print(stats.maxPeriod);
+  Debug.println(F("us"));
+}
+
 /**
  * setMaxChannel - Sets the maximum number of channels to transmit
  * Parameter:
@@ -608,16 +1434,130 @@ static void stopTransmitDMX(void) {
   Status.clear(DMX_ENABLED_STATUS); //Clear the transmit enable flag
 }
 
+/**
+ * frameDone - Does the per-frame work. Called by DmxSimple at every frame
+ * boundary, from the DMX interrupt.
+ */
+static void frameDone(void) {
+  Fade.frame();
+  if (DmxSimple.frameCommitted() || Fade.active()) {
+    Scene.sent(); //A recalled look starts going out now
+  }
+#if SHOW_FEATURES_ENABLED
+  Effects.frame();
+  DmxSimple.trimFloor(Effects.top());
+#endif
+}
+
+#if SHOW_FEATURES_ENABLED
+/**
+ * runCues - Runs every queued command whose time has come. They are applied
+ * together and committed at once, so they all go out from the same frame.
+ * Anything they would send back is dropped.
+ */
+static void runCues(void) {
+  //The link may be streaming a long packet (or a serial line) through the
+  //sink; leave the cues until it is done
+  if (!Cue.waiting() || !Link.lockSink()) {
+    return;
+  }
+  uint8_t cue[CUE_DATA_LENGTH];
+  uint8_t length = Cue.take(cue);
+  if (!length) {
+    Link.unlockSink();
+    return;
+  }
+
+  uint8_t *data = Link.packetData;
+  uint16_t dataLength = Link.packetLength;
+  uint8_t dropped;
+  DmxSimple.beginWrite();
+  do {
+    TRACE(TRACE_COMMANDS, TRACE_EVENT_CUE, cue[0], length);
+    Telemetry.count(STAT_COMMANDS);
+    Link.packetData = cue;
+    Link.packetLength = length;
+    Link.collect(&dropped, 0);
+    processCommand(cue[0]);
+    Link.collected();
+  } while ((length = Cue.take(cue)));
+  DmxSimple.endWrite();
+  Link.packetData = data;
+  Link.packetLength = dataLength;
+  Link.unlockSink();
+  Fade.follow();
+
+  if (autoCommit && !Fade.active() && !fadePackets) {
+    DmxSimple.commit();
+  }
+}
+
+#endif
+
+/**
+ * writesEeprom - Checks whether a command spends a long time writing EEPROM
+ * (about 3.3 ms a byte) and leaves the back buffer alone: storing or
+ * deleting scenes and uploading the user curve. In a batch or a cue they
+ * still wait for the rest of it.
+ */
+static bool writesEeprom(uint8_t cmd) {
+  return cmd == 0x60 || cmd == 0x63 || cmd == 0x81;
+}
+
+/**
+ * changesChannels - Checks whether a command can change the back buffer, so
+ * it counts towards the look a waiting fade (0x50) is for. Batches count too.
+ */
+static bool changesChannels(uint8_t cmd) {
+  return cmd == 0x02 || (cmd >= 0x10 && cmd <= 0x2E && cmd != 0x28 &&
+      cmd != 0x29);
+}
+
+/**
+ * blinkLED - Shows the next step of the LED pattern. Run by the scheduler
+ * from the timer interrupt.
+ */
+static void blinkLED(void) {
+  LED.update();
+}
+
+#if SHOW_FEATURES_ENABLED
+/**
+ * slotFilter - Works out the level to transmit for a slot. Called by DmxSimple
+ * for every slot, from the DMX interrupt. The bit-banged transmitter counts
+ * the time this takes against its share of the CPU.
+ *
+ * Parameters:
+ *    uint16_t slot: the channel index (0-511)
+ *    uint8_t level: the channel's level in dmxOutput
+ * Returns:
+ *    uint8_t level: the level to transmit
+ */
+static uint8_t slotFilter(uint16_t slot, uint8_t level) {
+  return Curve.apply(slot, Master.apply(slot, Effects.apply(slot, level)));
+}
+
+#endif
+
 /**
  * manageTimeouts - Handles checking if the timeout periods have passed
  *
  * This function should be called periodically at least once per second.
+ * It is run by the scheduler every TIMEOUT_CHECK_PERIOD.
  */
 void manageTimeouts() {
   if (Status.test(RESTRICTED_MODE_STATUS) &&
       (millis() - lastCmdReceived > RESTRICTED_MODE_TIMEOUT)) {
     Status.clear(RESTRICTED_MODE_STATUS); //Clear the no-op flag after 1 second
-    Serial.println(F("Leaving restricted mode"));
+    Debug.println(F("Leaving restricted mode"));
+  }
+
+  if (fadePackets && millis() - fadeWaitTime > FADE_WAIT_TIMEOUT) {
+    //The rest of the look isn't coming; fade to what did, so auto-commit
+    //isn't held off for good
+    fadePackets = 0;
+    Fade.start(fadeTime, fadeTime);
+    Debug.println(F("Fade stopped waiting"));
   }
 
 #if AUTO_SHUT_DOWN_ENABLED
@@ -628,12 +1568,12 @@ void manageTimeouts() {
     uint8_t packet[] = {'S', 'O', 'S'};
     Link.send(packet, 3);
     Status.set(SENT_SHUT_DOWN_WARNING_STATUS);
-    Serial.println(F("Sent inactivity warning"));
+    Debug.println(F("Sent inactivity warning"));
   } else if (Status.test(SENT_SHUT_DOWN_WARNING_STATUS) &&
       ((millis() - lastCmdReceived) > AUTO_SHUT_DOWN_TIME)) {
     //It's been 1 minute since we sent a warning. Time to shut down.
     //Must enable restricted mode to shut down
-    Serial.println(F("Shutting down..."));
+    Debug.println(F("Shutting down..."));
     Status.set(RESTRICTED_MODE_STATUS);
     initShutDown();
   } else {
@@ -653,7 +1593,7 @@ void manageTimeouts() {
 void initShutDown(bool reset) {
   if (!Status.test(RESTRICTED_MODE_STATUS)) {
     Error.set(RESTRICTED_MODE_ERROR); //Last command wasn't no-op
-    Serial.println(F("Error: must be in restricted mode"));
+    Debug.println(F("Error: must be in restricted mode"));
     return;
   }
 
@@ -661,13 +1601,13 @@ void initShutDown(bool reset) {
   Link.send(CMD_EOT);
   
   //Prepare to shut down or reset
-  Serial.print(F("The system is going down for "));
+  Debug.print(F("The system is going down for "));
   if (reset) {
-    Serial.print(F("reboot"));
+    Debug.print(F("reboot"));
   } else {
-    Serial.print(F("system halt"));
+    Debug.print(F("system halt"));
   }
-  Serial.println(F(" NOW!"));
+  Debug.println(F(" NOW!"));
 
   //Some final cleanup
   stopTransmitDMX();
@@ -5,7 +5,23 @@
  * This file contains the code for communicating with the calculator and the
  * serial port.
  *
- * Last modified November 4, 2014
+ * Packets from the calculator are received in the background by a pin change
+ * interrupt and queued in a ring buffer, so the main loop only ever sees
+ * complete, checksummed packets. Replies from the main loop still use the
+ * blocking par_put/par_get routines with the interrupt paused.
+ *
+ * Channel data packets too long to queue (such as a whole universe) are
+ * instead written straight into the back buffer as they arrive, with the
+ * checksum added up as they go. The main loop then sees a short record saying
+ * the packet was applied. This keeps the ring buffer small.
+ *
+ * A sender that doesn't want to wait for an ACK after every packet can stream
+ * instead: it sends sequence-numbered CMD_STREAM packets back to back and
+ * ends each window with a CMD_STREAM_SYNC packet, which is the only one
+ * answered. A bad packet is dropped along with everything after it until the
+ * sync, and the answer tells the sender where to resume (go-back-N).
+ *
+ * Last modified October 16, 2026
  *
  *
  * Copyright (C) 2014  Alex Cordonnier
@@ -29,16 +45,33 @@
  ******************************************************************************/
 
 #include "Arduino.h"
+#include <DmxSimple.h>
+#include <util/atomic.h>
 
 #include "link.h"
+#include "codec.h"
+#include "fastpin.h"
 #include "firmware.h"
 #include "status.h"
-#include "LED.h"
+#include "sink.h"
+#include "telemetry.h"
 
 /******************************************************************************
  * Internal constants
  ******************************************************************************/
 
+//XOR patches are never streamed (see sink.h), so the ring must hold them
+#if RX_QUEUE_LENGTH < CODEC_MAX_PATCH
+#error "RX_BUFFER_LENGTH is too small for the longest XOR patch"
+#endif
+
+//Whether the packet being received has fault f injected into it
+#if LINK_FAULTS_ENABLED
+#define FAULT(f)              (rxFault == (f))
+#else
+#define FAULT(f)              false
+#endif
+
 //Valid Machine ID bytes
 #define MACHINE_ID_PC_82      0x02
 #define MACHINE_ID_PC_83      0x03
@@ -50,11 +83,142 @@
 //Which Machine ID to use
 #define MACHINE_ID            MACHINE_ID_PC_84
 
-//Various calculator communication timeouts
+//Error codes returned by par_put and par_get (plus the step, byte and bit)
 #define ERR_READ_TIMEOUT      1000
 #define ERR_WRITE_TIMEOUT     2000
-#define TIMEOUT               4000
-#define GET_ENTER_TIMEOUT     30000
+
+/* Link timeouts (microseconds). The calculator's bit time is measured from its
+ * ready check, and the bit and receive timeouts are then set to a number of
+ * bit times (within the limits below), so a glitch is caught within a few
+ * milliseconds. Until then the defaults are used.
+ */
+#define BIT_TIMEOUT           20000 //Default max wait for one step of a bit
+#define RX_TIMEOUT            500000 //Default max time between edges in a packet
+#define MIN_BIT_TIMEOUT       1000
+#define MIN_RX_TIMEOUT        20000
+#define BIT_TIMEOUT_BITS      16
+#define RX_TIMEOUT_BITS       256
+#define GET_ENTER_TIMEOUT     100000 //Max wait for the calculator to start a reply
+
+//Max time to wait for the receiver to idle (milliseconds)
+#define PAUSE_TIMEOUT         1000
+
+//Max time between characters of a serial line before it is dropped
+//(milliseconds, about 100 characters at SERIAL_SPEED)
+#define SERIAL_LINE_TIMEOUT   100
+
+//Polls between reads of micros() in the polling loops (a power of 2)
+#define DEADLINE_POLLS        16
+
+/* Time between the end of a packet and the start of the reply (microseconds).
+ * It is timed with timer 0's compare B interrupt (4 us per count with the
+ * Arduino core's prescaler), plus a count for the one already under way.
+ */
+#define REPLY_GUARD_TIME      50
+#define REPLY_GUARD_COUNTS    ((REPLY_GUARD_TIME + 3) / 4 + 1)
+
+//Number of times send() waits for the ACK before giving up
+#define ACK_RETRIES           10
+
+//Bit level states
+#define LINE_RX_BIT           0 //Waiting for the calculator to send a bit
+#define LINE_RX_ONE           1 //Acked a 1 with tip, waiting for ring release
+#define LINE_RX_ZERO          2 //Acked a 0 with ring, waiting for tip release
+#define LINE_TX_BIT           3 //Waiting for idle lines to send a bit
+#define LINE_TX_ONE           4 //Pulled ring, waiting for the tip ack
+#define LINE_TX_ZERO          5 //Pulled tip, waiting for the ring ack
+#define LINE_TX_ONE_DONE      6 //Released ring, waiting for tip release
+#define LINE_TX_ZERO_DONE     7 //Released tip, waiting for ring release
+#define LINE_PAUSED           8 //Interrupt ignored while send() has the lines
+#define LINE_TX_GUARD         9 //Reply ready, waiting out REPLY_GUARD_TIME
+
+//Packet assembler phases
+#define RX_HEADER             0
+#define RX_DATA               1
+#define RX_CHECKSUM           2
+
+//Ring buffer records
+#define RECORD_HEADER_LENGTH  2
+#define RECORD_FROM_SERIAL    0x80 //Flags in the high length byte
+#define RECORD_STREAMED       0x40
+#define RECORD_WRAP           0xFF //Both length bytes; the next record is at 0
+#define STREAMED_LENGTH       2 //Command byte and whether the data was valid
+
+//Who is currently filling a record in the ring buffer
+#define OWNER_NONE            0
+#define OWNER_LINK            1
+#define OWNER_SERIAL          2
+#define OWNER_LOOP            3 //Not filling one; see lockSink()
+
+/* Both link pins must be on the same pin change interrupt group. On the
+ * 168/328P, pins 0-7 are PCINT16-23, 8-13 are PCINT0-5 and 14-19 are
+ * PCINT8-13.
+ */
+#if TI_RING_PIN < 8 && TI_TIP_PIN < 8
+#define LINK_PCINT_vect       PCINT2_vect
+#define LINK_PCMSK            PCMSK2
+#define LINK_PCIE             PCIE2
+#define LINK_PCINT_BIT(pin)   (pin)
+#elif TI_RING_PIN >= 8 && TI_RING_PIN < 14 && TI_TIP_PIN >= 8 && TI_TIP_PIN < 14
+#define LINK_PCINT_vect       PCINT0_vect
+#define LINK_PCMSK            PCMSK0
+#define LINK_PCIE             PCIE0
+#define LINK_PCINT_BIT(pin)   ((pin) - 8)
+#elif TI_RING_PIN >= 14 && TI_TIP_PIN >= 14
+#define LINK_PCINT_vect       PCINT1_vect
+#define LINK_PCMSK            PCMSK1
+#define LINK_PCIE             PCIE1
+#define LINK_PCINT_BIT(pin)   ((pin) - 14)
+#else
+#error "TI_RING_PIN and TI_TIP_PIN must be on the same port"
+#endif
+
+#define LINK_PCINT_MASK       (_BV(LINK_PCINT_BIT(TI_RING_PIN)) | \
+                               _BV(LINK_PCINT_BIT(TI_TIP_PIN)))
+
+/******************************************************************************
+ * Internal types
+ ******************************************************************************/
+
+typedef FastPin<TI_RING_PIN> Ring;
+typedef FastPin<TI_TIP_PIN> Tip;
+
+/* Times a polling loop. Reading micros() takes a few microseconds, so it is
+ * only read every DEADLINE_POLLS polls to keep the loops quick to follow the
+ * calculator.
+ */
+class Deadline {
+    public:
+        void start(uint32_t length) {
+          begin = micros();
+          this->length = length;
+          polls = 0;
+        }
+        bool passed(void) {
+          return !(++polls & (DEADLINE_POLLS - 1)) && micros() - begin > length;
+        }
+
+    private:
+        uint32_t begin;
+        uint32_t length;
+        uint8_t polls;
+};
+
+/* Timing probe: high during blocking sends and while the pin change interrupt
+ * runs, to line up link activity with the DMX probes on a logic analyzer.
+ */
+#ifdef LINK_PROBE_PIN
+typedef FastPin<LINK_PROBE_PIN> Probe;
+#define LINK_PROBE_BEGIN()    Probe::pull()
+#define LINK_PROBE_BUSY()     Probe::read()
+#define LINK_PROBE_HIGH()     Probe::high()
+#define LINK_PROBE_LOW()      Probe::low()
+#else
+#define LINK_PROBE_BEGIN()
+#define LINK_PROBE_BUSY()     false
+#define LINK_PROBE_HIGH()
+#define LINK_PROBE_LOW()
+#endif
 
 /******************************************************************************
  * Function definitions
@@ -72,10 +236,108 @@ void LinkClass::begin(void) {
 #endif
 
   resetLines(); //Set up the I/O lines
+  LINK_PROBE_BEGIN();
+
+  rxRead = 0;
+  rxWrite = 0;
+  rxNext = 0;
+  rxOwner = OWNER_NONE;
+  serialData = NULL;
+  serialLength = 0;
+  serialByte = 0;
+  serialChars = 0;
+  serialSinking = false;
+  serialWaiting = false;
+  replyBuffer = NULL;
+  bitTime = 0;
+  bitTimeout = BIT_TIMEOUT;
+  rxTimeout = RX_TIMEOUT;
+  streamSynced = false;
+  streamLost = false;
+  reset();
+
+  //Enable the pin change interrupt on both link lines
+  LINK_PCMSK |= LINK_PCINT_MASK;
+  PCICR |= _BV(LINK_PCIE);
 
   send(CMD_CTS); //Send the ready message
 }
 
+/**
+ * update - Handles receive timeouts and serial debug input.
+ *
+ * This function should be called frequently from the main loop.
+ */
+void LinkClass::update(void) {
+  expire();
+  if (rxStalled) {
+    unstall(); //A long packet may be waiting for a commit to go out
+  }
+
+#if SERIAL_DEBUG_ENABLED
+  parseSerial();
+#endif
+}
+
+/**
+ * expire - Starts over if a packet or reply got stuck partway through.
+ *
+ * Returns:
+ *    bool timedOut: true if the receiver was reset
+ */
+bool LinkClass::expire(void) {
+  bool timedOut = false;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    bool idle = lineState == LINE_RX_BIT && rxPhase == RX_HEADER &&
+        rxIndex == 0 && bitCount == 0;
+    if (!idle && !rxStalled && lineState != LINE_PAUSED &&
+        micros() - lastEdge > rxTimeout) {
+      reset();
+      timedOut = true;
+    }
+  }
+  if (timedOut) {
+    Telemetry.count(STAT_RX_TIMEOUTS);
+    Debug.println(F("Error: link timed out"));
+    TRACE(TRACE_ERRORS, TRACE_EVENT_LINK_TIMEOUT);
+  }
+  return timedOut;
+}
+
+#if LINK_FAULTS_ENABLED
+/**
+ * inject - Puts a fault on the next data packets received from the
+ * calculator.
+ *
+ * Parameters:
+ *    uint8_t fault: LINK_FAULT_*
+ *    uint8_t count: the number of packets to fault (0 to stop)
+ */
+void LinkClass::inject(uint8_t fault, uint8_t count) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    faultType = fault;
+    faultCount = fault == LINK_FAULT_NONE ? 0 : count;
+  }
+}
+
+/**
+ * recovery - Gets how long it took to accept a packet after the last
+ * injected fault.
+ *
+ * Returns:
+ *    uint32_t time: microseconds from the header of the faulted packet to the
+ *                   end of the next packet accepted, or 0 if none has been
+ *                   accepted since
+ */
+uint32_t LinkClass::recovery(void) {
+  uint32_t time;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    time = faultRecovering ? 0 : recoveryTime;
+  }
+  return time;
+}
+#endif
+
 /**
  * send - Sends data to the calculator.
  *
@@ -83,51 +345,104 @@ void LinkClass::begin(void) {
  *    const uint8_t *data: a pointer to the data to send (will be
  *                         wrapped in a packet by this function)
  *    uint16_t length: the length of data to send
+ */
+void LinkClass::send(const uint8_t *data, uint16_t length) {
+  send(NULL, 0, data, length);
+}
+
+/**
+ * send - Sends data made up of two parts to the calculator as one packet.
+ *
+ * Parameters:
+ *    const uint8_t *prefix: a pointer to the first part (e.g. a command byte)
+ *    uint16_t prefixLength: the length of the first part
+ *    const uint8_t *data: a pointer to the second part
+ *    uint16_t length: the length of the second part
  *
  * Note: Reuses packetHead and packetChecksum. Does not copy data to a separate
- * buffer.
+ * buffer. Blocks until the packet has been sent and acknowledged.
  */
-void LinkClass::send(const uint8_t *data, uint16_t length) {
+void LinkClass::send(const uint8_t *prefix, uint16_t prefixLength,
+    const uint8_t *data, uint16_t length) {
+  if (replyBuffer) {
+    queueReply(prefix, prefixLength, data, length);
+    return;
+  }
+
+  uint16_t totalLength = prefixLength + length;
   packetHead[0] = MACHINE_ID;
   packetHead[1] = CMD_DATA;
-  packetHead[2] = length & 0x00FF;
-  packetHead[3] = length >> 8;
+  packetHead[2] = totalLength & 0x00FF;
+  packetHead[3] = totalLength >> 8;
 
-  uint16_t chksm = checksum(data, length);
+  uint16_t chksm = checksum(prefix, prefixLength) + checksum(data, length);
   packetChecksum[0] = chksm & 0x00FF;
   packetChecksum[1] = chksm >> 8;
 
+  TRACE(TRACE_PACKETS, TRACE_EVENT_SENT,
+      prefixLength ? prefix[0] : (length ? data[0] : 0), totalLength);
+
 #if SERIAL_DEBUG_ENABLED
-  Serial.print(F("Sent: "));
-  printHex(packetHead, HEADER_LENGTH);
-  printHex(data, length);
-  printHex(packetChecksum, CHECKSUM_LENGTH);
-  Serial.println();
+  if (!TRACE_ENABLED || Status.test(SERIAL_DIAGNOSTICS_STATUS)) {
+    //While tracing, only replies to serial commands are printed
+    Serial.print(F("Sent: "));
+    printHex(packetHead, HEADER_LENGTH);
+    printHex(prefix, prefixLength);
+    printHex(data, length);
+    printHex(packetChecksum, CHECKSUM_LENGTH);
+    Serial.println();
+  }
 
   if (!Status.test(SERIAL_DIAGNOSTICS_STATUS)) {
-    //Prevent recursively calling receive()
+    //Replies to serial commands only go to the serial port
 #endif
 
+  if (!pause()) {
+    Debug.println(F("Error: link busy"));
+    TRACE(TRACE_ERRORS, TRACE_EVENT_LINK_BUSY);
+    Telemetry.count(STAT_LINK_BUSY);
+    Error.set(TIMEOUT_ERROR);
+    return;
+  }
+
   /* These par_puts are in conditionals to prevent getting stuck receiving ACK
    * if there was a transmit error.
    */
   uint16_t err = 0;
-  if (err = par_put(packetHead, HEADER_LENGTH)) {
-    Serial.print(F("Error sending head: "));
-    Serial.println(err);
-  } else if (err = par_put(data, length)) {
-    Serial.print(F("Error sending data: "));
-    Serial.println(err);
-  } else if (err = par_put(packetChecksum, CHECKSUM_LENGTH)) {
-    Serial.print(F("Error sending checksum: "));
-    Serial.println(err);
+  if ((err = par_put(packetHead, HEADER_LENGTH))) {
+    Debug.print(F("Error sending head: "));
+    Debug.println(err);
+    TRACE(TRACE_ERRORS, TRACE_EVENT_SEND_ERROR, 0, err);
+  } else if ((err = par_put(prefix, prefixLength))) {
+    Debug.print(F("Error sending data: "));
+    Debug.println(err);
+    TRACE(TRACE_ERRORS, TRACE_EVENT_SEND_ERROR, 1, err);
+  } else if ((err = par_put(data, length))) {
+    Debug.print(F("Error sending data: "));
+    Debug.println(err);
+    TRACE(TRACE_ERRORS, TRACE_EVENT_SEND_ERROR, 2, err);
+  } else if ((err = par_put(packetChecksum, CHECKSUM_LENGTH))) {
+    Debug.print(F("Error sending checksum: "));
+    Debug.println(err);
+    TRACE(TRACE_ERRORS, TRACE_EVENT_SEND_ERROR, 3, err);
   } else {
-    //Serial.println(F("Sent reply"));
-
     //Receive the ACK
-    receive(packetHead, HEADER_LENGTH);
-    //Serial.println(F("Received ACK"));
+    bool acknowledged = false;
+    for (uint8_t i = 0; i < ACK_RETRIES && !acknowledged; i++) {
+      acknowledged = !par_get(packetHead, HEADER_LENGTH);
+    }
+    if (acknowledged) {
+      Telemetry.count(STAT_PACKETS_SENT);
+      Telemetry.add(STAT_BYTES_SENT, totalLength);
+    } else {
+      Telemetry.count(STAT_ACK_TIMEOUTS);
+    }
   }
+  if (err) {
+    Telemetry.count(STAT_SEND_TIMEOUTS);
+  }
+
+  resume();
 #if SERIAL_DEBUG_ENABLED
   }
 #endif
@@ -147,154 +462,872 @@ void LinkClass::send(uint8_t commandID) {
   packetHead[1] = commandID;
   packetHead[2] = 0;
   packetHead[3] = 0;
-  par_put(packetHead, HEADER_LENGTH);
 
-  Serial.print(F("Sent: "));
+  if (pause()) {
+    par_put(packetHead, HEADER_LENGTH);
+    resume();
+  }
+
+  Debug.print(F("Sent: "));
+#if !TRACE_ENABLED
   printHex(packetHead, HEADER_LENGTH);
-  Serial.println();
+#endif
+  Debug.println();
+  TRACE(TRACE_PACKETS, TRACE_EVENT_SENT_ID, commandID);
+}
+
+/**
+ * collect - Gathers the data of every send() into a buffer instead of sending
+ * it, until collected() is called. Used to answer a batch of commands with one
+ * packet.
+ *
+ * Parameters:
+ *    uint8_t *buffer: where to put the replies
+ *    uint16_t size: the length of buffer
+ *
+ * Each reply is stored as a length byte followed by the reply data. With a
+ * size of 0, replies are dropped without an error.
+ */
+void LinkClass::collect(uint8_t *buffer, uint16_t size) {
+  replyBuffer = buffer;
+  replySize = size;
+  replyLength = 0;
+}
 
-  //Receive the ACK
-  //par_get(packetHead, HEADER_LENGTH);
+/**
+ * collected - Stops gathering replies; send() goes to the calculator again.
+ *
+ * Returns:
+ *    uint16_t length: the number of bytes put in the buffer given to collect()
+ */
+uint16_t LinkClass::collected(void) {
+  replyBuffer = NULL;
+  return replyLength;
 }
 
 /**
- * receive - Waits for a valid packet to be received and stores received data
- * in packetData.
+ * receive - Fetches the next packet queued by the receive interrupt and
+ * releases the previous one.
  *
  * Returns:
- *    uint8_t cmd: the command byte received
+ *    bool received: true if a packet is now in packetData, false if none
+ *                   was waiting
  *
- * Also handles receiving the handshake if it hasn't already been received.
+ * Packets that came from the serial debug port set SERIAL_DIAGNOSTICS_STATUS
+ * so that replies are printed instead of sent to the calculator.
  */
+bool LinkClass::receive(void) {
+  uint16_t write;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    rxRead = rxNext; //Release the previous packet
+    if (rxRead == rxWrite && rxOwner == OWNER_NONE) {
+      //Empty. Start over at the beginning so a full-length packet fits.
+      rxRead = rxWrite = rxNext = 0;
+    }
+    write = rxWrite;
+  }
+  unstall();
 
-uint8_t LinkClass::receive(void) {
-  bool keepWaiting = true;
-  while (keepWaiting) {
-    resetLines();
-    
-    //At first, only get the header so we know the length of the data (if any)
-    receive(packetHead, HEADER_LENGTH);
-    
-    Serial.print(F("Received: "));
-    printHex(packetHead, HEADER_LENGTH);
+  if (rxNext == write) {
+    return false; //Nothing waiting
+  }
+
+  uint16_t read = rxNext;
+  if (RX_BUFFER_LENGTH - read < RECORD_HEADER_LENGTH ||
+      rxBuffer[read] == RECORD_WRAP) {
+    read = 0; //The next record was placed at the start of the buffer
+  }
+
+  uint8_t flags = rxBuffer[read + 1] & (RECORD_FROM_SERIAL | RECORD_STREAMED);
+  packetLength = rxBuffer[read] | (rxBuffer[read + 1] & ~flags) << 8;
+  packetData = &rxBuffer[read + RECORD_HEADER_LENGTH];
+  packetStreamed = flags & RECORD_STREAMED;
+  rxNext = read + RECORD_HEADER_LENGTH + packetLength;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    rxRead = read;
+  }
+
+  if (flags & RECORD_FROM_SERIAL) {
+    Status.set(SERIAL_DIAGNOSTICS_STATUS);
+    Debug.print(F("Debug: "));
+  } else {
+    Status.clear(SERIAL_DIAGNOSTICS_STATUS);
+    Debug.print(F("Received: "));
+  }
+#if !TRACE_ENABLED
+  printHex(packetData, packetLength);
+#endif
+  Debug.println();
+  TRACE(TRACE_PACKETS, TRACE_EVENT_RECEIVED,
+      packetLength ? packetData[0] : 0, packetLength);
+
+  return true;
+}
+
+/**
+ * lockSink - Keeps the link and the serial port from streaming into the
+ * universe, so the main loop can use the sink itself (for cues). Packets
+ * that arrive meanwhile wait, as they do for a full ring buffer.
+ *
+ * Returns:
+ *    bool locked: false if a packet or serial line is being received, in
+ *                 which case the sink may be in use and the caller must try
+ *                 again later
+ */
+bool LinkClass::lockSink(void) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (rxOwner != OWNER_NONE) {
+      return false;
+    }
+    rxOwner = OWNER_LOOP;
+  }
+  return true;
+}
+
+/**
+ * unlockSink - Lets the link and the serial port use the sink again after
+ * lockSink().
+ */
+void LinkClass::unlockSink(void) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    rxOwner = OWNER_NONE;
+  }
+  unstall();
+}
+
+/**
+ * edge - Advances the link state machine after a change on either line.
+ *
+ * Called from the pin change interrupt (or with interrupts disabled). Each
+ * call does at most one step of the bit handshake, so it never waits on the
+ * calculator.
+ */
+void LinkClass::edge(void) {
+  uint8_t v = lines();
+
+  switch (lineState) {
+    case LINE_RX_BIT: {
+      if (rxStalled || (FAULT(LINK_FAULT_DEAF) && rxPhase != RX_HEADER)) {
+        return; //Hold the calculator off until there is room (or it times out)
+      }
+      if (v != 0x03 && rxPhase == RX_HEADER && rxIndex == 0 && bitCount == 0) {
+        rxStart = micros(); //The first bit of a packet
+      }
+      if (v == 0x01) {
+        //Ring pulled: a 1. Acknowledge with tip.
+        shiftByte = (shiftByte >> 1) | 0x80;
+        Tip::pull();
+        lineState = LINE_RX_ONE;
+      } else if (v == 0x02) {
+        //Tip pulled: a 0. Acknowledge with ring.
+        shiftByte >>= 1;
+        Ring::pull();
+        lineState = LINE_RX_ZERO;
+      } else {
+        return; //Idle or both low; nothing to do
+      }
+      break;
+    }
+
+    case LINE_RX_ONE:
+    case LINE_RX_ZERO: {
+      //Wait for the calculator to release its line
+      if (!(v & (lineState == LINE_RX_ONE ? 0x02 : 0x01))) {
+        return;
+      }
+      resetLines();
+      lineState = LINE_RX_BIT;
+      if (++bitCount == 8) {
+        bitCount = 0;
+        receivedByte(shiftByte);
+        if (lineState == LINE_TX_BIT) {
+          /* About to turn the link around. Let the calculator see the last bit
+           * released before we pull a line for the reply; the timer picks
+           * the reply up again from guardElapsed().
+           */
+          lineState = LINE_TX_GUARD;
+          OCR0B = TCNT0 + REPLY_GUARD_COUNTS;
+          TIFR0 = _BV(OCF0B); //Clear a stale match
+          TIMSK0 |= _BV(OCIE0B);
+        }
+      }
+      break;
+    }
+
+    case LINE_TX_BIT: {
+      if (v != 0x03) {
+        return; //Wait for idle lines
+      }
+      if (shiftByte & 1) {
+        Ring::pull();
+        lineState = LINE_TX_ONE;
+      } else {
+        Tip::pull();
+        lineState = LINE_TX_ZERO;
+      }
+      break;
+    }
+
+    case LINE_TX_ONE:
+    case LINE_TX_ZERO: {
+      //Wait for the calculator to acknowledge with the other line
+      if (v & (lineState == LINE_TX_ONE ? 0x01 : 0x02)) {
+        return;
+      }
+      resetLines();
+      lineState = (lineState == LINE_TX_ONE) ? LINE_TX_ONE_DONE :
+          LINE_TX_ZERO_DONE;
+      break;
+    }
 
-    uint16_t length = packetHead[2] | packetHead[3] << 8;
-    
-    if(packetHead[1] == CMD_RDY) { //Ready check - required once at startup
-      Serial.println();
-      Status.set(RECEIVED_HANDSHAKE_STATUS);
-      send(CMD_ACK);
-    } else if (Status.test(RECEIVED_HANDSHAKE_STATUS) &&
-        packetHead[1] == CMD_DATA) { //Data packet - everything after RDY
-      //Data packet should always contain data, but check to be safe
-      if (length) {
-        receive(packetData, length);
-        printHex(packetData, length);
-
-        receive(packetChecksum, CHECKSUM_LENGTH);
-        printHex(packetChecksum, CHECKSUM_LENGTH);
-
-        uint16_t receivedChksm = packetChecksum[0] | packetChecksum[1] << 8;
-        uint16_t calculatedChksm = checksum(packetData, length);
-
-        Serial.println();
-
-        if (calculatedChksm == receivedChksm) {
-          //Checksum is valid. Acknowledge the packet.
-          send(CMD_ACK);
-          //Stop waiting and return
-          keepWaiting = false;
-        } else {
-          Serial.print(F("Error: expected checksum: "));
-          Serial.println(calculatedChksm, HEX);
-          send(CMD_ERR);
+    case LINE_TX_ONE_DONE:
+    case LINE_TX_ZERO_DONE: {
+      //Wait for the calculator to release its line
+      if (!(v & (lineState == LINE_TX_ONE_DONE ? 0x01 : 0x02))) {
+        return;
+      }
+      shiftByte >>= 1;
+      lineState = LINE_TX_BIT;
+      if (++bitCount == 8) {
+        bitCount = 0;
+        if (++txIndex == HEADER_LENGTH) {
+          lineState = LINE_RX_BIT; //Reply done; back to receiving
+          break;
         }
+        shiftByte = txHead[txIndex];
+      }
+      lastEdge = micros();
+      edge(); //The lines are idle, so start the next bit right away
+      return;
+    }
+
+    default: {
+      return; //Paused, or waiting out the reply guard
+    }
+  }
+
+  lastEdge = micros();
+}
+
+/**
+ * guardElapsed - Starts the reply once REPLY_GUARD_TIME has passed. Called
+ * from the timer 0 compare B interrupt.
+ */
+void LinkClass::guardElapsed(void) {
+  TIMSK0 &= ~_BV(OCIE0B);
+  if (lineState == LINE_TX_GUARD) {
+    lineState = LINE_TX_BIT;
+    lastEdge = micros();
+    edge(); //The lines are idle, so the first bit goes out now
+  }
+}
+
+/**
+ * receivedByte - Feeds a received byte to the packet assembler.
+ *
+ * Parameter:
+ *    uint8_t byte: the byte received
+ */
+void LinkClass::receivedByte(uint8_t byte) {
+  switch (rxPhase) {
+    case RX_HEADER: {
+      rxHead[rxIndex++] = byte;
+      if (rxIndex < HEADER_LENGTH) {
+        break;
+      }
+      rxIndex = 0;
+      rxLength = rxHead[2] | rxHead[3] << 8;
+      rxSum = 0;
+      rxDest = NULL;
+      rxSinking = false;
+
+      if (rxHead[1] == CMD_RDY) { //Ready check - required once at startup
+        Status.set(RECEIVED_HANDSHAKE_STATUS);
+        measure();
+        startReply(CMD_ACK);
+      } else if (rxLength == 0) {
+        if (rxHead[1] == CMD_STREAM_SYNC) {
+          receivedStreamPacket(); //A sync with no data; just answer it
+        } else if (rxHead[1] != CMD_ACK && rxHead[1] != CMD_DATA &&
+            rxHead[1] != CMD_STREAM) {
+          startReply(CMD_SKIP_EXIT); //Unrecognized packet
+        }
+      } else {
+        //Stream packets start with a sequence number that isn't stored
+        bool stream = rxHead[1] == CMD_STREAM || rxHead[1] == CMD_STREAM_SYNC;
+        rxStoreLength = stream ? rxLength - 1 : rxLength;
+        if (Status.test(RECEIVED_HANDSHAKE_STATUS) &&
+            (rxHead[1] == CMD_DATA || stream) && rxStoreLength > 0) {
+#if LINK_FAULTS_ENABLED
+          rxFault = LINK_FAULT_NONE;
+          if (faultCount) {
+            faultCount--;
+            rxFault = faultType;
+            faultStart = micros();
+            faultRecovering = true;
+          }
+#endif
+          //Data packet - queue it
+          if (FAULT(LINK_FAULT_STALL) || !claim()) {
+            rxStalled = true; //No room yet; unstall() will pick it up
+            Telemetry.count(STAT_RX_STALLS);
+          }
+        }
+        rxPhase = RX_DATA;
+      }
+      break;
+    }
+
+    case RX_DATA: {
+      //Packets with nowhere to go are still read, just not stored
+      uint16_t i = rxIndex;
+      if (rxStoreLength != rxLength) {
+        //Stream packet; the first byte is the sequence number
+        if (i == 0) {
+          rxSequence = byte;
+          if (rxSinking && !inSequence()) {
+            dropSink(); //It will be dropped, so keep it out of the universe
+          }
+        }
+        i--;
+      }
+      if (!rxDest || i >= rxStoreLength) {
+        //Not stored
+      } else if (!rxSinking) {
+        rxDest[i] = byte;
+      } else if (i > 0) {
+        Sink.write(byte);
+      } else if (Sink.streamable(byte) && Sink.begin(byte)) {
+        rxDest[0] = byte;
+      } else {
+        dropSink(); //Too long to queue and can't be undone exactly
+      }
+      rxSum += byte;
+      if (++rxIndex == rxLength) {
+        rxIndex = 0;
+        rxPhase = RX_CHECKSUM;
       }
-    } else if (packetHead[1] == CMD_ACK) {
-      //Somehow we are receiving an ACK when we aren't supposed to.
-      //Accept it anyway (nothing to do).
+      break;
+    }
+
+    case RX_CHECKSUM: {
+      rxChecksum[rxIndex++] = byte;
+      if (rxIndex < CHECKSUM_LENGTH) {
+        break;
+      }
+      if (FAULT(LINK_FAULT_CHECKSUM)) {
+        rxChecksum[0] = ~rxChecksum[0];
+      }
+      if (FAULT(LINK_FAULT_SILENT)) {
+        //Drop it without a reply, so the calculator waits for one
+        rxPhase = RX_HEADER;
+        rxIndex = 0;
+        if (rxDest) {
+          finishSink(false, 0);
+          rxOwner = OWNER_NONE;
+        }
+      } else {
+        receivedPacket();
+      }
+      break;
+    }
+  }
+}
+
+/**
+ * receivedPacket - Queues or discards a fully received packet and replies.
+ */
+void LinkClass::receivedPacket(void) {
+  rxPhase = RX_HEADER;
+  rxIndex = 0;
+
+  if (rxHead[1] == CMD_ACK) {
+    //Somehow we are receiving an ACK when we aren't supposed to.
+    //Accept it anyway (nothing to do).
+  } else if ((rxHead[1] == CMD_STREAM || rxHead[1] == CMD_STREAM_SYNC) &&
+      Status.test(RECEIVED_HANDSHAKE_STATUS)) {
+    receivedStreamPacket();
+  } else if (rxHead[1] != CMD_DATA ||
+      !Status.test(RECEIVED_HANDSHAKE_STATUS)) {
+    //Either we haven't received the handshake yet or the packet type wasn't
+    //recognized. Send a NAK to indicate the packet was ignored.
+    Telemetry.count(STAT_PACKETS_DROPPED);
+    startReply(CMD_SKIP_EXIT);
+  } else if (rxSum != (rxChecksum[0] | rxChecksum[1] << 8) || !rxDest) {
+    if (rxDest) {
+      finishSink(false, 0);
+      rxOwner = OWNER_NONE; //Drop the reserved record
+    }
+    countBad();
+    Error.set(BAD_PACKET_ERROR);
+    startReply(CMD_ERR);
+  } else {
+    //Checksum is valid. Queue and acknowledge the packet.
+    if (rxSinking) {
+      finishSink(true, 0);
     } else {
-      /* Either we haven't received the handshake yet or the packet type wasn't
-       * recognized.
-       */
-      //Eat the rest of the packet
-      if (length) {
-        receive(packetData, length);
-        receive(packetChecksum, CHECKSUM_LENGTH);
+      commit(rxLength, 0);
+    }
+    rxOwner = OWNER_NONE;
+    countAccepted();
+    startReply(CMD_ACK);
+    streamSynced = false; //A plain packet ends any stream session
+    streamLost = false;
+  }
+}
+
+/**
+ * receivedStreamPacket - Queues or drops a stream packet, and answers it if
+ * it ends a window.
+ *
+ * The first good stream packet of a session is accepted whatever its sequence
+ * number. After that only the expected number is accepted; once a packet is
+ * lost, the ones after it are dropped until the sender goes back to it.
+ */
+void LinkClass::receivedStreamPacket(void) {
+  if (rxLength > 0) {
+    bool accepted = inSequence();
+    bool good = rxSum == (rxChecksum[0] | rxChecksum[1] << 8) &&
+        (rxDest || rxStoreLength == 0 || !accepted);
+    finishSink(good && accepted, 0);
+    if (good && accepted) {
+      if (rxDest && !rxSinking) {
+        commit(rxStoreLength, 0);
       }
-      //Send a NAK to indicate the packet was ignored.
-      send(CMD_SKIP_EXIT);
-      Serial.println(F("Sent NAK"));
+      streamExpected = rxSequence + 1;
+      streamSynced = true;
+      countAccepted();
+    } else {
+      if (!good) {
+        countBad();
+        Error.set(BAD_PACKET_ERROR);
+      } else {
+        Telemetry.count(STAT_PACKETS_DROPPED); //Out of sequence
+      }
+      streamLost = true;
+    }
+    if (rxDest) {
+      rxOwner = OWNER_NONE; //Release the record if it wasn't committed
     }
   }
 
-  Serial.println();
+  if (rxHead[1] == CMD_STREAM_SYNC) {
+    startReply(streamLost ? CMD_ERR : CMD_ACK, streamExpected);
+    streamLost = false;
+  }
+}
+
+/**
+ * countBad - Counts a whole packet that wasn't accepted, as a checksum error
+ * or (if it had nowhere to go) as dropped.
+ */
+void LinkClass::countBad(void) {
+  if (rxSum != (rxChecksum[0] | rxChecksum[1] << 8)) {
+    Telemetry.count(STAT_CHECKSUM_ERRORS);
+  } else {
+    Telemetry.count(STAT_PACKETS_DROPPED);
+  }
+}
+
+/**
+ * countAccepted - Counts a link packet that was queued or streamed. After an
+ * injected fault, also records how long it took to get a packet through.
+ */
+void LinkClass::countAccepted(void) {
+  Telemetry.count(STAT_PACKETS_RECEIVED);
+  Telemetry.add(STAT_BYTES_RECEIVED, rxLength);
+#if LINK_FAULTS_ENABLED
+  if (faultRecovering) {
+    recoveryTime = micros() - faultStart;
+    faultRecovering = false;
+  }
+#endif
+}
+
+/**
+ * measure - Works out the calculator's bit time from the header just
+ * received, and sets the timeouts from it.
+ *
+ * The header is sent back to back, so its length over its 32 bits is the
+ * time a bit really takes, handshake and byte overhead included.
+ */
+void LinkClass::measure(void) {
+  uint32_t time = (micros() - rxStart) / (HEADER_LENGTH * 8);
+  bitTime = time > 0xFFFF ? 0xFFFF : time;
+  bitTimeout = constrain((uint32_t)bitTime * BIT_TIMEOUT_BITS,
+      MIN_BIT_TIMEOUT, BIT_TIMEOUT);
+  rxTimeout = constrain((uint32_t)bitTime * RX_TIMEOUT_BITS,
+      MIN_RX_TIMEOUT, RX_TIMEOUT);
+}
+
+/**
+ * inSequence - Checks whether the stream packet being received would be
+ * accepted, going by its sequence number.
+ */
+bool LinkClass::inSequence(void) {
+  return !streamLost && (!streamSynced || rxSequence == streamExpected);
+}
+
+/**
+ * startReply - Starts sending a TI command packet from the interrupt.
+ *
+ * Parameters:
+ *    uint8_t commandID: the command ID byte to send
+ *    uint8_t arg: the third header byte (normally 0)
+ */
+void LinkClass::startReply(uint8_t commandID, uint8_t arg) {
+  txHead[0] = MACHINE_ID;
+  txHead[1] = commandID;
+  txHead[2] = arg;
+  txHead[3] = 0;
+  txIndex = 0;
+  bitCount = 0;
+  shiftByte = txHead[0];
+  lineState = LINE_TX_BIT;
+  //edge() sends the first bit once the calculator releases the lines
+}
+
+/**
+ * reserve - Finds room in the ring buffer for a record.
+ *
+ * Parameter:
+ *    uint16_t length: the length of the packet data
+ * Returns:
+ *    uint8_t *data: where to write the packet data, or NULL if there is no
+ *                   room yet
+ *
+ * Records are never split across the end of the buffer. Must be called with
+ * interrupts disabled.
+ */
+uint8_t *LinkClass::reserve(uint16_t length) {
+  uint16_t need = length + RECORD_HEADER_LENGTH;
+  uint16_t read = rxRead;
+  uint16_t write = rxWrite;
+
+  if (write >= read) {
+    if (RX_BUFFER_LENGTH - write >= need) {
+      rxRecord = write;
+    } else if (read > need) {
+      rxRecord = 0; //Wrap around
+    } else {
+      return NULL;
+    }
+  } else if (read - write > need) {
+    rxRecord = write;
+  } else {
+    return NULL;
+  }
 
-  return packetData[0];
+  return &rxBuffer[rxRecord + RECORD_HEADER_LENGTH];
 }
 
 /**
- * receive - Waits to receive the specified length of data successfully.
+ * commit - Makes the reserved record visible to receive().
  *
  * Parameters:
- *    uint8_t *data: a pointer to store the received data
- *    uint16_t length: the length of data to receive
+ *    uint16_t length: the actual length of the packet data
+ *    uint8_t flags: RECORD_FROM_SERIAL or 0
  *
- * Retries receiving until the transmission doesn't time out.
- * Also manages the timeouts and serial debug processing since this function
- * gets called about once per second.
+ * Must be called with interrupts disabled.
  */
+void LinkClass::commit(uint16_t length, uint8_t flags) {
+  uint16_t write = rxWrite;
+  if (rxRecord != write && RX_BUFFER_LENGTH - write >= RECORD_HEADER_LENGTH) {
+    //Tell the reader to skip to the start of the buffer
+    rxBuffer[write] = RECORD_WRAP;
+    rxBuffer[write + 1] = RECORD_WRAP;
+  }
+  rxBuffer[rxRecord] = length & 0xFF;
+  rxBuffer[rxRecord + 1] = (length >> 8) | flags;
+  rxWrite = rxRecord + RECORD_HEADER_LENGTH + length;
+}
 
-void LinkClass::receive(uint8_t *data, uint16_t length) {
-  //Serial variables
-  uint8_t byte = 0;
-  uint16_t validCharsRead = 0;
-  uint16_t validBytesRead = 0;
+/**
+ * claim - Takes a record in the ring buffer for the packet whose header was
+ * just received.
+ *
+ * Returns:
+ *    bool claimed: true if the packet has somewhere to go, false if it must
+ *                  wait for the main loop
+ *
+ * A packet too long to queue gets a streamed record instead, once the main
+ * loop has handled everything before it (so the channels it writes are never
+ * overwritten by an older command) and the last commit has gone out (so
+ * Sink.streamable() lets it through). Must be called with interrupts
+ * disabled.
+ */
+bool LinkClass::claim(void) {
+  if (rxOwner != OWNER_NONE) {
+    return false;
+  }
+  if (rxStoreLength <= RX_QUEUE_LENGTH) {
+    rxDest = reserve(rxStoreLength);
+  } else if (rxRead == rxWrite && !DmxSimple.committing()) {
+    rxDest = reserve(STREAMED_LENGTH);
+    rxSinking = rxDest != NULL;
+  }
+  if (!rxDest) {
+    return false;
+  }
+  rxOwner = OWNER_LINK;
+  return true;
+}
 
-  while (par_get(data, length)) {
-    manageTimeouts();
+/**
+ * dropSink - Stops a packet that was going to be streamed into the universe
+ * before any of it is written, so it is read but not kept. Must be called
+ * with interrupts disabled.
+ */
+void LinkClass::dropSink(void) {
+  rxSinking = false;
+  rxDest = NULL;
+  rxOwner = OWNER_NONE;
+}
 
-#if SERIAL_DEBUG_ENABLED
-    //Get any serial data, converting chars to hex bytes
-    while (Serial.available()) {
-      char nextChar = Serial.read();
-      if (nextChar >= '0' && nextChar <= '9') {
-        byte <<= 4;
-        byte |= (nextChar - '0');
-        validCharsRead++;
-      } else if (nextChar >= 'A' && nextChar <= 'F') {
-        byte <<= 4;
-        byte |= (nextChar - 'A' + 10);
-        validCharsRead++;
-      } else if (nextChar >= 'a' && nextChar <= 'f') {
-        byte <<= 4;
-        byte |= (nextChar - 'a' + 10);
-        validCharsRead++;
-      } else if (nextChar == '\n') {
-        //This is the end of the transmission. Process the data.
-        //Serial.print(F("Received command: "));
-        //Serial.println(packetData[0], HEX);
-        Serial.print(F("Debug: "));
-        printHex(packetData, validBytesRead);
-        Serial.println();
-        Status.set(SERIAL_DIAGNOSTICS_STATUS);
-        processCommand(packetData[0]);
-        Status.clear(SERIAL_DIAGNOSTICS_STATUS);
-        validBytesRead = 0;
-        validCharsRead = 0;
-        continue;
-      } else {
-        //Invalid character. Skip adding the byte.
-        continue;
+/**
+ * finishSink - Ends a packet that was streamed into the universe.
+ *
+ * Parameters:
+ *    bool good: true to queue its streamed record, false to drop it and put
+ *               the channels it wrote back as they were last committed
+ *    uint8_t flags: RECORD_FROM_SERIAL or 0
+ *
+ * Does nothing if the packet wasn't streamed. Must be called with interrupts
+ * disabled.
+ */
+void LinkClass::finishSink(bool good, uint8_t flags) {
+  uint8_t *record = flags & RECORD_FROM_SERIAL ? serialData : rxDest;
+  bool sinking = flags & RECORD_FROM_SERIAL ? serialSinking : rxSinking;
+  if (!sinking) {
+    return;
+  }
+  if (!good) {
+    Sink.undo();
+  }
+  record[1] = Sink.end();
+  if (good) {
+    commit(STREAMED_LENGTH, flags | RECORD_STREAMED);
+  }
+}
+
+/**
+ * unstall - Resumes a packet that was held off for lack of buffer space.
+ */
+void LinkClass::unstall(void) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+#if LINK_FAULTS_ENABLED
+    if (FAULT(LINK_FAULT_STALL) &&
+        micros() - faultStart < LINK_FAULT_STALL_TIME) {
+      return; //Still holding it off on purpose
+    }
+#endif
+    if (rxStalled && claim()) {
+      rxStalled = false;
+      lastEdge = micros();
+      edge(); //The calculator may already be waiting on a bit
+    }
+  }
+}
+
+/**
+ * reset - Abandons any packet in progress and returns to waiting for a
+ * header. Must be called with interrupts disabled.
+ */
+void LinkClass::reset(void) {
+  resetLines();
+  TIMSK0 &= ~_BV(OCIE0B); //No reply to start
+  lineState = LINE_RX_BIT;
+  bitCount = 0;
+  shiftByte = 0;
+  if (rxPhase == RX_DATA && rxHead[1] == CMD_STREAM) {
+    streamLost = true; //Cut short, so the sender has to come back to it
+  }
+  rxPhase = RX_HEADER;
+  rxIndex = 0;
+  rxStalled = false;
+#if LINK_FAULTS_ENABLED
+  rxFault = LINK_FAULT_NONE;
+#endif
+  if (rxOwner == OWNER_LINK) {
+    finishSink(false, 0);
+    rxOwner = OWNER_NONE;
+  }
+  rxSinking = false;
+  lastEdge = micros();
+}
+
+/**
+ * pause - Waits for the receiver to be between packets and takes over the
+ * lines for a blocking send.
+ *
+ * Returns:
+ *    bool paused: true if the lines are ours, false if the receiver stayed
+ *                 busy for too long
+ */
+bool LinkClass::pause(void) {
+  uint32_t start = millis();
+  while (millis() - start < PAUSE_TIMEOUT) {
+    expire(); //Don't wait out a packet that has already stopped
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      if (lineState == LINE_RX_BIT && rxPhase == RX_HEADER && rxIndex == 0 &&
+          bitCount == 0 && lines() == 0x03) {
+        lineState = LINE_PAUSED;
+        LINK_PROBE_HIGH();
+        return true;
       }
-      if (validCharsRead > 0 && validCharsRead % 2 == 0) {
-        packetData[validBytesRead] = byte;
-        validBytesRead++;
-        byte = 0;
+    }
+  }
+  return false;
+}
+
+/**
+ * resume - Hands the lines back to the receive interrupt after a send.
+ */
+void LinkClass::resume(void) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    reset();
+    LINK_PROBE_LOW();
+  }
+}
+
+/**
+ * parseSerial - Reads hex commands from the serial port into the ring buffer.
+ *
+ * Each line of hex digits becomes one packet, as if it had been received from
+ * the calculator. Once a line's first byte is read, link packets wait for it.
+ * Lines are only started once the main loop has handled everything queued
+ * before them, so channel data commands can be streamed straight into the
+ * universe like long link packets (the length of a line isn't known in
+ * advance). A line that stops for SERIAL_LINE_TIMEOUT before its newline is
+ * dropped, so a lost newline doesn't hold up the calculator.
+ */
+void LinkClass::parseSerial(void) {
+  if ((serialData || serialChars) && !Serial.available() &&
+      (uint16_t)millis() - serialLast > SERIAL_LINE_TIMEOUT) {
+    endSerialLine(false);
+    Debug.println(F("Error: serial line timed out"));
+  }
+  if (serialChars == 2 && !serialData && !storeSerial()) {
+    return; //Still no room for the first byte
+  }
+
+  while (Serial.available()) {
+    char nextChar = Serial.read();
+    serialLast = millis();
+    if (nextChar >= '0' && nextChar <= '9') {
+      serialByte <<= 4;
+      serialByte |= (nextChar - '0');
+    } else if (nextChar >= 'A' && nextChar <= 'F') {
+      serialByte <<= 4;
+      serialByte |= (nextChar - 'A' + 10);
+    } else if (nextChar >= 'a' && nextChar <= 'f') {
+      serialByte <<= 4;
+      serialByte |= (nextChar - 'a' + 10);
+    } else if (nextChar == '\n') {
+      //This is the end of the transmission. Queue the data.
+      endSerialLine(true);
+      continue;
+    } else {
+      //Invalid character. Skip adding the byte.
+      continue;
+    }
+    if (++serialChars % 2 == 0 && !storeSerial()) {
+      return; //No room yet; leave the rest in the serial buffer
+    }
+  }
+}
+
+/**
+ * storeSerial - Adds the byte just read from the serial port to the line's
+ * packet, reserving the ring buffer for the line at its first byte.
+ *
+ * Returns:
+ *    bool stored: true if the byte was used, false if the ring buffer is busy
+ *                 and the byte must wait
+ */
+bool LinkClass::storeSerial(void) {
+  if (!serialData) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      if (rxOwner == OWNER_NONE && rxRead == rxWrite &&
+          (serialData = reserve(RX_QUEUE_LENGTH))) {
+        rxOwner = OWNER_SERIAL;
       }
     }
-#endif
+    if (!serialData) {
+      return false;
+    }
+  }
+
+  if (serialSinking) {
+    Sink.write(serialByte);
+  } else if (serialLength < RX_QUEUE_LENGTH) {
+    //Channel data is streamed from its first byte, or if a commit is still
+    //going out, queued until it has gone and then streamed from there
+    serialData[serialLength++] = serialByte;
+    bool first = serialLength == 1;
+    if ((first || serialWaiting) && !DmxSimple.committing()) {
+      serialWaiting = false;
+      sinkSerial();
+    } else if (first) {
+      serialWaiting = true;
+    }
+  } else {
+    serialLength = RX_QUEUE_LENGTH + 1; //Too long to queue; dropped at its end
+  }
+  serialByte = 0;
+  return true;
+}
+
+/**
+ * sinkSerial - Starts streaming the serial line into the universe if
+ * Sink.streamable() lets it, passing the sink the bytes queued so far.
+ * Otherwise the line stays queued.
+ */
+void LinkClass::sinkSerial(void) {
+  uint8_t cmd = serialData[0];
+  if (!Sink.streamable(cmd) || !Sink.begin(cmd)) {
+    return;
+  }
+  for (uint16_t i = 1; i < serialLength; i++) {
+    Sink.write(serialData[i]);
+  }
+  serialLength = 1;
+  serialSinking = true;
+}
+
+/**
+ * endSerialLine - Finishes the serial line being read and hands the ring
+ * buffer back to the link.
+ *
+ * Parameter:
+ *    bool good: true to queue its packet, false to drop it (as with a bad
+ *               link packet, streamed channels aren't committed)
+ */
+void LinkClass::endSerialLine(bool good) {
+  if (good && serialLength > RX_QUEUE_LENGTH) {
+    good = false;
+    Debug.println(F("Error: serial line too long"));
+  }
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (serialData) {
+      if (serialSinking) {
+        finishSink(good, RECORD_FROM_SERIAL);
+      } else if (good) {
+        commit(serialLength, RECORD_FROM_SERIAL);
+      }
+      if (good) {
+        Telemetry.count(STAT_SERIAL_PACKETS);
+      }
+      rxOwner = OWNER_NONE;
+    }
   }
+  serialData = NULL;
+  serialLength = 0;
+  serialByte = 0;
+  serialChars = 0;
+  serialSinking = false;
+  serialWaiting = false;
+  unstall();
 }
 
 /**
@@ -313,14 +1346,80 @@ void LinkClass::printHex(const uint8_t *data, uint16_t length) {
     Serial.print(data[i], HEX);
     Serial.print(F(" "));
   }
+#else
+  (void)data;
+  (void)length;
 #endif
 }
 
+/**
+ * queueReply - Adds one reply to the collect() buffer.
+ *
+ * Parameters:
+ *    const uint8_t *prefix: a pointer to the first part of the reply
+ *    uint16_t prefixLength: the length of the first part
+ *    const uint8_t *data: a pointer to the second part
+ *    uint16_t length: the length of the second part
+ *
+ * A reply that doesn't fit is stored with length 0 and sets
+ * INVALID_VALUE_ERROR, so the replies after it keep their places.
+ */
+void LinkClass::queueReply(const uint8_t *prefix, uint16_t prefixLength,
+    const uint8_t *data, uint16_t length) {
+  uint16_t totalLength = prefixLength + length;
+  if (!replySize) {
+    return; //Replies are being dropped
+  }
+  if (replyLength >= replySize) {
+    Error.set(INVALID_VALUE_ERROR);
+    return; //Not even room for the length
+  }
+  if (totalLength > 0xFF || replyLength + 1 + totalLength > replySize) {
+    Debug.println(F("Error: reply too long for batch"));
+    Error.set(INVALID_VALUE_ERROR);
+    replyBuffer[replyLength++] = 0;
+    return;
+  }
+
+  replyBuffer[replyLength++] = totalLength;
+  memcpy(replyBuffer + replyLength, prefix, prefixLength);
+  replyLength += prefixLength;
+  memcpy(replyBuffer + replyLength, data, length);
+  replyLength += length;
+}
+
+/**
+ * Pin change interrupt for the link lines
+ */
+ISR(LINK_PCINT_vect) {
+  bool busy = LINK_PROBE_BUSY(); //Already high for a blocking send
+  LINK_PROBE_HIGH();
+  Link.edge();
+  if (!busy) {
+    LINK_PROBE_LOW();
+  }
+}
+
+/**
+ * Timer 0 compare B interrupt, for the reply guard time
+ */
+ISR(TIMER0_COMPB_vect) {
+  bool busy = LINK_PROBE_BUSY();
+  LINK_PROBE_HIGH();
+  Link.guardElapsed();
+  if (!busy) {
+    LINK_PROBE_LOW();
+  }
+}
+
 /**
  * Arduino to TI linking routines by Christopher "Kerm Martian" Mitchell
  * http://www.cemetech.net/forum/viewtopic.php?t=4771
  * Modified by ajcord to remove commented-out code, reduce oversized variables,
  * increase style consistency with the rest of the firmware, and add blinkLED().
+ * Pin access was later moved to FastPin so each handshake step is a single
+ * register instruction; the protocol itself is unchanged. The timeouts
+ * were later moved to micros() (see Deadline), and the LED to the scheduler.
  *
  * Do not modify any functionality below this line.
  */
@@ -329,10 +1428,18 @@ void LinkClass::printHex(const uint8_t *data, uint16_t length) {
  * resetLines - Resets the ports used for TI linking
  */
 void LinkClass::resetLines() {
-  pinMode(TI_RING_PIN, INPUT);           // set pin to input
-  digitalWrite(TI_RING_PIN, HIGH);       // turn on pullup resistors
-  pinMode(TI_TIP_PIN, INPUT);            // set pin to input
-  digitalWrite(TI_TIP_PIN, HIGH);        // turn on pullup resistors
+  Ring::release(); //Input with pullup
+  Tip::release();
+}
+
+/**
+ * lines - Samples both link lines at once.
+ *
+ * Returns:
+ *    uint8_t state: ring in bit 1, tip in bit 0 (0x03 when the link is idle)
+ */
+inline uint8_t LinkClass::lines(void) {
+  return (Ring::read() ? 0x02 : 0x00) | (Tip::read() ? 0x01 : 0x00);
 }
 
 /**
@@ -348,46 +1455,44 @@ void LinkClass::resetLines() {
 uint16_t LinkClass::par_put(const uint8_t *data, uint16_t length) {
   uint8_t bit;
   uint16_t j;
-  uint32_t previousMillis = 0;
+  Deadline wait;
   uint8_t byte;
 
   for(j = 0; j < length; j++) {
     byte = data[j];
 
     for (bit = 0; bit < 8; bit++) {
-      previousMillis = 0;
-      while ((digitalRead(TI_RING_PIN) << 1 | digitalRead(TI_TIP_PIN)) != 0x03) {
-        if (previousMillis++ > TIMEOUT)
+      wait.start(bitTimeout);
+      while (lines() != 0x03) {
+        if (wait.passed())
           return ERR_WRITE_TIMEOUT + j + 100 * bit;
       };
       if (byte & 1) {
-        pinMode(TI_RING_PIN, OUTPUT);
-        digitalWrite(TI_RING_PIN, LOW);
-        previousMillis = 0;
-        while (digitalRead(TI_TIP_PIN) == HIGH) {
-          if (previousMillis++ > TIMEOUT)
+        Ring::pull();
+        wait.start(bitTimeout);
+        while (Tip::read()) {
+          if (wait.passed())
             return ERR_WRITE_TIMEOUT + 10 + j + 100 * bit;
         };
 
         resetLines();
-        previousMillis = 0;
-        while (digitalRead(TI_TIP_PIN) == LOW) {
-          if (previousMillis++ > TIMEOUT)
+        wait.start(bitTimeout);
+        while (!Tip::read()) {
+          if (wait.passed())
             return ERR_WRITE_TIMEOUT + 20 + j + 100 * bit;
         };
       } else {
-        pinMode(TI_TIP_PIN, OUTPUT);
-        digitalWrite(TI_TIP_PIN, LOW); //should already be set because of the pullup resistor register
-        previousMillis = 0;
-        while (digitalRead(TI_RING_PIN) == HIGH) {
-          if (previousMillis++ > TIMEOUT)
+        Tip::pull();
+        wait.start(bitTimeout);
+        while (Ring::read()) {
+          if (wait.passed())
             return ERR_WRITE_TIMEOUT + 30 + j + 100 * bit;
         };
 
         resetLines();
-        previousMillis = 0;
-        while (digitalRead(TI_RING_PIN) == LOW) {
-          if (previousMillis++ > TIMEOUT)
+        wait.start(bitTimeout);
+        while (!Ring::read()) {
+          if (wait.passed())
             return ERR_WRITE_TIMEOUT + 40 + j + 100 * bit;
         };
       }
@@ -410,42 +1515,37 @@ uint16_t LinkClass::par_put(const uint8_t *data, uint16_t length) {
 uint16_t LinkClass::par_get(uint8_t *data, uint16_t length) {
   uint8_t bit;
   uint16_t j;
-  uint32_t previousMillis = 0;
+  Deadline wait;
 
   for(j = 0; j < length; j++) {
     uint8_t v, byteout = 0;
     for (bit = 0; bit < 8; bit++) {
-      previousMillis = 0;
-      while ((v = (digitalRead(TI_RING_PIN) << 1 | digitalRead(TI_TIP_PIN))) == 0x03) {
-        LED.update(); // (ajcord) Added blinkLED() here since it needs to be called frequently
-        if (previousMillis++ > GET_ENTER_TIMEOUT)
+      //The calculator may take a while to start replying, but not mid-reply
+      wait.start(j == 0 && bit == 0 ? GET_ENTER_TIMEOUT : rxTimeout);
+      while ((v = lines()) == 0x03) {
+        if (wait.passed())
           return ERR_READ_TIMEOUT + j + 100 * bit;
       }
       if (v == 0x01) {
         byteout = (byteout >> 1) | 0x80;
-        pinMode(TI_TIP_PIN, OUTPUT);
-        digitalWrite(TI_TIP_PIN, LOW); //should already be set because of the pullup resistor register
-        previousMillis = 0;
-        while (digitalRead(TI_RING_PIN) == LOW) { //wait for the other one to go low
-          if (previousMillis++ > TIMEOUT)
+        Tip::pull();
+        wait.start(bitTimeout);
+        while (!Ring::read()) { //wait for the other one to go low
+          if (wait.passed())
             return ERR_READ_TIMEOUT + 10 + j + 100 * bit;
         }
-        digitalWrite(TI_RING_PIN,HIGH);
+        Ring::high();
       } else {
         byteout = (byteout >> 1) & 0x7F;
-        pinMode(TI_RING_PIN, OUTPUT);
-        digitalWrite(TI_RING_PIN, LOW); //should already be set because of the pullup resistor register
-        previousMillis = 0;
-        while (digitalRead(TI_TIP_PIN) == LOW) {
-          if (previousMillis++ > TIMEOUT)
+        Ring::pull();
+        wait.start(bitTimeout);
+        while (!Tip::read()) {
+          if (wait.passed())
             return ERR_READ_TIMEOUT + 20 + j + 100 * bit;
         }
-        digitalWrite(TI_TIP_PIN, HIGH);
+        Tip::high();
       }
-      pinMode(TI_RING_PIN, INPUT); //set pin to input
-      digitalWrite(TI_RING_PIN, HIGH); //turn on pullup resistors
-      pinMode(TI_TIP_PIN, INPUT); //set pin to input
-      digitalWrite(TI_TIP_PIN, HIGH); //turn on pullup resistors
+      resetLines();
     }
     data[j] = byteout;
   }
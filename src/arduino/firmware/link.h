@@ -5,7 +5,7 @@
  * This file contains the external defines and prototypes for communicating
  * with the calculator and the serial port.
  *
- * Last modified November 4, 2014
+ * Last modified October 16, 2026
  *
  *
  * Copyright (C) 2014  Alex Cordonnier
@@ -33,6 +33,8 @@
 
 #include <inttypes.h>
 
+#include "firmware.h" //For LINK_FAULTS_ENABLED
+
 /******************************************************************************
  * External constants
  ******************************************************************************/
@@ -46,14 +48,43 @@
 #define CMD_RDY               0x68
 #define CMD_EOT               0x92
 
+/* Stream packets (not part of the TI protocol). The data starts with an 8-bit
+ * sequence number, which is not passed on. CMD_STREAM packets are never
+ * answered; CMD_STREAM_SYNC packets are answered with CMD_ACK if every stream
+ * packet since the last sync was accepted, or CMD_ERR if not. Either way the
+ * third header byte of the answer is the next sequence number expected.
+ */
+#define CMD_STREAM            0x3A
+#define CMD_STREAM_SYNC       0x3B
+
 //Buffer lengths
 #define HEADER_LENGTH         4
-#define PACKET_DATA_LENGTH    513
 #define CHECKSUM_LENGTH       2
 
+/* Received packets are queued in a ring buffer of records, each made up of a
+ * 2-byte length (bit 15 set if the packet came from the serial port, bit 14
+ * if it was streamed) followed by the packet data. Channel data packets too
+ * long to queue are streamed straight into the universe as they arrive (see
+ * sink.h) and leave just a streamed record: the command byte and whether the
+ * data was valid. Any other packet must fit in the ring.
+ */
+#define RX_BUFFER_LENGTH      264
+#define RX_QUEUE_LENGTH       (RX_BUFFER_LENGTH - 2) //Longest packet queued
+
 //Serial parameters
 #define SERIAL_SPEED          9600
 
+/* Faults inject() can put on received data packets (LINK_FAULTS_ENABLED in
+ * firmware.h), so the calculator's error handling can be tested without a
+ * bad cable. Each is applied when the packet header comes in.
+ */
+#define LINK_FAULT_NONE       0
+#define LINK_FAULT_CHECKSUM   1 //Answer ERR as if the checksum was bad
+#define LINK_FAULT_SILENT     2 //Read the packet but never answer it
+#define LINK_FAULT_DEAF       3 //Stop taking bits after the header (times out)
+#define LINK_FAULT_STALL      4 //Hold the packet off as if the ring were full
+#define LINK_FAULT_STALL_TIME 200000 //How long a stall lasts (microseconds)
+
 /******************************************************************************
  * Class definition
  ******************************************************************************/
@@ -61,25 +92,134 @@
 class LinkClass {
     public:
         void begin(void);
+        void update(void);
         void send(const uint8_t *data, uint16_t length);
+        void send(const uint8_t *prefix, uint16_t prefixLength,
+            const uint8_t *data, uint16_t length);
         void send(uint8_t commandID);
-        uint8_t receive(void);
+        void collect(uint8_t *buffer, uint16_t size);
+        uint16_t collected(void);
+        bool receive(void);
+        bool lockSink(void);
+        void unlockSink(void);
+        void edge(void);
+        void guardElapsed(void);
+#if LINK_FAULTS_ENABLED
+        void inject(uint8_t fault, uint8_t count);
+        uint32_t recovery(void);
+#endif
 
-        /* These communication buffers are public so they can be reused as
-         * temporary buffers by other files. Collectively, they use over a
-         * quarter of the SRAM.
+        /* The data of the packet returned by the last call to receive(). It
+         * points into the receive ring buffer and stays valid until the next
+         * call to receive(). If packetStreamed is set, the data was already
+         * written to the universe and packetData holds the command byte and
+         * whether the data was valid.
          */
+        uint8_t *packetData;
+        uint16_t packetLength;
+        bool packetStreamed;
+
+        //Used by send() to wrap outgoing data
         uint8_t packetHead[HEADER_LENGTH];
-        uint8_t packetData[PACKET_DATA_LENGTH];
         uint8_t packetChecksum[CHECKSUM_LENGTH];
 
     private:
-        void receive(uint8_t *data, uint16_t length);
         void printHex(const uint8_t *data, uint16_t length);
         void resetLines(void);
+        bool expire(void);
+        bool pause(void);
+        void resume(void);
+        void reset(void);
+        void receivedByte(uint8_t byte);
+        void receivedPacket(void);
+        void startReply(uint8_t commandID, uint8_t arg = 0);
+        void receivedStreamPacket(void);
+        void measure(void);
+        void countBad(void);
+        void countAccepted(void);
+        bool inSequence(void);
+        bool claim(void);
+        void dropSink(void);
+        void finishSink(bool good, uint8_t flags);
+        uint8_t *reserve(uint16_t length);
+        void commit(uint16_t length, uint8_t flags);
+        void unstall(void);
+        void parseSerial(void);
+        bool storeSerial(void);
+        void sinkSerial(void);
+        void endSerialLine(bool good);
         uint16_t par_put(const uint8_t *data, uint16_t length);
         uint16_t par_get(uint8_t *data, uint16_t length);
+        uint8_t lines(void);
         uint16_t checksum(const uint8_t *data, uint16_t length);
+        void queueReply(const uint8_t *prefix, uint16_t prefixLength,
+            const uint8_t *data, uint16_t length);
+
+        //Bit level state machine (driven by the pin change interrupt)
+        volatile uint8_t lineState;
+        uint8_t bitCount;
+        uint8_t shiftByte;
+        volatile uint32_t lastEdge; //micros()
+
+        //Timing measured from the calculator's ready check (microseconds)
+        uint32_t rxStart;
+        uint16_t bitTime; //0 until measured
+        uint32_t bitTimeout;
+        uint32_t rxTimeout;
+
+        //Packet assembler
+        volatile uint8_t rxPhase;
+        uint16_t rxIndex;
+        uint16_t rxLength;
+        uint16_t rxStoreLength;
+        uint16_t rxSum;
+        uint8_t *rxDest;
+        uint8_t rxHead[HEADER_LENGTH];
+        uint8_t rxChecksum[CHECKSUM_LENGTH];
+        volatile bool rxStalled;
+        bool rxSinking; //The packet is going straight into the universe
+
+        //Stream session (see CMD_STREAM)
+        uint8_t rxSequence;
+        uint8_t streamExpected;
+        bool streamSynced;
+        bool streamLost;
+
+#if LINK_FAULTS_ENABLED
+        //Fault injection (see inject())
+        uint8_t faultType;
+        volatile uint8_t faultCount; //Packets still to fault
+        uint8_t rxFault; //The fault on the packet being received
+        bool faultRecovering; //No packet accepted since the last fault
+        uint32_t faultStart; //micros() when the last fault was applied
+        uint32_t recoveryTime;
+#endif
+
+        //Reply sent from the interrupt (ACK, ERR or SKIP/EXIT)
+        uint8_t txHead[HEADER_LENGTH];
+        uint8_t txIndex;
+
+        //Receive ring buffer
+        uint8_t rxBuffer[RX_BUFFER_LENGTH];
+        volatile uint16_t rxRead;
+        volatile uint16_t rxWrite;
+        uint16_t rxNext;
+        uint16_t rxRecord;
+        volatile uint8_t rxOwner;
+
+        //Replies gathered by collect() instead of being sent
+        uint8_t *replyBuffer;
+        uint16_t replySize;
+        uint16_t replyLength;
+
+        //Serial debug parser
+        uint8_t *serialData;
+        uint16_t serialLength;
+        uint8_t serialByte;
+        uint8_t serialChars;
+        bool serialSinking;
+        bool serialWaiting; //Queuing while a commit goes out (see storeSerial())
+        uint16_t serialLast; //millis() of the last character read
 };
 
 extern LinkClass Link;
@@ -0,0 +1,179 @@
+/**
+ * DMX-84
+ * Groups and masters code
+ *
+ * This file contains the code for channel groups, their submasters and the
+ * grand master.
+ *
+ * Groups are bitmaps of channels. Each channel is scaled at transmit time by
+ * the grand master and the submasters of every group it is in. Only the
+ * combined scale of each combination of groups is kept, so moving a master
+ * recomputes 16 scales rather than touching any channels, and each slot costs
+ * four bit tests and a multiply.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include <util/atomic.h>
+#include <DmxSimple.h>
+
+#include "master.h"
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**
+ * begin - Empties the groups and puts every master at full. Call once at
+ * power up.
+ */
+void MasterClass::begin(void) {
+  memset(groups, 0, sizeof(groups));
+  memset(submasters, 0xFF, sizeof(submasters));
+  grandMaster = 0xFF;
+  update();
+}
+
+/**
+ * setBitmap - Sets part of a group's channel bitmap.
+ *
+ * Parameters:
+ *    uint8_t group: the group number
+ *    uint8_t offset: the first bitmap byte to set
+ *    const uint8_t *bits: the bitmap bytes
+ *    uint16_t length: the number of bytes (cut off at the end of the bitmap)
+ * Returns:
+ *    bool set: false if the group or offset is invalid
+ */
+bool MasterClass::setBitmap(uint8_t group, uint8_t offset, const uint8_t *bits,
+    uint16_t length) {
+  if (group >= GROUP_COUNT || offset >= GROUP_BITMAP_LENGTH) {
+    return false;
+  }
+  if (length > GROUP_BITMAP_LENGTH - offset) {
+    length = GROUP_BITMAP_LENGTH - offset;
+  }
+  memcpy(&groups[group][offset], bits, length);
+  return true;
+}
+
+/**
+ * setRange - Adds a range of channels to a group or takes them out.
+ *
+ * Parameters:
+ *    uint8_t group: the group number
+ *    uint16_t first: the first channel
+ *    uint16_t count: the number of channels
+ *    bool member: true to add, false to remove
+ * Returns:
+ *    bool set: false if the group or range is invalid
+ */
+bool MasterClass::setRange(uint8_t group, uint16_t first, uint16_t count,
+    bool member) {
+  if (group >= GROUP_COUNT || first >= DMX_SIZE ||
+      count > DMX_SIZE - first) {
+    return false;
+  }
+  for (uint16_t i = first; i < first + count; i++) {
+    if (member) {
+      groups[group][i >> 3] |= _BV(i & 7);
+    } else {
+      groups[group][i >> 3] &= ~_BV(i & 7);
+    }
+  }
+  return true;
+}
+
+/**
+ * setSubmaster - Sets the level of a group's submaster.
+ *
+ * Parameters:
+ *    uint8_t group: the group number
+ *    uint8_t level: 0 (out) to 255 (full)
+ * Returns:
+ *    bool set: false if the group is invalid
+ */
+bool MasterClass::setSubmaster(uint8_t group, uint8_t level) {
+  if (group >= GROUP_COUNT) {
+    return false;
+  }
+  submasters[group] = level;
+  update();
+  return true;
+}
+
+/**
+ * setGrandMaster - Sets the level of the grand master.
+ *
+ * Parameter:
+ *    uint8_t level: 0 (out) to 255 (full)
+ */
+void MasterClass::setGrandMaster(uint8_t level) {
+  grandMaster = level;
+  update();
+}
+
+/**
+ * apply - Scales a level by the masters of its channel.
+ *
+ * Parameters:
+ *    uint16_t slot: the channel index (0-511)
+ *    uint8_t level: the level before the masters
+ * Returns:
+ *    uint8_t level: the scaled level
+ *
+ * Called from the DMX transmit interrupt for every slot.
+ */
+uint8_t MasterClass::apply(uint16_t slot, uint8_t level) {
+  uint8_t byte = slot >> 3;
+  uint8_t bit = _BV(slot & 7);
+  uint8_t membership = 0;
+  for (uint8_t g = 0; g < GROUP_COUNT; g++) {
+    if (groups[g][byte] & bit) {
+      membership |= _BV(g);
+    }
+  }
+  return ((uint16_t)level * (scales[membership] + 1)) >> 8;
+}
+
+/**
+ * update - Recomputes the combined scale of every group combination.
+ */
+void MasterClass::update(void) {
+  uint8_t combined[sizeof(scales)];
+  for (uint8_t membership = 0; membership < sizeof(scales); membership++) {
+    uint16_t scale = grandMaster;
+    for (uint8_t g = 0; g < GROUP_COUNT; g++) {
+      if (membership & _BV(g)) {
+        scale = (scale * (submasters[g] + 1)) >> 8;
+      }
+    }
+    combined[membership] = scale;
+  }
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    memcpy(scales, combined, sizeof(scales));
+  }
+}
+
+MasterClass Master;
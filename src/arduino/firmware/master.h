@@ -0,0 +1,74 @@
+/**
+ * DMX-84
+ * Groups and masters header
+ *
+ * This file contains the external defines and prototypes for channel groups,
+ * their submasters and the grand master.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MASTER_H
+#define MASTER_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <inttypes.h>
+
+/******************************************************************************
+ * External constants
+ ******************************************************************************/
+
+//Number of groups (each has a submaster)
+#define GROUP_COUNT           4
+
+//Bytes in a group bitmap (one bit per channel, channel 0 = bit 0 of byte 0)
+#define GROUP_BITMAP_LENGTH   64
+
+/******************************************************************************
+ * Class definition
+ ******************************************************************************/
+
+class MasterClass {
+    public:
+        void begin(void);
+        bool setBitmap(uint8_t group, uint8_t offset, const uint8_t *bits,
+            uint16_t length);
+        bool setRange(uint8_t group, uint16_t first, uint16_t count,
+            bool member);
+        bool setSubmaster(uint8_t group, uint8_t level);
+        void setGrandMaster(uint8_t level);
+        uint8_t apply(uint16_t slot, uint8_t level);
+
+    private:
+        void update(void);
+
+        uint8_t groups[GROUP_COUNT][GROUP_BITMAP_LENGTH];
+        uint8_t submasters[GROUP_COUNT];
+        uint8_t grandMaster;
+
+        //Combined scale for every combination of group memberships
+        uint8_t scales[1 << GROUP_COUNT];
+};
+
+extern MasterClass Master;
+
+#endif
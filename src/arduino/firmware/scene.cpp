@@ -0,0 +1,385 @@
+/**
+ * DMX-84
+ * Scene memory code
+ *
+ * This file contains the code for storing scenes in EEPROM and recalling them
+ * into dmxBuffer.
+ *
+ * The scene area of the EEPROM starts with a header (a magic number and a
+ * layout version), then a directory of SCENE_COUNT entries, each holding the address and length of one scene. The scenes
+ * follow, packed one after another and run-length coded with the same tokens
+ * as the 0x2A command (see codec.h), so a mostly dark universe takes only a
+ * few bytes. Deleted scenes leave holes that are compacted away when a new
+ * scene doesn't fit.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include <avr/eeprom.h>
+#include <util/atomic.h>
+#include <DmxSimple.h>
+
+#include "firmware.h"
+#include "scene.h"
+#include "codec.h"
+
+/******************************************************************************
+ * Internal constants
+ ******************************************************************************/
+
+//EEPROM layout. EEPROM that doesn't start with this header (erased, or left
+//by another sketch or an older layout) is formatted by begin().
+#define SCENE_MAGIC           0x5C84
+#define SCENE_VERSION         1
+#define SCENE_MAGIC_ADDRESS   SCENE_EEPROM_START
+#define SCENE_VERSION_ADDRESS (SCENE_EEPROM_START + 2)
+#define SCENE_HEADER_LENGTH   3 //Magic (16 bits) and version
+#define ENTRY_LENGTH          4 //Offset and length, 16 bits each
+#define SCENE_DIRECTORY_START (SCENE_EEPROM_START + SCENE_HEADER_LENGTH)
+#define SCENE_DATA_START      (SCENE_DIRECTORY_START + \
+                               SCENE_COUNT * ENTRY_LENGTH)
+#define SCENE_DATA_END        SCENE_EEPROM_END
+
+//Erased EEPROM reads as all ones, so this length means "no scene"
+#define EMPTY_LENGTH          0xFFFF
+
+//Bytes encoded at a time when storing (on the stack)
+#define STORE_CHUNK_LENGTH    32
+
+/******************************************************************************
+ * Internal function prototypes
+ ******************************************************************************/
+
+static uint16_t encodeScene(uint16_t address);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**
+ * begin - Formats the scene memory if it doesn't hold this layout. Call once
+ * at power up.
+ */
+void SceneClass::begin(void) {
+  if (eeprom_read_word((const uint16_t *)SCENE_MAGIC_ADDRESS) != SCENE_MAGIC ||
+      eeprom_read_byte((const uint8_t *)SCENE_VERSION_ADDRESS) !=
+      SCENE_VERSION) {
+    format();
+  }
+}
+
+/**
+ * store - Saves dmxBuffer as a scene, replacing any scene already there.
+ *
+ * Parameter:
+ *    uint8_t scene: the scene number
+ * Returns:
+ *    bool stored: false if the number is invalid or there isn't enough room
+ *                 (the old scene is kept in that case)
+ *
+ * Writing EEPROM takes about 3.3 ms per changed byte, so this can block for
+ * a good fraction of a second. DMX output continues in the background, and
+ * so do fades and effects (see writesEeprom() in firmware.ino).
+ *
+ * The new copy is written before the directory entry is switched to it, so a
+ * reset partway through keeps the old scene, unless the memory is too full
+ * to hold both and the old one has to go first.
+ */
+bool SceneClass::store(uint8_t scene) {
+  if (scene >= SCENE_COUNT) {
+    return false;
+  }
+  uint16_t need = encodeScene(0);
+  uint16_t space = freeSpace();
+  if (need > space + length(scene)) {
+    return false;
+  }
+
+  if (need > space) {
+    remove(scene);
+  }
+  if (SCENE_DATA_END - dataEnd() < need) {
+    compact(); //Close up the holes left by deleted scenes
+  }
+  uint16_t address = dataEnd();
+  encodeScene(address);
+  setEntry(scene, address, need);
+  return true;
+}
+
+/**
+ * recall - Copies a scene into dmxBuffer.
+ *
+ * Parameter:
+ *    uint8_t scene: the scene number
+ * Returns:
+ *    bool recalled: false if there is no such scene
+ *
+ * Starts timing the recall; see sent().
+ */
+bool SceneClass::recall(uint8_t scene) {
+  if (scene >= SCENE_COUNT || length(scene) == 0) {
+    return false;
+  }
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    recallClock = micros();
+    recallWaiting = true;
+  }
+  uint16_t address = offset(scene);
+  uint16_t end = address + length(scene);
+  uint16_t channel = 0;
+  while (address < end && channel < DMX_SIZE) {
+    uint8_t control = eeprom_read_byte((const uint8_t *)(uintptr_t)address++);
+    uint16_t count;
+    if (control & CODEC_RUN_FLAG) {
+      count = control - (CODEC_RUN_FLAG - 1);
+    } else {
+      count = control + 1;
+    }
+    if (channel + count > DMX_SIZE) {
+      count = DMX_SIZE - channel; //Corrupt scene; stay inside the universe
+    }
+
+    if (control & CODEC_RUN_FLAG) {
+      uint8_t value = eeprom_read_byte((const uint8_t *)(uintptr_t)address++);
+      for (uint16_t i = 0; i < count; i++) {
+        dmxBuffer[channel++] = value;
+      }
+    } else {
+      eeprom_read_block((void *)&dmxBuffer[channel],
+          (const void *)(uintptr_t)address, count);
+      address += count;
+      channel += count;
+    }
+  }
+  return true;
+}
+
+/**
+ * sent - Stops timing the last recall, if it is still waiting, because its
+ * look has started going out. Called from the frame callback at the frame
+ * boundary where a commit lands or a fade steps.
+ */
+void SceneClass::sent(void) {
+  if (recallWaiting) {
+    recallClock = micros() - recallClock;
+    recallWaiting = false;
+  }
+}
+
+/**
+ * recallTime - Reads how long the last recall took, from the command until
+ * the frame its look started going out in.
+ *
+ * Returns:
+ *    uint32_t time: microseconds, or 0 if the last recall hasn't been sent yet
+ *                   (or there hasn't been one)
+ */
+uint32_t SceneClass::recallTime(void) {
+  uint32_t time;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    time = recallWaiting ? 0 : recallClock;
+  }
+  return time;
+}
+
+/**
+ * remove - Deletes a scene.
+ *
+ * Parameter:
+ *    uint8_t scene: the scene number
+ * Returns:
+ *    bool removed: false if the number is invalid
+ */
+bool SceneClass::remove(uint8_t scene) {
+  if (scene >= SCENE_COUNT) {
+    return false;
+  }
+  if (length(scene) != 0) {
+    setEntry(scene, 0, EMPTY_LENGTH);
+  }
+  return true;
+}
+
+/**
+ * count - Counts the stored scenes.
+ *
+ * Returns:
+ *    uint8_t count: the number of scene slots in use
+ */
+uint8_t SceneClass::count(void) {
+  uint8_t used = 0;
+  for (uint8_t i = 0; i < SCENE_COUNT; i++) {
+    if (length(i) != 0) {
+      used++;
+    }
+  }
+  return used;
+}
+
+/**
+ * freeSpace - Finds how much scene data still fits, counting holes.
+ *
+ * Returns:
+ *    uint16_t space: the number of bytes not used by any scene
+ */
+uint16_t SceneClass::freeSpace(void) {
+  uint16_t space = SCENE_DATA_END - SCENE_DATA_START;
+  for (uint8_t i = 0; i < SCENE_COUNT; i++) {
+    if (length(i) > space) {
+      return 0; //A directory entry was torn by a reset
+    }
+    space -= length(i);
+  }
+  return space;
+}
+
+/**
+ * format - Empties the directory and writes the header. The header goes
+ * last, so a reset partway through formats again at the next power up.
+ */
+void SceneClass::format(void) {
+  eeprom_update_word((uint16_t *)SCENE_MAGIC_ADDRESS, 0xFFFF);
+  for (uint8_t i = 0; i < SCENE_COUNT; i++) {
+    setEntry(i, 0, EMPTY_LENGTH);
+  }
+  eeprom_update_byte((uint8_t *)SCENE_VERSION_ADDRESS, SCENE_VERSION);
+  eeprom_update_word((uint16_t *)SCENE_MAGIC_ADDRESS, SCENE_MAGIC);
+}
+
+/**
+ * dataEnd - Finds the end of the last scene in EEPROM.
+ *
+ * Returns:
+ *    uint16_t address: the first address after all scene data
+ */
+uint16_t SceneClass::dataEnd(void) {
+  uint16_t end = SCENE_DATA_START;
+  for (uint8_t i = 0; i < SCENE_COUNT; i++) {
+    if (length(i) != 0 && offset(i) + length(i) > end) {
+      end = offset(i) + length(i);
+    }
+  }
+  return end;
+}
+
+/**
+ * compact - Moves the scenes down to close up the holes between them.
+ */
+void SceneClass::compact(void) {
+  uint16_t cursor = SCENE_DATA_START;
+  while (true) {
+    //Find the lowest scene not yet moved
+    uint8_t next = SCENE_COUNT;
+    for (uint8_t i = 0; i < SCENE_COUNT; i++) {
+      if (length(i) != 0 && offset(i) >= cursor &&
+          (next == SCENE_COUNT || offset(i) < offset(next))) {
+        next = i;
+      }
+    }
+    if (next == SCENE_COUNT) {
+      return; //All done
+    }
+
+    uint16_t from = offset(next);
+    uint16_t size = length(next);
+    if (from != cursor) {
+      for (uint16_t i = 0; i < size; i++) {
+        eeprom_update_byte((uint8_t *)(uintptr_t)(cursor + i),
+            eeprom_read_byte((const uint8_t *)(uintptr_t)(from + i)));
+      }
+      setEntry(next, cursor, size);
+    }
+    cursor += size;
+  }
+}
+
+/**
+ * offset - Reads the address of a scene from the directory.
+ *
+ * Parameter:
+ *    uint8_t scene: the scene number
+ * Returns:
+ *    uint16_t address: where the scene data starts
+ */
+uint16_t SceneClass::offset(uint8_t scene) {
+  uint16_t entry = SCENE_DIRECTORY_START + scene * ENTRY_LENGTH;
+  return eeprom_read_word((const uint16_t *)(uintptr_t)entry);
+}
+
+/**
+ * length - Reads the length of a scene from the directory.
+ *
+ * Parameter:
+ *    uint8_t scene: the scene number
+ * Returns:
+ *    uint16_t length: the length of the scene data, or 0 if there is none
+ */
+uint16_t SceneClass::length(uint8_t scene) {
+  uint16_t entry = SCENE_DIRECTORY_START + scene * ENTRY_LENGTH;
+  uint16_t length = eeprom_read_word((const uint16_t *)(uintptr_t)(entry + 2));
+  return length == EMPTY_LENGTH ? 0 : length;
+}
+
+/**
+ * setEntry - Writes a directory entry.
+ *
+ * Parameters:
+ *    uint8_t scene: the scene number
+ *    uint16_t offset: where the scene data starts
+ *    uint16_t length: the length of the scene data, or EMPTY_LENGTH
+ */
+void SceneClass::setEntry(uint8_t scene, uint16_t offset, uint16_t length) {
+  uint16_t entry = SCENE_DIRECTORY_START + scene * ENTRY_LENGTH;
+  eeprom_update_word((uint16_t *)(uintptr_t)entry, offset);
+  eeprom_update_word((uint16_t *)(uintptr_t)(entry + 2), length);
+}
+
+/**
+ * encodeScene - Run-length codes dmxBuffer into EEPROM a chunk at a time.
+ *
+ * Parameter:
+ *    uint16_t address: where to write, or 0 to only measure
+ * Returns:
+ *    uint16_t length: the number of bytes the scene takes
+ */
+static uint16_t encodeScene(uint16_t address) {
+  uint8_t chunk[STORE_CHUNK_LENGTH];
+  uint16_t total = 0;
+  uint16_t channel = 0;
+  while (channel < DMX_SIZE) {
+    uint16_t consumed;
+    uint16_t length = Codec.encode((const uint8_t *)dmxBuffer + channel, 0,
+        DMX_SIZE - channel, address ? chunk : 0, STORE_CHUNK_LENGTH, &consumed);
+    if (address) {
+      eeprom_update_block(chunk, (void *)(uintptr_t)(address + total), length);
+    }
+    total += length;
+    channel += consumed;
+  }
+  return total;
+}
+
+SceneClass Scene;
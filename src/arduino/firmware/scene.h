@@ -0,0 +1,74 @@
+/**
+ * DMX-84
+ * Scene memory header
+ *
+ * This file contains the external defines and prototypes for storing scenes
+ * in EEPROM and recalling them into dmxBuffer.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCENE_H
+#define SCENE_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <inttypes.h>
+
+/******************************************************************************
+ * External constants
+ ******************************************************************************/
+
+//Number of scene slots (0 to SCENE_COUNT - 1)
+#define SCENE_COUNT           16
+
+/******************************************************************************
+ * Class definition
+ ******************************************************************************/
+
+class SceneClass {
+    public:
+        void begin(void);
+        bool store(uint8_t scene);
+        bool recall(uint8_t scene);
+        bool remove(uint8_t scene);
+        uint8_t count(void);
+        uint16_t freeSpace(void);
+        void sent(void);
+        uint32_t recallTime(void);
+
+    private:
+        void format(void);
+        uint16_t dataEnd(void);
+        void compact(void);
+        uint16_t offset(uint8_t scene);
+        uint16_t length(uint8_t scene);
+        void setEntry(uint8_t scene, uint16_t offset, uint16_t length);
+
+        //micros() at the last recall while it waits to be sent (see sent()),
+        //then how long it took
+        uint32_t recallClock;
+        volatile bool recallWaiting;
+};
+
+extern SceneClass Scene;
+
+#endif
@@ -0,0 +1,119 @@
+/**
+ * DMX-84
+ * Task scheduler code
+ *
+ * This file contains the code for running periodic firmware tasks from a
+ * timer tick, so nothing periodic has to be polled from the link code.
+ *
+ * The tick is the TIMER0 compare A interrupt. TIMER0 already runs millis(),
+ * so the tick comes once per overflow (1.024ms) without taking another timer.
+ * Only the compare interrupt is used, not the OC0A pin.
+ *
+ * Last modified October 15, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "Arduino.h"
+
+#include "scheduler.h"
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**
+ * begin - Empties the task slots and starts the tick. Call once at power up.
+ */
+void SchedulerClass::begin(void) {
+  count = 0;
+  OCR0A = 0x80; //Halfway between millis() overflows
+  TIMSK0 |= _BV(OCIE0A);
+}
+
+/**
+ * add - Schedules a task.
+ *
+ * Parameters:
+ *    SchedulerTask task: the function to run
+ *    uint16_t period: the time between runs in milliseconds (1-32767)
+ *    bool interrupt: TASK_IN_INTERRUPT to run it from the tick, or
+ *                    TASK_IN_LOOP to run it from run()
+ * Returns:
+ *    bool added: false if every slot is taken
+ */
+bool SchedulerClass::add(SchedulerTask task, uint16_t period, bool interrupt) {
+  if (count >= SCHEDULER_TASKS) {
+    return false;
+  }
+  Slot &slot = slots[count];
+  slot.task = task;
+  slot.period = period;
+  slot.last = millis();
+  slot.interrupt = interrupt;
+  slot.due = false;
+  count++; //Last, so the tick never sees a half set up slot
+  return true;
+}
+
+/**
+ * run - Runs the loop tasks that are due.
+ *
+ * This function should be called from every pass through loop(). A task that
+ * fell behind runs once, not once for every period it missed.
+ */
+void SchedulerClass::run(void) {
+  for (uint8_t i = 0; i < count; i++) {
+    if (slots[i].due) {
+      slots[i].due = false;
+      slots[i].task();
+    }
+  }
+}
+
+/**
+ * tick - Marks the tasks that are due and runs the interrupt tasks. Called
+ * from the timer interrupt.
+ */
+void SchedulerClass::tick(void) {
+  uint16_t now = millis();
+  for (uint8_t i = 0; i < count; i++) {
+    Slot &slot = slots[i];
+    if ((uint16_t)(now - slot.last) < slot.period) {
+      continue;
+    }
+    slot.last += slot.period;
+    if ((uint16_t)(now - slot.last) >= slot.period) {
+      slot.last = now; //Too far behind to catch up
+    }
+    if (slot.interrupt) {
+      slot.task();
+    } else {
+      slot.due = true;
+    }
+  }
+}
+
+ISR(TIMER0_COMPA_vect) {
+  Scheduler.tick();
+}
+
+SchedulerClass Scheduler;
@@ -0,0 +1,85 @@
+/**
+ * DMX-84
+ * Task scheduler header
+ *
+ * This file contains the external defines and prototypes for running periodic
+ * firmware tasks from a timer tick.
+ *
+ * Last modified October 15, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <inttypes.h>
+
+/******************************************************************************
+ * External constants
+ ******************************************************************************/
+
+//Number of task slots
+#define SCHEDULER_TASKS       4
+
+//Where a task runs
+#define TASK_IN_LOOP          false //From run(), in the main loop
+#define TASK_IN_INTERRUPT     true //From the timer tick (must be quick)
+
+/******************************************************************************
+ * External types
+ ******************************************************************************/
+
+typedef void (*SchedulerTask)(void);
+
+/******************************************************************************
+ * Class definition
+ ******************************************************************************/
+
+/* Runs tasks at fixed periods. A timer interrupt ticks about once a
+ * millisecond and marks the tasks that are due. Interrupt tasks run right
+ * away from the tick, so they keep time even while the main loop is busy
+ * (e.g. in a blocking send). Loop tasks run from the next call to run(),
+ * so they can take their time and use the link.
+ */
+class SchedulerClass {
+    public:
+        void begin(void);
+        bool add(SchedulerTask task, uint16_t period, bool interrupt);
+        void run(void);
+        void tick(void);
+
+    private:
+        struct Slot {
+          SchedulerTask task;
+          uint16_t period;    //Milliseconds
+          uint16_t last;      //When it was last due (low 16 bits of millis())
+          bool interrupt;
+          volatile bool due;
+        };
+
+        Slot slots[SCHEDULER_TASKS];
+        volatile uint8_t count;
+};
+
+extern SchedulerClass Scheduler;
+
+#endif
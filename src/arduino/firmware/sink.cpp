@@ -0,0 +1,259 @@
+/**
+ * DMX-84
+ * Channel data sink code
+ *
+ * This file contains the code for writing channel data commands into the
+ * universe a byte at a time, so a long packet never has to be kept whole.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include <DmxSimple.h>
+
+#include "sink.h"
+#include "fade.h"
+
+/******************************************************************************
+ * Internal constants
+ ******************************************************************************/
+
+//Bytes in a full group of 0x2C pairs: the high bits, then 8 pairs
+#define SCATTER_GROUP_LENGTH  17
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**
+ * begin - Starts applying a command's data.
+ *
+ * Parameter:
+ *    uint8_t cmd: the command byte
+ * Returns:
+ *    bool accepted: false if the command doesn't carry channel data, in which
+ *                   case the sink stays idle
+ */
+bool SinkClass::begin(uint8_t cmd) {
+  if (!carriesChannels(cmd)) {
+    return false;
+  }
+  
+  command = cmd;
+  index = 0;
+  channel = (cmd == 0x20 || cmd == 0x21) ? (cmd & 1) << 8 : 0;
+  count = 0;
+  low = DMX_SIZE;
+  high = 0;
+  valid = true;
+  DmxSimple.holdCommit(true);
+  return true;
+}
+
+/**
+ * streamable - Checks whether a command may be applied before its packet's
+ * checksum has been checked.
+ *
+ * Parameter:
+ *    uint8_t cmd: the command byte
+ * Returns:
+ *    bool streamable: true if begin() takes it and undo() can take it back
+ *                     exactly
+ *
+ * undo() puts channels back from dmxOutput, so that must be what the back
+ * buffer holds: no changes waiting for a commit (or for a fade to start),
+ * no commit waiting for the frame boundary and no fade moving dmxOutput.
+ * Otherwise the packet has to be queued whole, or refused if it is too long.
+ */
+bool SinkClass::streamable(uint8_t cmd) {
+  if (cmd == CODEC_DELTA_CMD || !carriesChannels(cmd) || Fade.active() ||
+      DmxSimple.committing()) {
+    return false;
+  }
+  for (uint16_t i = 0; i < DMX_SIZE; i++) {
+    if (dmxBuffer[i] != dmxOutput[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * carriesChannels - Checks whether a command is one of the channel data
+ * commands the sink applies.
+ */
+bool SinkClass::carriesChannels(uint8_t cmd) {
+  switch (cmd) {
+    case 0x20:
+    case 0x21:
+    case 0x22:
+    case 0x23:
+    case CODEC_RAW_CMD:
+    case CODEC_RLE_CMD:
+    case CODEC_DELTA_CMD:
+    case 0x2C:
+      return true;
+    
+    default:
+      return false;
+  }
+}
+
+/**
+ * set - Writes the next channel and notes it for undo().
+ *
+ * Parameter:
+ *    uint8_t value: the value for channel
+ */
+void SinkClass::set(uint8_t value) {
+  dmxBuffer[channel] = value;
+  low = min(low, channel);
+  high = max(high, channel + 1);
+}
+
+/**
+ * write - Applies the next byte of the command's data.
+ *
+ * Parameter:
+ *    uint8_t byte: the byte after the last one written (the first is the one
+ *                  after the command byte)
+ *
+ * Bytes beyond what the command can use are ignored.
+ */
+void SinkClass::write(uint8_t byte) {
+  switch (command) {
+    case 0x20:
+    case 0x21: {
+      //256 values from the start of the low or high half
+      if (index < 256) {
+        set(byte);
+        channel++;
+      }
+      break;
+    }
+    
+    case 0x22:
+    case 0x23: {
+      //Start channel (bit 8 from the command), length, then the values
+      if (index == 0) {
+        channel = byte | (command & 1) << 8;
+      } else if (index == 1) {
+        count = byte;
+        if (channel + count > DMX_SIZE) {
+          valid = false;
+          count = DMX_SIZE - channel; //Don't go above channel 512
+        }
+      } else if (count) {
+        set(byte);
+        channel++;
+        count--;
+      }
+      break;
+    }
+    
+    case CODEC_RAW_CMD: {
+      if (channel < DMX_SIZE) {
+        set(byte);
+        channel++;
+      }
+      break;
+    }
+    
+    case CODEC_RLE_CMD:
+    case CODEC_DELTA_CMD: {
+      //16-bit start channel, then the tokens (see codec.h)
+      if (index == 0) {
+        channel = byte;
+      } else if (index == 1) {
+        channel |= byte << 8;
+        if (channel >= DMX_SIZE) {
+          valid = false;
+        }
+        Codec.openStream(&codec, channel, command == CODEC_DELTA_CMD);
+        low = channel;
+      } else if (valid) {
+        if (!Codec.feed(&codec, dmxBuffer, byte)) {
+          valid = false;
+        }
+        high = max(high, codec.channel);
+      }
+      break;
+    }
+    
+    case 0x2C: {
+      //Groups of up to 8 (channel, value) pairs, each group after a byte that
+      //holds bit 8 of their channels (bit 0 for the first pair)
+      uint8_t position = index % SCATTER_GROUP_LENGTH;
+      if (position == 0) {
+        count = byte;
+      } else if (position & 1) {
+        channel = byte | (count & 1) << 8;
+        count >>= 1;
+      } else {
+        set(byte);
+      }
+      break;
+    }
+    
+    default: {
+      return; //Idle
+    }
+  }
+  index++;
+}
+
+/**
+ * undo - Puts the channels written since begin() back to their committed
+ * levels (dmxOutput), for a packet that turned out to be bad. Must be called
+ * before end(), while commits are still held.
+ *
+ * This is exactly what they were before the packet if it was streamable().
+ */
+void SinkClass::undo(void) {
+  for (uint16_t i = low; i < high; i++) {
+    dmxBuffer[i] = dmxOutput[i];
+  }
+  low = DMX_SIZE;
+  high = 0;
+}
+
+/**
+ * end - Finishes the command and lets commits through again.
+ *
+ * Returns:
+ *    bool valid: false if the data was cut short or went past the end of
+ *                the universe (what fitted is still applied)
+ */
+bool SinkClass::end(void) {
+  if (!command) {
+    return true;
+  }
+  if (command == CODEC_RLE_CMD || command == CODEC_DELTA_CMD) {
+    valid = valid && index >= 2 && Codec.closeStream(&codec);
+  }
+  command = 0;
+  DmxSimple.holdCommit(false);
+  return valid;
+}
+
+SinkClass Sink;
@@ -0,0 +1,81 @@
+/**
+ * DMX-84
+ * Channel data sink header
+ *
+ * This file contains the external defines and prototypes for writing channel
+ * data commands into the universe a byte at a time.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SINK_H
+#define SINK_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <inttypes.h>
+
+#include "codec.h"
+
+/******************************************************************************
+ * Class definition
+ ******************************************************************************/
+
+/* Applies the channel data commands (0x20-0x23, 0x27 and 0x2A-0x2C) to the
+ * back buffer one byte at a time. The link uses it to write packets that are
+ * too long to queue straight into the universe as they arrive, and
+ * processCommand() uses it for the same commands when they were queued, so
+ * both behave the same. Commits are held off from begin() to end(), so a
+ * packet that turns out to be bad can be undone from dmxOutput.
+ *
+ * There is no room to keep what a packet overwrites, so a packet is only
+ * streamed while the back buffer matches dmxOutput and nothing is moving
+ * dmxOutput (see streamable()). Then undo() puts back exactly what was
+ * there. XOR patches (0x2B) are never streamed, since a patch applied twice
+ * cancels itself out.
+ */
+class SinkClass {
+    public:
+        bool begin(uint8_t cmd);
+        void write(uint8_t byte);
+        void undo(void);
+        bool end(void);
+
+        bool streamable(uint8_t cmd);
+
+    private:
+        static bool carriesChannels(uint8_t cmd);
+        void set(uint8_t value);
+
+        uint8_t command;      //0 while idle
+        uint16_t index;       //Bytes written since the command byte
+        uint16_t channel;     //The next channel to write
+        uint8_t count;        //Channels left in a block (0x22/0x23), or the
+                              //high bits of the channels left (0x2C)
+        uint16_t low;         //The channels written so far, low to high - 1
+        uint16_t high;
+        bool valid;
+        CodecStream codec;
+};
+
+extern SinkClass Sink;
+
+#endif
@@ -4,7 +4,7 @@
  *
  * This file contains the code for managing the system status and error flags.
  *
- * Last modified November 4, 2014
+ * Last modified October 16, 2026
  *
  *
  * Copyright (C) 2014  Alex Cordonnier
@@ -28,14 +28,21 @@
  ******************************************************************************/
 
 #include "Arduino.h"
+#include <util/atomic.h>
 
 #include "status.h"
 #include "LED.h"
+#include "telemetry.h"
+#include "firmware.h"
 
 /******************************************************************************
  * Function definitions
  ******************************************************************************/
 
+/* Flags are set from the link interrupt as well as the main loop, so every
+ * read-modify-write of them runs with interrupts off.
+ */
+
 /**
  * set - Sets a status flag.
  *
@@ -43,8 +50,9 @@
  *    uint8_t status: the status flag to set
  */
 void StatusClass::set(uint8_t status) {
-  flags |= status;
-  LED.choosePattern();
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    update(flags | status);
+  }
 }
 
 /**
@@ -54,8 +62,9 @@ void StatusClass::set(uint8_t status) {
  *    uint8_t status: the status flag to clear
  */
 void StatusClass::clear(uint8_t status) {
-  flags &= ~status;
-  LED.choosePattern();
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    update(flags & ~status);
+  }
 }
 
 /**
@@ -65,8 +74,9 @@ void StatusClass::clear(uint8_t status) {
  *    uint8_t status: the status flag to toggle
  */
 void StatusClass::toggle(uint8_t status) {
-  flags ^= status;
-  LED.choosePattern();
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    update(flags ^ status);
+  }
 }
 
 /**
@@ -95,20 +105,39 @@ uint8_t StatusClass::get(void) {
  * reset - Resets the status flags.
  */
 void StatusClass::reset(void) {
-  flags = 0;
-  LED.choosePattern();
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    update(0);
+  }
+}
+
+/**
+ * update - Changes the status flags, choosing a new LED pattern only if they
+ * actually changed. Most calls set a flag that is already set (or clear one
+ * that is already clear), so this keeps them cheap.
+ *
+ * Parameter:
+ *    uint8_t newFlags: the new status flags
+ */
+void StatusClass::update(uint8_t newFlags) {
+  if (newFlags != flags) {
+    flags = newFlags;
+    LED.choosePattern();
+  }
 }
 
 /**
- * set - Sets the error status and changes the LED pattern.
+ * set - Sets the error status, which changes the LED pattern.
  *
  * Parameter:
  *    uint8_t error: the new error code
  */
 void ErrorClass::set(uint8_t error) {
-  flags |= error;
-  Status.set(ERROR_STATUS);
-  LED.choosePattern();
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    flags |= error;
+    Status.set(ERROR_STATUS);
+  }
+  Telemetry.count(STAT_ERRORS);
+  TRACE(TRACE_ERRORS, TRACE_EVENT_ERROR, error);
 }
 
 /**
@@ -118,12 +147,13 @@ void ErrorClass::set(uint8_t error) {
  *    uint8_t error: the error flag to clear
  */
 void ErrorClass::clear(uint8_t error) {
-  flags &= ~error;
-  //If there are no more remaining errors, clear the error status.
-  if (!flags) {
-    Status.clear(ERROR_STATUS);
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    flags &= ~error;
+    //If there are no more remaining errors, clear the error status.
+    if (!flags) {
+      Status.clear(ERROR_STATUS);
+    }
   }
-  LED.choosePattern();
 }
 
 /**
@@ -133,23 +163,25 @@ void ErrorClass::clear(uint8_t error) {
  *    uint8_t error: the error flag to toggle
  */
 void ErrorClass::toggle(uint8_t error) {
-  flags ^= error;
-  //If there are remaining errors, set the error status. Else clear it.
-  if (flags) {
-    Status.set(ERROR_STATUS);
-  } else {
-    Status.clear(ERROR_STATUS);
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    flags ^= error;
+    //If there are remaining errors, set the error status. Else clear it.
+    if (flags) {
+      Status.set(ERROR_STATUS);
+    } else {
+      Status.clear(ERROR_STATUS);
+    }
   }
-  LED.choosePattern();
 }
 
 /**
  * reset - Resets the error flags and clears the error status.
  */
 void ErrorClass::reset(void) {
-  flags = 0;
-  Status.clear(ERROR_STATUS);
-  LED.choosePattern();
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    flags = 0;
+    Status.clear(ERROR_STATUS);
+  }
 }
 
 StatusClass Status; //Create a public Status instance
@@ -5,7 +5,7 @@
  * This file contains the external defines and prototypes for managing the
  * system status and error flags.
  *
- * Last modified November 4, 2014
+ * Last modified October 16, 2026
  *
  *
  * Copyright (C) 2014  Alex Cordonnier
@@ -74,7 +74,10 @@ class StatusClass {
         virtual void reset(void);
 
     protected:
-        uint8_t flags;
+        volatile uint8_t flags; //Also changed from the link interrupt
+
+    private:
+        void update(uint8_t newFlags);
 };
 
 class ErrorClass: public StatusClass {
@@ -0,0 +1,75 @@
+/**
+ * DMX-84
+ * Telemetry code
+ *
+ * This file contains the code for reading and resetting the event counters.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include <DmxSimple.h>
+
+#include "telemetry.h"
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**
+ * read - Copies out all the counters, ready to send.
+ *
+ * Parameter:
+ *    uint8_t *bytes: where to put the STAT_COUNT counters, 32 bits each, LSB
+ *                    first
+ */
+void TelemetryClass::read(uint8_t *bytes) {
+  for (uint8_t i = 0; i < STAT_COUNT; i++) {
+    uint32_t value;
+    if (i == STAT_FRAMES) {
+      value = DmxSimple.frames() - frameBase;
+    } else {
+      ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        value = counts[i];
+      }
+    }
+    *bytes++ = value & 0xFF;
+    *bytes++ = (value >> 8) & 0xFF;
+    *bytes++ = (value >> 16) & 0xFF;
+    *bytes++ = value >> 24;
+  }
+}
+
+/**
+ * reset - Sets all the counters back to 0.
+ */
+void TelemetryClass::reset(void) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    for (uint8_t i = 0; i < STAT_FRAMES; i++) {
+      counts[i] = 0;
+    }
+  }
+  frameBase = DmxSimple.frames();
+}
+
+TelemetryClass Telemetry; //Create a public Telemetry instance
@@ -0,0 +1,89 @@
+/**
+ * DMX-84
+ * Telemetry header
+ *
+ * This file contains the external defines and prototypes for the event
+ * counters reported by the stats command.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <inttypes.h>
+#include <util/atomic.h>
+
+/******************************************************************************
+ * External constants
+ ******************************************************************************/
+
+//Counters, in the order the stats command (0xF4) sends them
+#define STAT_PACKETS_RECEIVED   0  //Link packets accepted
+#define STAT_SERIAL_PACKETS     1  //Hex lines accepted from the serial port
+#define STAT_CHECKSUM_ERRORS    2  //Packets with a bad checksum
+#define STAT_PACKETS_DROPPED    3  //Whole packets not accepted for other reasons
+#define STAT_RX_TIMEOUTS        4  //Packets abandoned partway through
+#define STAT_RX_STALLS          5  //Times the calculator was held off for room
+#define STAT_PACKETS_SENT       6  //Packets sent to the calculator
+#define STAT_SEND_TIMEOUTS      7  //Sends the calculator didn't take
+#define STAT_ACK_TIMEOUTS       8  //Sends the calculator didn't answer
+#define STAT_LINK_BUSY          9  //Sends given up because the link was busy
+#define STAT_COMMANDS           10 //Commands run
+#define STAT_UNKNOWN_COMMANDS   11 //Commands not recognized
+#define STAT_ERRORS             12 //Error flags set (see status.h)
+#define STAT_BYTES_RECEIVED     13 //Data bytes of the link packets accepted
+#define STAT_BYTES_SENT         14 //Data bytes of the packets sent
+#define STAT_FRAMES             15 //DMX frames sent (kept by DmxSimple)
+#define STAT_COUNT              16
+
+/******************************************************************************
+ * Class definition
+ ******************************************************************************/
+
+/* Counts link, protocol and DMX events. Counters stick at 0xFFFFFFFF instead
+ * of wrapping. count() and add() are inline and only a few instructions, so
+ * they can be called from interrupts and on every packet.
+ */
+class TelemetryClass {
+    public:
+        void count(uint8_t counter) {
+          add(counter, 1);
+        }
+        void add(uint8_t counter, uint32_t amount) {
+          ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { //Some are counted from interrupts
+            uint32_t sum = counts[counter] + amount;
+            counts[counter] = sum < amount ? 0xFFFFFFFF : sum;
+          }
+        }
+        void read(uint8_t *bytes);
+        void reset(void);
+
+    private:
+        uint32_t counts[STAT_FRAMES];
+        uint32_t frameBase;     //DmxSimple.frames() at the last reset
+};
+
+extern TelemetryClass Telemetry;
+
+#endif
@@ -0,0 +1,100 @@
+/**
+ * DMX-84
+ * Event trace code
+ *
+ * This file contains the code for the binary event trace.
+ *
+ * Last modified October 15, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include <util/atomic.h>
+
+#include "trace.h"
+#include "firmware.h"
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**
+ * log - Adds an event to the ring. Safe to call from interrupts.
+ *
+ * Parameters:
+ *    uint8_t event: the TRACE_EVENT_* ID
+ *    uint8_t a: the 8-bit argument
+ *    uint16_t b: the 16-bit argument
+ *
+ * If the ring is full, the event is counted as dropped instead.
+ */
+void TraceClass::log(uint8_t event, uint8_t a, uint16_t b) {
+  uint32_t now = micros();
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (count == TRACE_LENGTH) {
+      dropped++;
+    } else {
+      uint8_t i = head + count;
+      if (i >= TRACE_LENGTH) {
+        i -= TRACE_LENGTH;
+      }
+      TraceRecord &r = records[i];
+      r.time = now;
+      r.event = event;
+      r.a = a;
+      r.b = b;
+      count++;
+    }
+  }
+}
+
+/**
+ * drain - Writes waiting records to the serial port, as many as fit in its
+ * transmit buffer without waiting. Call when the firmware is idle.
+ */
+void TraceClass::drain(void) {
+#if SERIAL_DEBUG_ENABLED
+  while (Serial.availableForWrite() > (int)sizeof(TraceRecord)) {
+    TraceRecord r;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      if (count) {
+        r = records[head];
+        head = head + 1 < TRACE_LENGTH ? head + 1 : 0;
+        count--;
+      } else if (dropped) {
+        //Report the loss once the ring has emptied
+        r.time = micros();
+        r.event = TRACE_EVENT_DROPPED;
+        r.a = 0;
+        r.b = dropped;
+        dropped = 0;
+      } else {
+        return;
+      }
+    }
+    Serial.write(TRACE_SYNC);
+    Serial.write((const uint8_t *)&r, sizeof(r)); //AVR is little endian
+  }
+#endif
+}
+
+TraceClass Trace;
@@ -0,0 +1,115 @@
+/**
+ * DMX-84
+ * Event trace header
+ *
+ * This file contains the external defines and prototypes for the binary event
+ * trace, which replaces the serial text messages in the busy paths.
+ *
+ * Events are stored in a small RAM ring as fixed-size records in a few cycles
+ * and only written to the serial port when the firmware is idle. Each record
+ * goes out as TRACE_SYNC followed by the record bytes, least significant byte
+ * first:
+ *
+ *    uint32_t time: micros() when the event happened
+ *    uint8_t event: a TRACE_EVENT_* ID
+ *    uint8_t a, uint16_t b: arguments (see the event list)
+ *
+ * Text messages that are still printed are plain ASCII, so TRACE_SYNC never
+ * appears in them and a decoder can tell the two apart. This file has no
+ * Arduino dependencies so host tools can include it for the event list.
+ *
+ * Last modified October 15, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <inttypes.h>
+
+/******************************************************************************
+ * External constants
+ ******************************************************************************/
+
+//Number of records the ring holds
+#define TRACE_LENGTH          12
+
+//Byte sent before each record
+#define TRACE_SYNC            0xA5
+
+//Levels. An event is only recorded if its level is at or below the current
+//level.
+#define TRACE_OFF             0
+#define TRACE_ERRORS          1
+#define TRACE_COMMANDS        2
+#define TRACE_PACKETS         3
+
+//Events (level, a, b)
+#define TRACE_EVENT_BOOT          0x01 //Errors: -, -
+#define TRACE_EVENT_DROPPED       0x02 //Errors: -, records lost to a full ring
+#define TRACE_EVENT_ERROR         0x10 //Errors: error flag, -
+#define TRACE_EVENT_LINK_TIMEOUT  0x11 //Errors: -, -
+#define TRACE_EVENT_LINK_BUSY     0x12 //Errors: -, -
+#define TRACE_EVENT_SEND_ERROR    0x13 //Errors: part (0 head, 1-2 data,
+                                       //3 checksum), par_put error
+#define TRACE_EVENT_COMMAND       0x20 //Commands: command, packet length
+#define TRACE_EVENT_COMMAND_DONE  0x21 //Commands: command, -
+#define TRACE_EVENT_CUE           0x22 //Commands: queued command run, length
+#define TRACE_EVENT_RECEIVED      0x30 //Packets: first byte, length
+#define TRACE_EVENT_SENT          0x31 //Packets: first byte, length
+#define TRACE_EVENT_SENT_ID       0x32 //Packets: TI command ID, -
+
+/******************************************************************************
+ * Class definition
+ ******************************************************************************/
+
+struct TraceRecord {
+  uint32_t time;
+  uint8_t event;
+  uint8_t a;
+  uint16_t b;
+};
+
+class TraceClass {
+    public:
+        void log(uint8_t event, uint8_t a = 0, uint16_t b = 0);
+        void drain(void);
+
+        uint8_t level;
+
+    private:
+        TraceRecord records[TRACE_LENGTH];
+        uint8_t head;
+        volatile uint8_t count;
+        uint16_t dropped;
+};
+
+extern TraceClass Trace;
+
+/* Records an event if tracing is compiled in and the level allows it. With
+ * TRACE_ENABLED 0 the whole statement compiles away.
+ */
+#define TRACE(lvl, ...) do { \
+    if (TRACE_ENABLED && (lvl) <= Trace.level) Trace.log(__VA_ARGS__); \
+  } while (0)
+
+#endif
@@ -0,0 +1,716 @@
+/**
+ * DMX-84
+ * DMX timing harness
+ *
+ * Runs the real firmware ELF under simavr and captures DMX_OUT_PIN (or the
+ * USART's TX pin with -u) cycle by cycle. The capture is decoded into frames
+ * (see waveform.h) and checked against DMX512:
+ *    break      at least BREAK_MIN
+ *    MAB        at least MAB_MIN
+ *    bits       every edge within BIT_ERROR_LIMIT of its bit boundary
+ *    slots      maxChannel channels and the start code in every frame
+ *    rate       with the link quiet, within RATE_TOLERANCE of what the
+ *               transmit interrupt's budget allows for that many slots
+ *    CPU        with effects, masters and a user curve running, the
+ *               transmit interrupt busy at most ISR_SHARE_LIMIT of the time
+ * for maxChannel 16, 128 and 512, first with the link quiet and then with a
+ * simulated calculator (../host/calculator.h) sending set channel packets
+ * the whole time, so the link interrupt and par_get() compete with the
+ * cli() windows in dmxSendByte(). A last run has 4 effects, the masters and
+ * a user curve on all 512 channels, so the slot filter does the most it
+ * can. For each run it prints the frame period, the longest gap between
+ * slots, the jitter of the transmit interrupt, how much of the time the
+ * interrupt ran (from DMX_PROBE_ISR_PIN, if the ELF was built with it) and
+ * the link packets the adapter accepted per second.
+ *
+ * Save a report with -o before changing an interrupt and compare with -c
+ * after it: the report shows both, and -c fails if the frame period, gap or
+ * jitter got more than -t percent worse, or the link got that much slower.
+ *
+ * Built with DMXTIMING_HOST, it runs the host build of the firmware (../host)
+ * instead, as dmxtiming_host, with the same runs and checks. The host's
+ * dmxSendByte() times its bits on the simulated clock and the rest of the
+ * code takes no time, so this checks the transmit interrupt's framing and
+ * budget logic but not what the code costs on the chip.
+ *
+ * Usage: dmxtiming [-n seconds] [-o file] [-c file] [-t percent] [-u] [-q]
+ *                  <firmware ELF>
+ *        dmxtiming_host [-n seconds] [-o file] [-c file] [-t percent] [-q]
+ *    -n seconds  capture length per run, simulated (default 1)
+ *    -o file     save the report as a baseline
+ *    -c file     compare with a saved baseline
+ *    -t percent  how much worse -c allows (default 10)
+ *    -u          the firmware was built with DMX_USE_USART
+ *    -q          quiet: only print runs that failed
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#if DMXTIMING_HOST
+#include "hal.h"
+#else
+//simavr first, before the stub Arduino core's macros
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_irq.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_uart.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <map>
+#include <string>
+
+#include "firmware.h"
+#include "link.h"
+#include "calculator.h"
+#include "waveform.h"
+
+/******************************************************************************
+ * Internal constants
+ ******************************************************************************/
+
+//DMX512 transmitter limits (microseconds)
+#define BREAK_MIN             88.0
+#define MAB_MIN               8.0
+#define BIT_ERROR_LIMIT       0.8 //The standard's 2% per bit, over 10 bits
+
+//How far over the interrupt budget's frame period a quiet run may be
+#define RATE_TOLERANCE        10 //Percent
+
+//The bit-banged transmitter: TIMER2 overflows (phase correct, 64 prescaler)
+//each allow a quarter of the CPU time, in DMX bit periods (see DmxSimple.cpp)
+#define TICK_PERIOD           2040000ULL //Nanoseconds
+#define TICK_BUDGET           127
+
+//The USART transmitter's pin
+#define DMX_TX_PIN            1
+
+//DMX_PROBE_ISR_PIN as the ELF is built (A1, see CMakeLists.txt), and the
+//share of the CPU the transmit interrupt may take with the show running
+#define ISR_PROBE_PIN         15
+#define ISR_SHARE_LIMIT       25 //Percent
+
+#define CPU_FREQUENCY         16000000
+
+//Host build: between runs of loop() (nanoseconds)
+#define LOOP_PERIOD           20000
+
+//Simulated times (nanoseconds)
+#define REPLY_TIMEOUT         100000000
+#define SETTLE_TIME           250000000 //Longer than two frames of 512
+#define DEFAULT_CAPTURE       1000000000ULL
+
+#define DEFAULT_TOLERANCE     10 //Percent
+
+//Smallest change compared with -c (microseconds), below the noise
+#define MIN_COMPARED_CHANGE   1.0
+
+/******************************************************************************
+ * Internal types
+ ******************************************************************************/
+
+struct Run {
+  const char *name;
+  uint16_t maxChannel;
+  bool link; //Calculator traffic during the capture
+  bool show; //Effects, masters and a user curve running
+};
+
+#if DMXTIMING_HOST
+/* A pin of the host build, watched for changes. The HAL steps devices every
+ * time the clock moves, and the firmware only changes pins between moves, so
+ * a change seen now was made at the time of the last step.
+ */
+class LineWatcher: public HalDevice {
+    public:
+        LineWatcher(uint8_t pin, std::vector<Edge> *edges) :
+            pin(pin), edges(edges), level(halLevel(pin)), last(halNow()) {}
+
+        uint64_t step(uint64_t now) {
+          bool seen = halLevel(pin);
+          if (seen != level) {
+            Edge edge = {last, seen};
+            edges->push_back(edge);
+            level = seen;
+          }
+          last = now;
+          return 0;
+        }
+
+    private:
+        uint8_t pin;
+        std::vector<Edge> *edges;
+        bool level;
+        uint64_t last; //When it was last stepped
+};
+#endif
+
+struct Result {
+  Waveform wave;
+  double expected; //Frame period the interrupt budget allows (microseconds)
+  double linkRate; //Packets accepted per second
+  double isrShare; //Percent of the time the transmit interrupt ran (or -1)
+};
+
+/******************************************************************************
+ * Internal variables
+ ******************************************************************************/
+
+static const Run runs[] = {
+  {"16 quiet",  16,  false, false},
+  {"16 link",   16,  true,  false},
+  {"128 quiet", 128, false, false},
+  {"128 link",  128, true,  false},
+  {"512 quiet", 512, false, false},
+  {"512 link",  512, true,  false},
+  {"512 show",  512, false, true}
+};
+
+static Calculator calc;
+static std::vector<Edge> edges;
+static std::vector<Edge> probeEdges; //DMX_PROBE_ISR_PIN
+
+#if !DMXTIMING_HOST
+static avr_t *avr;
+static bool pulled[20]; //Arduino pins the calculator holds low
+
+//Data space addresses of PINx, DDRx and PORTx for ports B, C and D
+static const uint16_t pinRegisters[3] = {0x23, 0x26, 0x29};
+#endif
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+#if !DMXTIMING_HOST
+/* The calculator (../host/calculator.cpp) runs on these instead of the host
+ * build's HAL: the simulated clock is simavr's cycle count, and the lines
+ * are its I/O port pins.
+ */
+
+uint64_t halNow(void) {
+  return avr->cycle * 1000 / (avr->frequency / 1000000);
+}
+
+/**
+ * portOf - Finds the port letter and bit of an Arduino pin.
+ */
+static char portOf(uint8_t pin, uint8_t *bit) {
+  if (pin < 8) {
+    *bit = pin;
+    return 'D';
+  } else if (pin < 14) {
+    *bit = pin - 8;
+    return 'B';
+  }
+  *bit = pin - 14;
+  return 'C';
+}
+
+void halPull(uint8_t pin, bool low) {
+  uint8_t bit;
+  char port = portOf(pin, &bit);
+  pulled[pin] = low;
+  avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(port), bit),
+      low ? 0 : 1);
+}
+
+/**
+ * halLevel - Reads a line: low if the calculator pulls it or the chip drives
+ * it low (the lines are open collector, with pull-ups).
+ */
+bool halLevel(uint8_t pin) {
+  uint8_t bit;
+  char port = portOf(pin, &bit);
+  uint16_t base = pinRegisters[port == 'B' ? 0 : (port == 'C' ? 1 : 2)];
+  uint8_t ddr = avr->data[base + 1], out = avr->data[base + 2];
+  bool driven = (ddr >> bit & 1) && !(out >> bit & 1);
+  return !pulled[pin] && !driven;
+}
+
+/**
+ * lineChanged - Records a change on the DMX output or the probe pin (param
+ * is where the edges go).
+ */
+static void lineChanged(struct avr_irq_t *, uint32_t value, void *param) {
+  Edge edge = {halNow(), value != 0};
+  ((std::vector<Edge> *)param)->push_back(edge);
+}
+#endif
+
+/**
+ * runUntil - Runs the firmware, with the calculator stepping along, until a
+ * condition holds or time runs out. Exits if the firmware stops or crashes.
+ *
+ * Returns:
+ *    bool met: true if the condition held
+ */
+template <typename Condition>
+static bool runUntil(Condition condition, uint64_t timeout) {
+  uint64_t end = halNow() + timeout;
+  while (!condition()) {
+    if (halNow() >= end) {
+      return false;
+    }
+#if DMXTIMING_HOST
+    loop(); //The HAL steps the calculator
+    halAdvance(LOOP_PERIOD);
+#else
+    int state = avr_run(avr);
+    if (state == cpu_Done || state == cpu_Crashed) {
+      fprintf(stderr, "The firmware stopped (simavr state %d)\n", state);
+      exit(1);
+    }
+    calc.step(halNow());
+#endif
+  }
+  return true;
+}
+
+/**
+ * answered - Sends a packet from the calculator and waits for the answer.
+ *
+ * Returns:
+ *    bool acked: true if the adapter answered ACK
+ */
+static bool answered(uint8_t command, const uint8_t *data = 0,
+    uint16_t length = 0) {
+  calc.replies.clear();
+  calc.send(command, data, length);
+  runUntil([] { return calc.aborted || !calc.replies.empty(); },
+      REPLY_TIMEOUT);
+  bool acked = !calc.aborted && !calc.replies.empty() &&
+      calc.replies.front()[1] == CMD_ACK;
+  calc.aborted = false;
+  calc.replies.clear();
+  return acked;
+}
+
+/**
+ * expectedPeriod - Works out the frame period the transmit interrupt's
+ * budget allows: the break, MAB and start code, then as many slots as fit
+ * in each tick. The USART transmitter sends slots back to back.
+ */
+static double expectedPeriod(const Waveform &w, bool usart) {
+  double reset = w.breakMin + w.mabMin;
+  if (usart) {
+    return reset + w.slotsMin * DMX_SLOT_BITS * DMX_BIT_TIME / 1000.0;
+  }
+  unsigned resetBits = (unsigned)reset * 1000 / DMX_BIT_TIME + DMX_SLOT_BITS;
+  unsigned first = resetBits < TICK_BUDGET ?
+      (TICK_BUDGET - resetBits) / DMX_SLOT_BITS : 0;
+  unsigned perTick = TICK_BUDGET / DMX_SLOT_BITS;
+  unsigned channels = w.slotsMin ? w.slotsMin - 1 : 0;
+  unsigned ticks = 1 + (channels > first ?
+      (channels - first + perTick - 1) / perTick : 0);
+  return ticks * TICK_PERIOD / 1000.0;
+}
+
+/**
+ * isrShare - Works out how much of a capture the transmit interrupt ran,
+ * from the probe pin's edges. Interrupts that nest inside it (the link's)
+ * count too.
+ *
+ * Returns:
+ *    double share: percent of the time, or -1 if the probe never went high
+ */
+static double isrShare(const std::vector<Edge> &probe, uint64_t start,
+    uint64_t end) {
+  uint64_t busy = 0, since = 0;
+  bool high = false, seen = false;
+  for (size_t i = 0; i < probe.size(); i++) {
+    if (probe[i].level && !high) {
+      since = probe[i].time;
+    } else if (!probe[i].level && high) {
+      busy += probe[i].time - since;
+    }
+    high = probe[i].level;
+    seen |= high;
+  }
+  if (high) {
+    busy += end - since;
+  }
+  return seen ? busy * 100.0 / (end - start) : -1;
+}
+
+/**
+ * setShow - Starts or stops the show a "show" run captures: an effect of
+ * each kind, 2 groups under the masters and a user curve, all on the 512
+ * channels.
+ *
+ * Returns:
+ *    bool ok: false if the adapter didn't accept a packet
+ */
+static bool setShow(bool on) {
+  //Sine, ramp, random and chase (effects.h)
+  static const uint8_t waveforms[4] = {1, 2, 4, 5};
+  bool ok = true;
+  for (uint8_t slot = 0; slot < 4 && on; slot++) {
+    //0 to 511 at 1 cycle per second, 1/256 of a cycle apart, depth 127
+    uint8_t effect[13] = {0x70, slot, waveforms[slot], 0, 0, 0x00, 0x02,
+        100, 0, 0x00, 0x01, 0x7F, 4};
+    ok &= answered(CMD_DATA, effect, sizeof(effect));
+  }
+  if (!on) {
+    uint8_t stop[1] = {0x71};
+    ok &= answered(CMD_DATA, stop, sizeof(stop));
+  }
+
+  //Group 0 is channels 0-255 and group 1 is 128-511
+  uint8_t group0[7] = {0x91, 0, 0, 0, 0x00, 0x01, on};
+  uint8_t group1[7] = {0x91, 1, 128, 0, 0x80, 0x01, on};
+  uint8_t grand[2] = {0x93, (uint8_t)(on ? 200 : 255)};
+  uint8_t sub0[2] = {0x94, (uint8_t)(on ? 128 : 255)};
+  uint8_t sub1[2] = {0x95, (uint8_t)(on ? 64 : 255)};
+  ok &= answered(CMD_DATA, group0, sizeof(group0));
+  ok &= answered(CMD_DATA, group1, sizeof(group1));
+  ok &= answered(CMD_DATA, grand, sizeof(grand));
+  ok &= answered(CMD_DATA, sub0, sizeof(sub0));
+  ok &= answered(CMD_DATA, sub1, sizeof(sub1));
+
+  if (on) {
+    //An upside down table, 64 entries a packet
+    for (unsigned offset = 0; offset < 256; offset += 64) {
+      uint8_t table[2 + 64] = {0x81, (uint8_t)offset};
+      for (unsigned i = 0; i < 64; i++) {
+        table[2 + i] = 255 - (offset + i);
+      }
+      ok &= answered(CMD_DATA, table, sizeof(table));
+    }
+    uint8_t curve[7] = {0x80, 0, 0, 0x00, 0x02, 4, 0}; //CURVE_USER
+    ok &= answered(CMD_DATA, curve, sizeof(curve));
+  } else {
+    uint8_t linear[1] = {0x82};
+    ok &= answered(CMD_DATA, linear, sizeof(linear));
+  }
+  return ok;
+}
+
+/**
+ * measure - Sets maxChannel, lets the output settle and captures it.
+ *
+ * Returns:
+ *    bool ok: false if the adapter didn't accept maxChannel
+ */
+static bool measure(const Run &run, uint64_t capture, bool usart,
+    Result *result) {
+  //0xE2/0xE3 take 9 bits, and 0 means 512
+  uint8_t data[2] = {(uint8_t)(0xE2 | (run.maxChannel >> 8 & 1)),
+      (uint8_t)(run.maxChannel & 0xFF)};
+  if (!answered(CMD_DATA, data, sizeof(data)) ||
+      (run.show && !setShow(true))) {
+    return false;
+  }
+  runUntil([] { return false; }, SETTLE_TIME);
+
+  //Keep the calculator busy the whole capture in link runs
+  edges.clear();
+  probeEdges.clear();
+  uint64_t start = halNow();
+  uint32_t accepted = 0;
+  uint8_t channel = 0;
+  bool waiting = false; //For the answer to a packet
+  runUntil([&] {
+    if (!run.link) {
+      return false;
+    }
+    if (calc.aborted) {
+      calc.aborted = false; //Given up on; send the next one
+      waiting = false;
+    } else if (!calc.replies.empty()) {
+      accepted += calc.replies.front()[1] == CMD_ACK;
+      calc.replies.clear();
+      waiting = false;
+    }
+    if (!waiting) {
+      uint8_t packet[3] = {0x10, channel, (uint8_t)(channel * 16)};
+      channel = (channel + 1) % 16;
+      calc.send(CMD_DATA, packet, sizeof(packet));
+      waiting = true;
+    }
+    return false;
+  }, capture);
+
+  result->wave = decodeWaveform(edges, halNow(), usart ? 0 : TICK_PERIOD);
+  result->expected = expectedPeriod(result->wave, usart);
+  result->linkRate = accepted / ((halNow() - start) / 1e9);
+  result->isrShare = isrShare(probeEdges, start, halNow());
+
+  //Let the last packet finish before the next run
+  runUntil([] { return !calc.sending(); }, REPLY_TIMEOUT);
+  runUntil([] { return false; }, REPLY_TIMEOUT);
+  calc.replies.clear();
+  calc.aborted = false;
+  return !run.show || setShow(false);
+}
+
+/**
+ * problemWith - Checks a run against DMX512 and the interrupt budget.
+ *
+ * Returns:
+ *    const char *problem: what is wrong, or NULL
+ */
+static const char *problemWith(const Run &run, const Result &r) {
+  const Waveform &w = r.wave;
+  if (w.frames < 2) {
+    return "fewer than 2 frames";
+  } else if (w.errors) {
+    return "bad start or stop bits";
+  } else if (w.breakMin < BREAK_MIN) {
+    return "break too short";
+  } else if (w.mabMin < MAB_MIN) {
+    return "MAB too short";
+  } else if (w.bitErrorMax > BIT_ERROR_LIMIT) {
+    return "bit timing off";
+  } else if (w.slotsMin != run.maxChannel + 1 ||
+      w.slotsMax != run.maxChannel + 1) {
+    return "wrong number of slots";
+  } else if (!run.link && !run.show &&
+      w.periodAvg > r.expected * (100 + RATE_TOLERANCE) / 100) {
+    return "frame rate below the interrupt budget";
+  } else if (run.show && r.isrShare > ISR_SHARE_LIMIT) {
+    return "transmit interrupt over its share of the CPU";
+  }
+  return NULL;
+}
+
+/**
+ * printResult - Prints one line of the report.
+ */
+static void printResult(const char *name, const Result &r) {
+  const Waveform &w = r.wave;
+  printf("%-10s %6u %5u %9.0f %9.0f %6.1f %6.1f %7.2f %8.1f %7.1f %5.1f "
+      "%9.1f\n", name, w.frames, w.slotsMax, w.periodAvg, r.expected,
+      w.breakMin, w.mabMin, w.bitErrorMax, w.gapMax, w.jitterMax,
+      r.isrShare, r.linkRate);
+}
+
+/**
+ * saveResult - Writes a run to a baseline file, one quoted name and value
+ * per line, in the order printResult() prints them.
+ */
+static void saveResult(FILE *file, const char *name, const Result &r) {
+  const Waveform &w = r.wave;
+  fprintf(file,
+      "\"%s\" %u %u %.1f %.1f %.1f %.1f %.2f %.1f %.1f %.1f %.1f\n", name,
+      w.frames, w.slotsMax, w.periodAvg, r.expected, w.breakMin, w.mabMin,
+      w.bitErrorMax, w.gapMax, w.jitterMax, r.isrShare, r.linkRate);
+}
+
+/**
+ * readBaseline - Loads a report saved with -o.
+ */
+static bool readBaseline(const char *path,
+    std::map<std::string, Result> &results) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    return false;
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), file)) {
+    char name[64];
+    unsigned frames, slots;
+    Result r;
+    memset(&r, 0, sizeof(r));
+    Waveform &w = r.wave;
+    if (sscanf(line,
+        "\"%63[^\"]\" %u %u %lf %lf %lf %lf %lf %lf %lf %lf %lf",
+        name, &frames, &slots, &w.periodAvg, &r.expected, &w.breakMin,
+        &w.mabMin, &w.bitErrorMax, &w.gapMax, &w.jitterMax, &r.isrShare,
+        &r.linkRate) == 12) {
+      w.frames = frames;
+      w.slotsMax = slots;
+      results[name] = r;
+    }
+  }
+  fclose(file);
+  return true;
+}
+
+/**
+ * worse - Checks whether a time grew by more than the tolerance.
+ */
+static bool worse(double before, double after, unsigned tolerance) {
+  return after > before * (100 + tolerance) / 100 + MIN_COMPARED_CHANGE;
+}
+
+int main(int argc, char **argv) {
+  uint64_t capture = DEFAULT_CAPTURE;
+  unsigned tolerance = DEFAULT_TOLERANCE;
+  const char *savePath = NULL, *comparePath = NULL;
+  bool usart = false, quiet = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:o:c:t:uq")) != -1) {
+    switch (opt) {
+      case 'n': capture = (uint64_t)(strtod(optarg, 0) * 1e9); break;
+      case 'o': savePath = optarg; break;
+      case 'c': comparePath = optarg; break;
+      case 't': tolerance = strtoul(optarg, 0, 0); break;
+      case 'u': usart = true; break;
+      case 'q': quiet = true; break;
+      default: optind = argc + 1; break;
+    }
+  }
+#if DMXTIMING_HOST
+  if (optind != argc || usart) {
+    fprintf(stderr, "Usage: %s [-n seconds] [-o file] [-c file] "
+        "[-t percent] [-q]\n", argv[0]);
+    return 2;
+  }
+#else
+  if (optind != argc - 1) {
+    fprintf(stderr, "Usage: %s [-n seconds] [-o file] [-c file] "
+        "[-t percent] [-u] [-q] <firmware ELF>\n", argv[0]);
+    return 2;
+  }
+#endif
+
+  std::map<std::string, Result> baseline;
+  if (comparePath && !readBaseline(comparePath, baseline)) {
+    perror(comparePath);
+    return 2;
+  }
+
+#if DMXTIMING_HOST
+  LineWatcher dmxLine(DMX_OUT_PIN, &edges);
+  LineWatcher probeLine(ISR_PROBE_PIN, &probeEdges);
+  halAttach(&calc);
+  halAttach(&dmxLine);
+  halAttach(&probeLine);
+  setup();
+#else
+  elf_firmware_t firmware;
+  memset(&firmware, 0, sizeof(firmware));
+  if (elf_read_firmware(argv[optind], &firmware) != 0) {
+    fprintf(stderr, "%s: can't read the firmware\n", argv[optind]);
+    return 2;
+  }
+  if (!firmware.mmcu[0]) {
+    strcpy(firmware.mmcu, "atmega328p");
+  }
+  if (!firmware.frequency) {
+    firmware.frequency = CPU_FREQUENCY;
+  }
+  avr = avr_make_mcu_by_name(firmware.mmcu);
+  if (!avr) {
+    fprintf(stderr, "simavr doesn't know the %s\n", firmware.mmcu);
+    return 2;
+  }
+  avr_init(avr);
+  avr_load_firmware(avr, &firmware);
+
+  //Keep the serial debug output (if any) off the report
+  uint32_t flags = 0;
+  avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+  flags &= ~AVR_UART_FLAG_STDIO;
+  avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+
+  uint8_t bit;
+  char port = portOf(usart ? DMX_TX_PIN : DMX_OUT_PIN, &bit);
+  avr_irq_register_notify(
+      avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(port), bit), lineChanged,
+      &edges);
+  port = portOf(ISR_PROBE_PIN, &bit);
+  avr_irq_register_notify(
+      avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(port), bit), lineChanged,
+      &probeEdges);
+  halPull(TI_RING_PIN, false);
+  halPull(TI_TIP_PIN, false);
+#endif
+
+  //Let setup() finish, then make sure the link answers
+  runUntil([] { return false; }, SETTLE_TIME);
+  if (!answered(CMD_RDY)) {
+    printf("No answer to the ready check\n");
+    return 1;
+  }
+
+  FILE *save = NULL;
+  if (savePath && !(save = fopen(savePath, "w"))) {
+    perror(savePath);
+    return 2;
+  }
+  if (!quiet) {
+    printf("%-10s %6s %5s %9s %9s %6s %6s %7s %8s %7s %5s %9s\n", "Run",
+        "frames", "slots", "period", "budget", "break", "MAB", "bit err",
+        "gap", "jitter", "isr %", "packets/s");
+  }
+  int failed = 0;
+  for (unsigned i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+    Result result;
+    const char *problem = NULL;
+    if (!measure(runs[i], capture, usart, &result)) {
+      memset(&result, 0, sizeof(result));
+      problem = "maxChannel not accepted";
+    } else {
+      problem = problemWith(runs[i], result);
+    }
+
+    bool compared = baseline.count(runs[i].name) != 0;
+    const Result &before = baseline[runs[i].name];
+    if (!problem && compared) {
+      if (worse(before.wave.periodAvg, result.wave.periodAvg, tolerance)) {
+        problem = "frame period worse than baseline";
+      } else if (worse(before.wave.gapMax, result.wave.gapMax, tolerance)) {
+        problem = "gap worse than baseline";
+      } else if (worse(before.wave.jitterMax, result.wave.jitterMax,
+          tolerance)) {
+        problem = "jitter worse than baseline";
+      } else if (result.linkRate <
+          before.linkRate * (100 - tolerance) / 100) {
+        problem = "link slower than baseline";
+      }
+    }
+
+    if (!quiet || problem) {
+      printResult(runs[i].name, result);
+      if (compared) {
+        printResult("  before", before);
+      }
+      if (problem) {
+        printf("  FAILED: %s\n", problem);
+      }
+    }
+    if (problem) {
+      failed++;
+    }
+    if (save) {
+      saveResult(save, runs[i].name, result);
+    }
+  }
+  if (!quiet) {
+    printf("(times in microseconds; budget: the frame period the transmit "
+        "interrupt allows)\n");
+  }
+
+  if (save) {
+    fclose(save);
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,209 @@
+/**
+ * DMX-84
+ * DMX waveform decoder
+ *
+ * Splits the edges captured on a DMX output into breaks and slots. A low
+ * longer than any slot can hold is a break; anything else low starts a slot,
+ * which is read at the middle of each bit time from its start bit. Slots that
+ * follow each other with no more than CHUNK_GAP between them were sent by
+ * the same transmit interrupt, so the time between chunks shows how evenly
+ * that interrupt runs.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <algorithm>
+#include <string.h>
+
+#include "waveform.h"
+
+/******************************************************************************
+ * Internal constants
+ ******************************************************************************/
+
+//A slot is low for at most 9 bit times (start bit and 8 zeros), so a longer
+//low is a break (nanoseconds)
+#define BREAK_DETECT          (11 * DMX_BIT_TIME)
+
+//Longest gap between slots of the same chunk (nanoseconds)
+#define CHUNK_GAP             20000
+
+//Slot data ends, and the stop bits start, this many bit times in
+#define STOP_BITS_START       9
+
+/******************************************************************************
+ * Internal function prototypes
+ ******************************************************************************/
+
+static bool levelAt(const std::vector<Edge> &edges, uint64_t time);
+static void keep(double value, double *min, double *max);
+static void chunk(Waveform *w, uint64_t interval, uint64_t tick);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**
+ * decodeWaveform - Decodes a capture into frame timing.
+ *
+ * Parameters:
+ *    const std::vector<Edge> &edges: the capture, oldest first
+ *    uint64_t end: when the capture stopped (nanoseconds)
+ *    uint64_t tick: the transmit interrupt's period (nanoseconds), or 0
+ * Returns:
+ *    Waveform timing: what the complete frames looked like (all zero if
+ *                     there were none)
+ */
+Waveform decodeWaveform(const std::vector<Edge> &edges, uint64_t end,
+    uint64_t tick) {
+  //Only the changes (a capture can repeat a level)
+  std::vector<Edge> t;
+  bool level = true;
+  for (size_t i = 0; i < edges.size(); i++) {
+    if (edges[i].level != level) {
+      t.push_back(edges[i]);
+      level = edges[i].level;
+    }
+  }
+
+  Waveform w;
+  memset(&w, 0, sizeof(w));
+  w.slotsMin = UINT16_MAX;
+  w.breakMin = w.mabMin = w.periodMin = w.chunkMin = 1e12;
+  double periodTotal = 0;
+
+  bool inFrame = false; //Seen the first break
+  uint64_t frameStart = 0, lastSlot = 0, lastChunk = 0;
+  uint16_t slots = 0;
+  size_t i = 0;
+  while (i + 1 < t.size()) {
+    if (t[i].level) {
+      i++; //Look for the next falling edge
+      continue;
+    }
+    uint64_t fall = t[i].time;
+    uint64_t rise = t[i + 1].time;
+
+    if (rise - fall >= BREAK_DETECT) {
+      if (i + 2 >= t.size()) {
+        break; //The MAB runs past the end
+      }
+      if (inFrame) {
+        double period = (fall - frameStart) / 1000.0;
+        keep(period, &w.periodMin, &w.periodMax);
+        periodTotal += period;
+        w.slotsMin = std::min(w.slotsMin, slots);
+        w.slotsMax = std::max(w.slotsMax, slots);
+        w.frames++;
+      }
+      keep((rise - fall) / 1000.0, &w.breakMin, &w.breakMax);
+      keep((t[i + 2].time - rise) / 1000.0, &w.mabMin, &w.mabMax);
+      if (lastChunk) {
+        chunk(&w, fall - lastChunk, tick);
+      }
+      inFrame = true;
+      frameStart = fall;
+      lastChunk = fall; //The break goes out first in its chunk
+      lastSlot = 0;
+      slots = 0;
+      i += 2;
+      continue;
+    }
+
+    if (fall + DMX_SLOT_BITS * DMX_BIT_TIME > end) {
+      break; //Cut off by the end of the capture
+    }
+    if (inFrame) {
+      if (levelAt(t, fall + DMX_BIT_TIME / 2) ||
+          !levelAt(t, fall + (STOP_BITS_START * 2 + 1) * DMX_BIT_TIME / 2) ||
+          !levelAt(t, fall + (STOP_BITS_START * 2 + 3) * DMX_BIT_TIME / 2)) {
+        w.errors++;
+      }
+      if (lastSlot) {
+        uint64_t slotEnd = lastSlot + DMX_SLOT_BITS * DMX_BIT_TIME;
+        uint64_t gap = fall > slotEnd ? fall - slotEnd : 0;
+        w.gapMax = std::max(w.gapMax, gap / 1000.0);
+        if (gap > CHUNK_GAP) {
+          chunk(&w, fall - lastChunk, tick);
+          lastChunk = fall;
+        }
+      }
+      lastSlot = fall;
+      slots++;
+    }
+
+    //Every edge up to the stop bits should be on a bit boundary
+    uint64_t stop = fall + STOP_BITS_START * DMX_BIT_TIME + DMX_BIT_TIME / 2;
+    size_t j = i + 1;
+    for (; j < t.size() && t[j].time < stop; j++) {
+      if (inFrame) {
+        uint64_t off = (t[j].time - fall) % DMX_BIT_TIME;
+        uint64_t error = std::min(off, DMX_BIT_TIME - off);
+        w.bitErrorMax = std::max(w.bitErrorMax, error / 1000.0);
+      }
+    }
+    i = j;
+  }
+
+  if (w.frames) {
+    w.periodAvg = periodTotal / w.frames;
+  } else {
+    w.slotsMin = 0;
+    w.breakMin = w.mabMin = w.periodMin = 0;
+  }
+  if (w.chunkMax == 0) {
+    w.chunkMin = 0;
+  }
+  return w;
+}
+
+/**
+ * levelAt - Finds the level of the line at a time. The line idles high
+ * before the first edge.
+ */
+static bool levelAt(const std::vector<Edge> &edges, uint64_t time) {
+  std::vector<Edge>::const_iterator next = std::upper_bound(edges.begin(),
+      edges.end(), time, [](uint64_t t, const Edge &e) { return t < e.time; });
+  return next == edges.begin() ? true : (next - 1)->level;
+}
+
+/**
+ * chunk - Takes in the time between the starts of two chunks. The transmit
+ * interrupt can skip ticks, so the jitter is how far the time is from a
+ * whole number of them.
+ */
+static void chunk(Waveform *w, uint64_t interval, uint64_t tick) {
+  keep(interval / 1000.0, &w->chunkMin, &w->chunkMax);
+  if (tick) {
+    uint64_t off = interval % tick;
+    w->jitterMax = std::max(w->jitterMax, std::min(off, tick - off) / 1000.0);
+  }
+}
+
+/**
+ * keep - Widens a range to take in a value.
+ */
+static void keep(double value, double *min, double *max) {
+  *min = std::min(*min, value);
+  *max = std::max(*max, value);
+}
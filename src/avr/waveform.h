@@ -0,0 +1,87 @@
+/**
+ * DMX-84
+ * DMX waveform decoder header
+ *
+ * This file contains the external defines and prototypes for decoding the
+ * edges captured on a DMX output into frames and timing: break, MAB, slots
+ * and the gaps between the chunks of slots the transmit interrupt sends.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <inttypes.h>
+#include <vector>
+
+/******************************************************************************
+ * External constants
+ ******************************************************************************/
+
+//DMX bit time (nanoseconds): 250 kbaud
+#define DMX_BIT_TIME          4000
+
+//A slot is a start bit, 8 data bits and 2 stop bits
+#define DMX_SLOT_BITS         11
+
+/******************************************************************************
+ * Types
+ ******************************************************************************/
+
+//A change on the line (nanoseconds since power up)
+struct Edge {
+  uint64_t time;
+  bool level;
+};
+
+//What the frames in a capture looked like. Times are in microseconds.
+struct Waveform {
+  uint32_t frames;         //Complete frames (break to the next break)
+  uint32_t errors;         //Slots with a bad start or stop bit
+  uint16_t slotsMin;       //Slots per frame, start code included
+  uint16_t slotsMax;
+  double breakMin;
+  double breakMax;
+  double mabMin;
+  double mabMax;
+  double periodMin;        //Break to break
+  double periodAvg;
+  double periodMax;
+  double bitErrorMax;      //Furthest an edge was from its bit boundary
+  double gapMax;           //Longest from the end of a slot to the next start
+  double chunkMin;         //Between the starts of chunks of back-to-back
+  double chunkMax;         //slots (one per transmit interrupt)
+  double jitterMax;        //Furthest a chunk started off the interrupt's tick
+};
+
+/******************************************************************************
+ * External function prototypes
+ ******************************************************************************/
+
+//Decodes the edges on a line that idles high, captured until end. tick is
+//the period of the transmit interrupt (nanoseconds), or 0 if there isn't one.
+Waveform decodeWaveform(const std::vector<Edge> &edges, uint64_t end,
+    uint64_t tick);
+
+#endif
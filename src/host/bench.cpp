@@ -0,0 +1,428 @@
+/**
+ * DMX-84
+ * Host command benchmark
+ *
+ * Runs every protocol command through processCommand() in the firmware built
+ * for the host, and prints how long each took. The host is much faster than
+ * the ATmega328P, so the times only mean something compared with each other
+ * and with an earlier run: save one with -o before a change and compare with
+ * -c after it to catch commands that got slower before anything is flashed.
+ *
+ * The sim column is the time the command spent on the simulated clock:
+ * delays, EEPROM writes and reads of the clock and pins (see hal.h). Those
+ * are what the host time can't show. With no calculator attached, a reply a
+ * command sends itself instead of through collect() (0xF3's) waits out the
+ * link timeout, which shows there too.
+ *
+ * After the commands it times the pin operations of a link bit both through
+ * the Arduino core calls (digitalRead, digitalWrite, pinMode) and through
+ * FastPin (fastpin.h), which the link uses. On the host both are a few
+ * nanoseconds of plain memory access (a sample is mostly the HAL's modelled
+ * pin read), so the table shows the two agree in cost and behaviour there,
+ * not the saving on the chip. Compiled for the ATmega328P, counted along the
+ * path a plain (non-PWM) pin takes, the core calls cost:
+ *    digitalWrite             76 cycles with the call, FastPin 2 (sbi/cbi)
+ *    digitalRead              66 cycles with the call, FastPin 1-3 (sbic/in)
+ *    pinMode + digitalWrite   136-145 cycles, FastPin 4 (cbi and sbi)
+ *
+ * Usage: firmware_bench [-r repeat] [-o file] [-c file] [-t percent] [-q]
+ *    -r repeat   times to run each command (default 1000)
+ *    -o file     save the average times as a baseline
+ *    -c file     compare with a saved baseline; fail if a command is more
+ *                than -t percent slower (default 50)
+ *    -q          quiet: only print commands that failed
+ *
+ * It fails if any command is unknown to the firmware or rejects its packet.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include <DmxSimple.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <chrono>
+#include <map>
+#include <string>
+
+#include "firmware.h"
+#include "fastpin.h"
+#include "link.h"
+#include "status.h"
+#include "hal.h"
+
+/******************************************************************************
+ * Internal constants
+ ******************************************************************************/
+
+#define MAX_PACKET            (1 + DMX_SIZE)
+
+//Nanoseconds a command may take over its baseline before -c fails, in percent
+#define DEFAULT_TOLERANCE     50
+
+//Commands faster than this are too close to the timer's resolution to compare
+#define MIN_COMPARED_TIME     200
+
+//An unused pin on the same port as the link lines, for timing pin access
+#define BENCH_PIN             7
+
+//Pin operations timed per repeat
+#define PIN_LOOPS             100
+
+/******************************************************************************
+ * Internal types
+ ******************************************************************************/
+
+struct Command {
+  const char *name;
+  const char *hex;      //The command packet
+  unsigned fill;        //Extra bytes appended after hex, counting up from 0
+  const char *undo;     //Run after each timed run so the next starts the same
+};
+
+/******************************************************************************
+ * Internal variables
+ ******************************************************************************/
+
+/* One representative packet per command, in an order that leaves each one
+ * able to run (DMX on for 0xE2, a scene stored for the recalls). 0xF0 and
+ * 0xF1 are left out, since in restricted mode they shut down.
+ */
+static const Command suite[] = {
+  {"Heartbeat",                "00",                         0,   NULL},
+  {"Restricted mode",          "01",                         0,   NULL},
+  {"Batch of 2",               "02 03 10 05 80 02 12 05",    0,   NULL},
+  {"Cue",                      "03 00 00 00 00 40 10 05 80", 0,   "03 FF"},
+  {"Read clock",               "04",                         0,   NULL},
+  {"Set channel",              "10 05 80",                   0,   NULL},
+  {"Set channel (high)",       "11 05 80",                   0,   NULL},
+  {"Increment channel",        "12 05",                      0,   NULL},
+  {"Increment (high)",         "13 05",                      0,   NULL},
+  {"Decrement channel",        "14 05",                      0,   NULL},
+  {"Decrement (high)",         "15 05",                      0,   NULL},
+  {"Increment channel by",     "16 05 10",                   0,   NULL},
+  {"Increment by (high)",      "17 05 10",                   0,   NULL},
+  {"Decrement channel by",     "18 05 10",                   0,   NULL},
+  {"Decrement by (high)",      "19 05 10",                   0,   NULL},
+  {"Set 256 channels",         "20",                         256, NULL},
+  {"Set 256 channels (high)",  "21",                         256, NULL},
+  {"Set 64-channel block",     "22 00 40",                   64,  NULL},
+  {"Set block (high)",         "23 00 40",                   64,  NULL},
+  {"Increment all",            "24 01",                      0,   NULL},
+  {"Decrement all",            "25 01",                      0,   NULL},
+  {"Set all",                  "26 80",                      0,   NULL},
+  {"Set universe",             "27",                         512, NULL},
+  {"Commit",                   "28",                         0,   NULL},
+  {"Commit mode",              "29 01",                      0,   NULL},
+  {"RLE universe",             "2A 00 00 FF 80 FF 80 FF 80 FF 80", 0, NULL},
+  {"Delta, 2 channels",        "2B 10 00 81 01",             0,   NULL},
+  {"Scatter, 4 pairs",         "2C 0A 01 10 02 20 03 30 04 40", 0, NULL},
+  {"Scatter, 16 pairs",        "2C 0F 01 10 02 20 03 30 04 40 05 50 06 60 "
+                               "07 70 08 80 F0 09 90 0A A0 0B B0 0C C0 0D D0 "
+                               "0E E0 0F F0 10 FF",          0,   NULL},
+  {"Bitmap scatter, 4",        "2E 00 00 01 0F 10 20 30 40", 0,   NULL},
+  {"Copy high to low",         "30",                         0,   NULL},
+  {"Copy low to high",         "31",                         0,   NULL},
+  {"Exchange halves",          "32",                         0,   NULL},
+  {"Read channel",             "40 05",                      0,   NULL},
+  {"Read channel (high)",      "41 05",                      0,   NULL},
+  {"Read universe",            "42",                         0,   NULL},
+  {"Read RLE chunk",           "43 00 00",                   0,   NULL},
+  {"Fade",                     "50 0A 00",                   0,   NULL},
+  {"Split fade",               "51 0A 00 14 00 00 00 05 00", 0,   NULL},
+  {"Fade progress",            "52",                         0,   NULL},
+  {"Stop fade",                "53",                         0,   NULL},
+  {"Store scene",              "60 0F",                      0,   NULL},
+  {"Recall scene",             "61 0F",                      0,   NULL},
+  {"Recall scene with fade",   "62 0F 0A 00",                0,   "53"},
+  {"Scene info",               "64",                         0,   NULL},
+  {"Delete scene",             "63 0F",                      0,   "60 0F"},
+  {"Start effect",             "70 00 01 00 00 10 00 64 00 00 10 FF 00", 0,
+                                                                  NULL},
+  {"Stop effects",             "71",                         0,   NULL},
+  {"Set curve",                "80 00 00 20 00 01 00",       0,   NULL},
+  {"Upload user curve",        "81 00",                      16,  NULL},
+  {"Clear curves",             "82",                         0,   NULL},
+  {"Group bitmap",             "90 00 00",                   64,  NULL},
+  {"Group range",              "91 01 00 00 40 00 01",       0,   NULL},
+  {"Grand master",             "93 FF",                      0,   NULL},
+  {"Submaster",                "94 FF",                      0,   NULL},
+  {"Debug LED",                "DB",                         0,   NULL},
+  {"Stop DMX",                 "E0",                         0,   "E1"},
+  {"Start DMX",                "E1",                         0,   NULL},
+  {"Max channels",             "E2 80",                      0,   NULL},
+  {"Max channels (high)",      "E3 00",                      0,   NULL},
+  {"Start blackout",           "E4",                         0,   NULL},
+  {"Stop blackout",            "E5",                         0,   NULL},
+  {"Break timing",             "E6 58 00 08 00",             0,   NULL},
+  {"Frame rate",               "E7 00 00 00",                0,   NULL},
+  {"Start code",               "E8 00",                      0,   NULL},
+  {"Auto-trim",                "E9 00",                      0,   NULL},
+  {"Trace level",              "F2 02",                      0,   NULL},
+  {"Timed command",            "F3 04 10 05 80",             0,   NULL},
+  {"Stats",                    "F4",                         0,   NULL},
+  {"Reset stats",              "F5",                         0,   NULL},
+  {"Frame timing",             "F6",                         0,   NULL},
+#if LINK_FAULTS_ENABLED
+  {"Inject fault",             "F7 00 00",                   0,   NULL},
+#endif
+  {"Status",                   "F8",                         0,   NULL},
+  {"Errors",                   "F9",                         0,   NULL},
+  {"Versions",                 "FA",                         0,   NULL},
+  {"Protocol version",         "FB",                         0,   NULL},
+  {"Firmware version",         "FC",                         0,   NULL},
+  {"Temperature",              "FD",                         0,   NULL},
+  {"Uptime",                   "FE",                         0,   NULL}
+};
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**
+ * parse - Turns a command's hex and fill into a packet.
+ *
+ * Returns:
+ *    uint16_t length: the length of the packet
+ */
+static uint16_t parse(const char *hex, unsigned fill, uint8_t *packet) {
+  uint16_t length = 0;
+  unsigned byte;
+  int used;
+  while (sscanf(hex, " %x%n", &byte, &used) == 1) {
+    packet[length++] = byte;
+    hex += used;
+  }
+  for (unsigned i = 0; i < fill; i++) {
+    packet[length++] = i & 0xFF;
+  }
+  return length;
+}
+
+/**
+ * run - Runs one command packet the way loop() does. Anything it would send
+ * to the calculator is dropped.
+ */
+static void run(uint8_t *packet, uint16_t length) {
+  uint8_t dropped;
+  Link.packetData = packet;
+  Link.packetLength = length;
+  Link.collect(&dropped, 0);
+  DmxSimple.beginWrite();
+  processCommand(packet[0]);
+  DmxSimple.endWrite();
+  Link.collected();
+}
+
+/**
+ * readBaseline - Loads average times saved with -o.
+ */
+static bool readBaseline(const char *path, std::map<std::string, double> &times) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    return false;
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), file)) {
+    char hex[128];
+    double time;
+    //The packet is quoted, since it has spaces in it
+    if (sscanf(line, "\"%127[^\"]\" %lf", hex, &time) == 2) {
+      times[hex] = time;
+    }
+  }
+  fclose(file);
+  return true;
+}
+
+/**
+ * timeLoop - Runs an operation over and over.
+ *
+ * Returns:
+ *    double time: the average nanoseconds it took
+ */
+template <typename Operation>
+static double timeLoop(unsigned loops, Operation operation) {
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < loops; i++) {
+    operation();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / loops;
+}
+
+/**
+ * benchPins - Times the pin operations of a link bit through the Arduino core
+ * calls and through FastPin, and prints them.
+ */
+static void benchPins(unsigned repeat) {
+  typedef FastPin<BENCH_PIN> Pin;
+  unsigned loops = repeat * PIN_LOOPS;
+  volatile uint8_t sampled = 0;
+
+  double coreWrite = timeLoop(loops, [] {
+    digitalWrite(BENCH_PIN, HIGH);
+    digitalWrite(BENCH_PIN, LOW);
+  });
+  double fastWrite = timeLoop(loops, [] {
+    Pin::high();
+    Pin::low();
+  });
+  double coreRead = timeLoop(loops, [&] {
+    sampled = sampled + digitalRead(BENCH_PIN);
+  });
+  double fastRead = timeLoop(loops, [&] {
+    sampled = sampled + Pin::read();
+  });
+  double corePull = timeLoop(loops, [] {
+    pinMode(BENCH_PIN, OUTPUT);
+    digitalWrite(BENCH_PIN, LOW);
+    pinMode(BENCH_PIN, INPUT);
+    digitalWrite(BENCH_PIN, HIGH);
+  });
+  double fastPull = timeLoop(loops, [] {
+    Pin::pull();
+    Pin::release();
+  });
+  pinMode(BENCH_PIN, INPUT);
+  digitalWrite(BENCH_PIN, LOW);
+
+  printf("\nPin access                    %8s %8s %9s\n", "core ns",
+      "fast ns", "core/fast");
+  printf("Write high, then low          %8.1f %8.1f %8.1fx\n", coreWrite,
+      fastWrite, coreWrite / fastWrite);
+  printf("Sample a line                 %8.1f %8.1f %8.1fx\n", coreRead,
+      fastRead, coreRead / fastRead);
+  printf("Pull a line, then release it  %8.1f %8.1f %8.1fx\n", corePull,
+      fastPull, corePull / fastPull);
+}
+
+int main(int argc, char **argv) {
+  unsigned repeat = 1000, tolerance = DEFAULT_TOLERANCE;
+  const char *savePath = NULL, *comparePath = NULL;
+  bool quiet = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "r:o:c:t:q")) != -1) {
+    switch (opt) {
+      case 'r': repeat = strtoul(optarg, 0, 0); break;
+      case 'o': savePath = optarg; break;
+      case 'c': comparePath = optarg; break;
+      case 't': tolerance = strtoul(optarg, 0, 0); break;
+      case 'q': quiet = true; break;
+      default:
+        fprintf(stderr, "Usage: %s [-r repeat] [-o file] [-c file] "
+            "[-t percent] [-q]\n", argv[0]);
+        return 2;
+    }
+  }
+  if (repeat < 1) {
+    fprintf(stderr, "%s: -r must be at least 1\n", argv[0]);
+    return 2;
+  }
+  std::map<std::string, double> baseline;
+  if (comparePath && !readBaseline(comparePath, baseline)) {
+    perror(comparePath);
+    return 2;
+  }
+  FILE *save = savePath ? fopen(savePath, "w") : NULL;
+  if (savePath && !save) {
+    perror(savePath);
+    return 2;
+  }
+
+  setup();
+
+  if (!quiet) {
+    printf("Cmd  %-24s %8s %8s %8s %9s\n", "", "min ns", "avg ns", "max ns",
+        "sim us");
+  }
+  int failed = 0;
+  for (unsigned i = 0; i < sizeof(suite) / sizeof(suite[0]); i++) {
+    const Command &command = suite[i];
+    uint8_t packet[MAX_PACKET], undo[MAX_PACKET];
+    uint16_t length = parse(command.hex, command.fill, packet);
+    uint16_t undoLength = command.undo ? parse(command.undo, 0, undo) : 0;
+
+    Error.reset();
+    double total = 0, minTime = 1e30, maxTime = 0;
+    uint64_t simTotal = 0;
+    for (unsigned r = 0; r < repeat; r++) {
+      uint8_t copy[MAX_PACKET];
+      memcpy(copy, packet, length);
+      uint64_t simStart = halNow();
+      auto start = std::chrono::steady_clock::now();
+      run(copy, length);
+      auto end = std::chrono::steady_clock::now();
+      simTotal += halNow() - simStart;
+      double time = std::chrono::duration<double, std::nano>(end - start).count();
+      total += time;
+      minTime = std::min(minTime, time);
+      maxTime = std::max(maxTime, time);
+      if (undoLength) {
+        memcpy(copy, undo, undoLength);
+        run(copy, undoLength);
+      }
+    }
+    double avgTime = total / repeat;
+
+    const char *problem = NULL;
+    if (Error.test(UNKNOWN_COMMAND_ERROR)) {
+      problem = "unknown command";
+    } else if (Error.test(INVALID_VALUE_ERROR)) {
+      problem = "packet rejected";
+    } else if (baseline.count(command.hex)) {
+      double before = baseline[command.hex];
+      if (before >= MIN_COMPARED_TIME &&
+          avgTime > before * (100 + tolerance) / 100) {
+        problem = "slower than baseline";
+      }
+    }
+    if (!quiet || problem) {
+      printf("0x%.2s %-24s %8.0f %8.0f %8.0f %9.1f", command.hex,
+          command.name, minTime, avgTime, maxTime,
+          simTotal / 1000.0 / repeat);
+      if (problem) {
+        printf("  FAILED: %s", problem);
+        if (baseline.count(command.hex)) {
+          printf(" (%.0f ns before)", baseline[command.hex]);
+        }
+      }
+      printf("\n");
+    }
+    if (problem) {
+      failed++;
+    }
+    if (save) {
+      fprintf(save, "\"%s\" %.1f\n", command.hex, avgTime);
+    }
+  }
+
+  if (save) {
+    fclose(save);
+  }
+  if (!quiet) {
+    benchPins(repeat);
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,299 @@
+/**
+ * DMX-84
+ * Bridge end-to-end test
+ *
+ * Runs dmxbridge (../pc/bridge.cpp) against the firmware built for the host,
+ * connected by a pty as if it were the adapter's USB serial port. Art-Net
+ * frames are sent to the bridge on 127.0.0.1, and the test checks that the
+ * universe ends up in dmxOutput, that no serial character was lost to a full
+ * receive buffer, and that the bridge got an answer to every update.
+ *
+ * The simulated clock is kept in step with the real one, so the serial port
+ * runs at its real speed.
+ *
+ * Usage: firmware_bridgetest [-v] <dmxbridge>
+ *    -v          pass -v to the bridge and print its stats
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include <DmxSimple.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "firmware.h"
+#include "hal.h"
+
+/******************************************************************************
+ * Internal constants
+ ******************************************************************************/
+
+//Art-Net ArtDmx layout (as in bridge.cpp)
+#define ARTNET_OPDMX          0x5000
+#define ARTNET_HEADER_LENGTH  18
+
+//Frames sent, and the real time between them (seconds)
+#define FRAME_COUNT           40
+#define FRAME_PERIOD          0.025
+
+//Real time allowed for the last frame to reach dmxOutput, and to wait after
+//it for any late answers (seconds)
+#define SETTLE_TIMEOUT        20.0
+#define QUIET_TIME            0.5
+
+//Most the simulated clock moves at a time (nanoseconds), well under the time
+//the serial port takes to fill the receive buffer
+#define MAX_STEP              1000000
+
+/******************************************************************************
+ * Internal variables
+ ******************************************************************************/
+
+static uint8_t frame[DMX_SIZE];
+
+static double realStart;
+static uint64_t simStart;
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * runFor - Runs loop() for a while of real time, moving the simulated clock
+ * along with the real one.
+ */
+static void runFor(double seconds) {
+  double end = now() + seconds;
+  while (now() < end) {
+    loop();
+    uint64_t target = simStart + (uint64_t)((now() - realStart) * 1e9);
+    if (halNow() < target) {
+      uint64_t step = target - halNow();
+      halAdvance(step < MAX_STEP ? step : MAX_STEP);
+    } else {
+      usleep(100);
+    }
+  }
+}
+
+/**
+ * committed - Checks whether dmxOutput holds the last frame sent.
+ */
+static bool committed(void) {
+  for (uint16_t i = 0; i < DMX_SIZE; i++) {
+    if (dmxOutput[i] != frame[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * sendFrame - Sends the frame to the bridge as ArtDmx for universe 0.
+ */
+static void sendFrame(int fd, const struct sockaddr_in *to) {
+  uint8_t packet[ARTNET_HEADER_LENGTH + DMX_SIZE];
+  memset(packet, 0, ARTNET_HEADER_LENGTH);
+  memcpy(packet, "Art-Net", 8);
+  packet[8] = ARTNET_OPDMX & 0xFF;
+  packet[9] = ARTNET_OPDMX >> 8;
+  packet[11] = 14; //Protocol version
+  packet[16] = DMX_SIZE >> 8;
+  packet[17] = DMX_SIZE & 0xFF;
+  memcpy(packet + ARTNET_HEADER_LENGTH, frame, DMX_SIZE);
+  sendto(fd, packet, sizeof(packet), 0, (const struct sockaddr *)to,
+      sizeof(*to));
+}
+
+/**
+ * freePort - Finds a UDP port nothing is listening on.
+ */
+static unsigned freePort(void) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t length = sizeof(addr);
+  if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      getsockname(fd, (struct sockaddr *)&addr, &length) < 0) {
+    return 0;
+  }
+  close(fd);
+  return ntohs(addr.sin_port);
+}
+
+int main(int argc, char **argv) {
+  bool verbose = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "v")) != -1) {
+    switch (opt) {
+      case 'v': verbose = true; break;
+      default: optind = argc + 1; break;
+    }
+  }
+  if (optind != argc - 1) {
+    fprintf(stderr, "Usage: %s [-v] <dmxbridge>\n", argv[0]);
+    return 2;
+  }
+
+  //The pty stands in for the USB serial port. Its slave end is made raw and
+  //kept open before anything is written, so nothing is echoed back.
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+    perror("pty");
+    return 1;
+  }
+  const char *slavePath = ptsname(master);
+  int slave = open(slavePath, O_RDWR | O_NOCTTY);
+  struct termios tio;
+  if (slave < 0 || tcgetattr(slave, &tio) < 0) {
+    perror(slavePath);
+    return 1;
+  }
+  cfmakeraw(&tio);
+  tcsetattr(slave, TCSANOW, &tio);
+  fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+  unsigned port = freePort();
+  if (!port) {
+    perror("udp");
+    return 1;
+  }
+
+  //Start the bridge, with its stats on a pipe
+  int stats[2];
+  if (pipe(stats) < 0) {
+    perror("pipe");
+    return 1;
+  }
+  char portText[8];
+  snprintf(portText, sizeof(portText), "%u", port);
+  pid_t bridge = fork();
+  if (bridge == 0) {
+    dup2(stats[1], STDOUT_FILENO);
+    close(stats[0]);
+    close(master);
+    if (verbose) {
+      execl(argv[optind], argv[optind], "-v", "-A", portText, "-E", "0",
+          "-s", "0", slavePath, (char *)0);
+    } else {
+      execl(argv[optind], argv[optind], "-A", portText, "-E", "0", "-s", "0",
+          slavePath, (char *)0);
+    }
+    perror(argv[optind]);
+    _exit(127);
+  }
+  close(stats[1]);
+
+  setup();
+  halSerialConnect(master, master);
+  realStart = now();
+  simStart = halNow();
+  runFor(QUIET_TIME); //Let the bridge open its sockets
+
+  int udp = socket(AF_INET, SOCK_DGRAM, 0);
+  struct sockaddr_in to;
+  memset(&to, 0, sizeof(to));
+  to.sin_family = AF_INET;
+  to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  to.sin_port = htons(port);
+
+  //A chase across the universe, faster than the port can carry it, then a
+  //look that changes every channel
+  for (uint16_t i = 0; i < FRAME_COUNT; i++) {
+    memset(frame, 0, sizeof(frame));
+    for (uint16_t j = 0; j < 16; j++) {
+      frame[(i * 12 + j) % DMX_SIZE] = 0xFF - j * 8;
+    }
+    sendFrame(udp, &to);
+    runFor(FRAME_PERIOD);
+  }
+  for (uint16_t i = 0; i < DMX_SIZE; i++) {
+    frame[i] = i * 7 + 3;
+  }
+  sendFrame(udp, &to);
+
+  double deadline = now() + SETTLE_TIMEOUT;
+  while (!committed() && now() < deadline) {
+    runFor(FRAME_PERIOD);
+  }
+  runFor(QUIET_TIME);
+
+  int failures = 0;
+  if (!committed()) {
+    printf("FAIL: the last frame didn't reach dmxOutput in %.0f s\n",
+        SETTLE_TIMEOUT);
+    failures++;
+  }
+  if (halSerialOverruns()) {
+    printf("FAIL: %u serial characters lost to a full receive buffer\n",
+        (unsigned)halSerialOverruns());
+    failures++;
+  }
+
+  //The bridge prints its totals as it exits
+  kill(bridge, SIGTERM);
+  char text[4096];
+  size_t length = 0;
+  ssize_t n;
+  while (length < sizeof(text) - 1 &&
+      (n = read(stats[0], text + length, sizeof(text) - 1 - length)) > 0) {
+    length += n;
+  }
+  text[length] = 0;
+  int status;
+  waitpid(bridge, &status, 0);
+  if (verbose) {
+    fputs(text, stdout);
+  }
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    printf("FAIL: dmxbridge exited with status %d\n", status);
+    failures++;
+  } else if (!strstr(text, "(0 unanswered)")) {
+    printf("FAIL: the adapter didn't answer every update:\n%s", text);
+    failures++;
+  }
+
+  close(udp);
+  close(slave);
+  close(master);
+  return failures;
+}
@@ -0,0 +1,359 @@
+/**
+ * DMX-84
+ * Simulated calculator
+ *
+ * This file contains a calculator for the simulated link lines of the host
+ * build (see calculator.h).
+ *
+ * The TI link is two open collector lines. To send a 1 the sender pulls ring
+ * and the receiver answers by pulling tip; the sender lets go of ring, then
+ * the receiver of tip. A 0 is the same with the lines swapped. Each step here
+ * happens stepTime after the calculator sees the line change it waits for.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include <stdint.h>
+
+#include "firmware.h"
+#include "link.h"
+#include "calculator.h"
+
+/******************************************************************************
+ * Internal constants
+ ******************************************************************************/
+
+#define STATE_IDLE            0 //Waiting for a bit from either side
+#define STATE_RX_RELEASE      1 //Acknowledged a bit, waiting for its release
+#define STATE_TX_ACK          2 //Pulled a line, waiting for the acknowledgment
+#define STATE_TX_RELEASE      3 //Let go, waiting for the acknowledgment to end
+
+#define NONE                  SIZE_MAX
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+Calculator::Calculator(void) {
+  stepTime = CALC_STEP_TIME;
+  aborted = false;
+  state = STATE_IDLE;
+  since = 0;
+  actAt = 0;
+  seenRing = true;
+  seenTip = true;
+  txIndex = 0;
+  txBit = 0;
+  rxByte = 0;
+  rxBit = 0;
+  extraDelay = 0;
+  delayEnd = 0;
+  dropAt = NONE;
+  stuckPin = 0;
+  stuckUntil = 0;
+}
+
+/**
+ * send - Queues a packet to send to the adapter.
+ *
+ * Parameters:
+ *    uint8_t command: the command ID (CMD_DATA, CMD_RDY...)
+ *    const uint8_t *data: the packet data
+ *    uint16_t length: the length of data (packets without data have no
+ *                     checksum)
+ *    bool badChecksum: true to send a wrong checksum
+ */
+void Calculator::send(uint8_t command, const uint8_t *data, uint16_t length,
+    bool badChecksum) {
+  Packet bytes;
+  bytes.push_back(CALC_MACHINE_ID);
+  bytes.push_back(command);
+  bytes.push_back(length & 0xFF);
+  bytes.push_back(length >> 8);
+  if (length > 0) {
+    uint16_t sum = 0;
+    for (uint16_t i = 0; i < length; i++) {
+      bytes.push_back(data[i]);
+      sum += data[i];
+    }
+    if (badChecksum) {
+      sum ^= 0x0100;
+    }
+    bytes.push_back(sum & 0xFF);
+    bytes.push_back(sum >> 8);
+  }
+  sendRaw(bytes);
+}
+
+/**
+ * sendRaw - Queues bytes to send to the adapter as they are.
+ */
+void Calculator::sendRaw(const Packet &bytes) {
+  tx.insert(tx.end(), bytes.begin(), bytes.end());
+}
+
+/**
+ * sending - Checks whether anything is still waiting to be sent.
+ */
+bool Calculator::sending(void) {
+  return txIndex < tx.size();
+}
+
+/**
+ * abort - Lets go of the lines and forgets what was being sent and received.
+ */
+void Calculator::abort(void) {
+  halPull(TI_RING_PIN, stuckUntil && stuckPin == TI_RING_PIN);
+  halPull(TI_TIP_PIN, stuckUntil && stuckPin == TI_TIP_PIN);
+  state = STATE_IDLE;
+  actAt = 0;
+  tx.clear();
+  txIndex = 0;
+  txBit = 0;
+  rx.clear();
+  rxBit = 0;
+  delayEnd = 0;
+  dropAt = NONE;
+}
+
+/**
+ * delaySteps - Slows every step down while the next bytes are sent.
+ *
+ * Parameters:
+ *    uint64_t extra: nanoseconds added to each step
+ *    uint16_t bytes: how many of the bytes queued from now on are slowed
+ */
+void Calculator::delaySteps(uint64_t extra, uint16_t bytes) {
+  extraDelay = extra;
+  delayEnd = tx.size() + bytes;
+}
+
+/**
+ * dropEdge - Loses the adapter's acknowledgment of the first bit of a byte,
+ * so the calculator waits for it until it times out.
+ *
+ * Parameter:
+ *    uint16_t byte: the index of the byte, counting from the next one queued
+ */
+void Calculator::dropEdge(uint16_t byte) {
+  dropAt = tx.size() + byte;
+}
+
+/**
+ * stick - Holds a line low for a while. The calculator does nothing else
+ * meanwhile.
+ *
+ * Parameters:
+ *    uint8_t pin: TI_RING_PIN or TI_TIP_PIN
+ *    uint64_t time: how long (nanoseconds)
+ */
+void Calculator::stick(uint8_t pin, uint64_t time) {
+  stuckPin = pin;
+  stuckUntil = halNow() + time;
+  halPull(pin, true);
+}
+
+/**
+ * step - Takes the next step of the handshake once its line change has been
+ * seen and the reaction time has passed. The calculator watches the lines
+ * all the time, so a change is noticed even if it only lasts a moment.
+ */
+uint64_t Calculator::step(uint64_t now) {
+  if (stuckUntil) {
+    if (now < stuckUntil) {
+      return stuckUntil;
+    }
+    stuckUntil = 0;
+    halPull(stuckPin, false);
+    since = now;
+    actAt = 0;
+  }
+
+  if (!actAt) {
+    bool ring = halLevel(TI_RING_PIN);
+    bool tip = halLevel(TI_TIP_PIN);
+    if (!ready(ring, tip)) {
+      bool busy = state != STATE_IDLE || rxBit || !rx.empty();
+      if (!busy) {
+        return 0;
+      }
+      if (now - since < CALC_TIMEOUT) {
+        return since + CALC_TIMEOUT;
+      }
+      //The adapter stopped answering; give up on whatever was going on
+      if (state != STATE_IDLE || sending()) {
+        aborted = true;
+        abort();
+      } else {
+        rx.clear();
+        rxBit = 0;
+      }
+      return 0;
+    }
+
+    //Seen now, acted on after the reaction time even if the lines change
+    //again meanwhile
+    seenRing = ring;
+    seenTip = tip;
+    actAt = now + stepTime;
+    if (txIndex < delayEnd) {
+      actAt += extraDelay;
+    }
+  }
+  if (now < actAt) {
+    return actAt;
+  }
+  actAt = 0;
+  act(seenRing, seenTip);
+  since = now;
+  return now + 1; //Look again once the adapter has reacted
+}
+
+/**
+ * ready - Checks whether the line change the current state waits for has
+ * happened.
+ */
+bool Calculator::ready(bool ring, bool tip) {
+  switch (state) {
+    case STATE_IDLE:
+      return ring != tip || (ring && tip && sending());
+    case STATE_RX_RELEASE:
+      //Waiting for the adapter to let go of the line it pulled
+      return (rxByte & 0x80) ? ring : tip;
+    case STATE_TX_ACK:
+      if (txIndex == dropAt && txBit == 0) {
+        return false; //The acknowledgment never arrives
+      }
+      return ((tx[txIndex] >> txBit) & 1) ? !tip : !ring;
+    case STATE_TX_RELEASE:
+      return ((tx[txIndex] >> txBit) & 1) ? tip : ring;
+  }
+  return false;
+}
+
+/**
+ * act - Takes the step the current state is waiting to take.
+ */
+void Calculator::act(bool ring, bool tip) {
+  switch (state) {
+    case STATE_IDLE: {
+      if (!ring) {
+        //A 1 from the adapter; acknowledge with tip
+        rxByte = (rxByte >> 1) | 0x80;
+        halPull(TI_TIP_PIN, true);
+        state = STATE_RX_RELEASE;
+      } else if (!tip) {
+        rxByte >>= 1;
+        halPull(TI_RING_PIN, true);
+        state = STATE_RX_RELEASE;
+      } else {
+        //Both lines idle: send the next bit
+        bool one = (tx[txIndex] >> txBit) & 1;
+        halPull(one ? TI_RING_PIN : TI_TIP_PIN, true);
+        state = STATE_TX_ACK;
+      }
+      break;
+    }
+
+    case STATE_RX_RELEASE: {
+      halPull((rxByte & 0x80) ? TI_TIP_PIN : TI_RING_PIN, false);
+      state = STATE_IDLE;
+      if (++rxBit == 8) {
+        rxBit = 0;
+        receivedByte(rxByte);
+      }
+      break;
+    }
+
+    case STATE_TX_ACK: {
+      bool one = (tx[txIndex] >> txBit) & 1;
+      halPull(one ? TI_RING_PIN : TI_TIP_PIN, false);
+      state = STATE_TX_RELEASE;
+      break;
+    }
+
+    case STATE_TX_RELEASE: {
+      state = STATE_IDLE;
+      if (++txBit == 8) {
+        txBit = 0;
+        if (++txIndex == tx.size()) {
+          tx.clear();
+          txIndex = 0;
+          delayEnd = 0;
+          dropAt = NONE;
+        }
+      }
+      break;
+    }
+  }
+}
+
+/**
+ * receivedByte - Collects the adapter's bytes into packets. Data packets are
+ * answered with ACK (or ERR if the checksum is wrong).
+ */
+void Calculator::receivedByte(uint8_t byte) {
+  rx.push_back(byte);
+  if (rx.size() < HEADER_LENGTH) {
+    return;
+  }
+  //Only data packets have data; the sync answer carries a sequence number
+  //where the length would be
+  uint16_t length = rx[2] | rx[3] << 8;
+  if (rx[1] != CMD_DATA || length == 0) {
+    replies.push_back(rx);
+    rx.clear();
+    return;
+  }
+  if (rx.size() < (size_t)(HEADER_LENGTH + length + CHECKSUM_LENGTH)) {
+    return;
+  }
+
+  uint16_t sum = 0;
+  for (uint16_t i = 0; i < length; i++) {
+    sum += rx[HEADER_LENGTH + i];
+  }
+  uint16_t checksum = rx[HEADER_LENGTH + length] |
+      rx[HEADER_LENGTH + length + 1] << 8;
+  bool good = sum == checksum;
+  if (good) {
+    packets.push_back(Packet(rx.begin() + HEADER_LENGTH,
+        rx.begin() + HEADER_LENGTH + length));
+  }
+  rx.clear();
+
+  //Answer ahead of anything else waiting to be sent
+  Packet answer;
+  answer.push_back(CALC_MACHINE_ID);
+  answer.push_back(good ? CMD_ACK : CMD_ERR);
+  answer.push_back(0);
+  answer.push_back(0);
+  tx.insert(tx.begin() + txIndex, answer.begin(), answer.end());
+  if (delayEnd > txIndex) {
+    delayEnd += answer.size();
+  }
+  if (dropAt != NONE && dropAt >= txIndex) {
+    dropAt += answer.size();
+  }
+}
@@ -0,0 +1,117 @@
+/**
+ * DMX-84
+ * Simulated calculator header
+ *
+ * This file contains the external defines and class for a calculator on the
+ * simulated link lines of the host build. It speaks the TI bit handshake on
+ * tip and ring with a set reaction time, splits what it receives into packets
+ * and acknowledges the adapter's data packets itself. Faults can be put on
+ * the wire: slower steps, a lost edge and a line held low.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CALCULATOR_H
+#define CALCULATOR_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <inttypes.h>
+#include <deque>
+#include <vector>
+
+#include "hal.h"
+
+/******************************************************************************
+ * External constants
+ ******************************************************************************/
+
+#define CALC_MACHINE_ID       0x73 //TI-84
+
+//Default time to react to a change on the lines (nanoseconds)
+#define CALC_STEP_TIME        10000
+
+//Longest the calculator waits for the adapter during a bit (nanoseconds)
+#define CALC_TIMEOUT          50000000
+
+/******************************************************************************
+ * Class definition
+ ******************************************************************************/
+
+typedef std::vector<uint8_t> Packet;
+
+class Calculator: public HalDevice {
+    public:
+        Calculator(void);
+        uint64_t step(uint64_t now);
+
+        //Queues a packet (header, data and checksum) to send
+        void send(uint8_t command, const uint8_t *data = 0,
+            uint16_t length = 0, bool badChecksum = false);
+        void sendRaw(const Packet &bytes);
+        bool sending(void);
+
+        //Forgets everything it was sending and receiving
+        void abort(void);
+
+        //Faults on the wire
+        void delaySteps(uint64_t extra, uint16_t bytes);
+        void dropEdge(uint16_t byte);
+        void stick(uint8_t pin, uint64_t time);
+
+        //Headers without data from the adapter (ACK, ERR, SKIP/EXIT, CTS...)
+        std::deque<Packet> replies;
+
+        //Data packets from the adapter (acknowledged), without header and
+        //checksum
+        std::deque<Packet> packets;
+
+        //Set when a bit timed out and what was being sent was dropped
+        bool aborted;
+
+        uint64_t stepTime;
+
+    private:
+        bool ready(bool ring, bool tip);
+        void act(bool ring, bool tip);
+        void receivedByte(uint8_t byte);
+
+        uint8_t state;
+        uint64_t since; //When the current state was entered
+        uint64_t actAt; //When the action for the current state is due
+        bool seenRing; //The lines when the change acted on was seen
+        bool seenTip;
+
+        Packet tx;
+        size_t txIndex;
+        uint8_t txBit;
+        Packet rx;
+        uint8_t rxByte;
+        uint8_t rxBit;
+
+        uint64_t extraDelay;
+        size_t delayEnd; //tx index the extra delay stops at
+        size_t dropAt; //tx index whose first ack is lost (SIZE_MAX for none)
+        uint8_t stuckPin;
+        uint64_t stuckUntil;
+};
+
+#endif
@@ -0,0 +1,122 @@
+/**
+ * DMX-84
+ * Host Arduino core header
+ *
+ * This file stands in for the Arduino core when the firmware is built for
+ * the host (see src/host/README.md). It has only what the firmware uses.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+/******************************************************************************
+ * External constants
+ ******************************************************************************/
+
+#define HIGH                  1
+#define LOW                   0
+
+#define INPUT                 0
+#define OUTPUT                1
+#define INPUT_PULLUP          2
+
+#define DEC                   10
+#define HEX                   16
+
+/******************************************************************************
+ * Types
+ ******************************************************************************/
+
+typedef uint8_t byte;
+typedef uint16_t word;
+typedef bool boolean;
+
+//Strings in flash are ordinary strings on the host
+class __FlashStringHelper;
+#define F(string)             (reinterpret_cast<const __FlashStringHelper *>(string))
+
+/******************************************************************************
+ * Macros and templates
+ ******************************************************************************/
+
+/* The core's min() and max() are macros; these do the same without
+ * evaluating their arguments twice, and keep std::min and std::max usable.
+ */
+template <typename A, typename B>
+inline auto min(A a, B b) -> decltype(a + b) {
+  return a < b ? a : b;
+}
+
+template <typename A, typename B>
+inline auto max(A a, B b) -> decltype(a + b) {
+  return a > b ? a : b;
+}
+
+#define constrain(x, low, high) ((x) < (low) ? (low) : ((x) > (high) ? (high) : (x)))
+#define lowByte(w)            ((uint8_t)((w) & 0xFF))
+#define highByte(w)           ((uint8_t)((w) >> 8))
+#define interrupts()          sei()
+#define noInterrupts()        cli()
+
+//Arduino pin numbering on the 328P (see fastpin.h)
+#define digitalPinToPort(pin) ((pin) < 8 ? 4 : ((pin) < 14 ? 2 : 3))
+#define digitalPinToBitMask(pin) \
+    ((uint8_t)_BV((pin) < 8 ? (pin) : ((pin) < 14 ? (pin) - 8 : (pin) - 14)))
+#define portOutputRegister(port) \
+    ((port) == 2 ? &PORTB : ((port) == 3 ? &PORTC : &PORTD))
+
+/******************************************************************************
+ * External function prototypes
+ ******************************************************************************/
+
+//Time runs on the simulated clock (see hal.h), and wraps like the real ones
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+
+//The sketch
+void setup(void);
+void loop(void);
+
+#include "HardwareSerial.h"
+
+#endif
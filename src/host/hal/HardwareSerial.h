@@ -0,0 +1,91 @@
+/**
+ * DMX-84
+ * Host serial port header
+ *
+ * This file stands in for the Arduino HardwareSerial class when the firmware
+ * is built for the host. Received characters come in at the baud rate into a
+ * receive buffer the size of the real one, so a sender that doesn't wait
+ * overruns it the same way. Sent characters go out at once.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HardwareSerial_h
+#define HardwareSerial_h
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <inttypes.h>
+#include <stddef.h>
+
+/******************************************************************************
+ * External constants
+ ******************************************************************************/
+
+//As in the Arduino core for chips with 2 KB of RAM
+#define SERIAL_RX_BUFFER_SIZE 64
+#define SERIAL_TX_BUFFER_SIZE 64
+
+/******************************************************************************
+ * Class definition
+ ******************************************************************************/
+
+class __FlashStringHelper;
+
+class HardwareSerial {
+    public:
+        void begin(unsigned long baud);
+        void end(void);
+        int available(void);
+        int peek(void);
+        int read(void);
+        int availableForWrite(void);
+        void flush(void);
+        size_t write(uint8_t c);
+        size_t write(const uint8_t *data, size_t length);
+
+        size_t print(const __FlashStringHelper *s);
+        size_t print(const char *s);
+        size_t print(char c);
+        size_t print(unsigned char n, int base = DEC);
+        size_t print(int n, int base = DEC);
+        size_t print(unsigned int n, int base = DEC);
+        size_t print(long n, int base = DEC);
+        size_t print(unsigned long n, int base = DEC);
+        size_t print(double n, int digits = 2);
+
+        template <typename T> size_t println(T value) {
+          size_t n = print(value);
+          return n + println();
+        }
+        template <typename T> size_t println(T value, int format) {
+          size_t n = print(value, format);
+          return n + println();
+        }
+        size_t println(void);
+
+    private:
+        size_t printNumber(unsigned long n, int base);
+};
+
+extern HardwareSerial Serial;
+
+#endif
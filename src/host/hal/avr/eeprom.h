@@ -0,0 +1,45 @@
+/**
+ * DMX-84
+ * Host EEPROM header
+ *
+ * This file stands in for <avr/eeprom.h> when the firmware is built for the
+ * host. The EEPROM is an array in the HAL (see halEeprom()) that starts out
+ * erased, and each byte written takes as long on the simulated clock as it
+ * does on the chip.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HAL_AVR_EEPROM_H
+#define HAL_AVR_EEPROM_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#define EEMEM
+
+uint8_t eeprom_read_byte(const uint8_t *address);
+uint16_t eeprom_read_word(const uint16_t *address);
+void eeprom_read_block(void *dst, const void *src, size_t length);
+void eeprom_write_byte(uint8_t *address, uint8_t value);
+void eeprom_update_byte(uint8_t *address, uint8_t value);
+void eeprom_update_word(uint16_t *address, uint16_t value);
+void eeprom_update_block(const void *src, void *dst, size_t length);
+
+#endif
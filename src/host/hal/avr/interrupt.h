@@ -0,0 +1,74 @@
+/**
+ * DMX-84
+ * Host interrupt header
+ *
+ * This file stands in for <avr/interrupt.h> when the firmware is built for the
+ * host. The I bit of SREG is kept, and interrupts that come in while it is
+ * clear wait until it is set again, as on the chip. Each ISR() registers its
+ * handler with the HAL by name, so the HAL can call it.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HAL_AVR_INTERRUPT_H
+#define HAL_AVR_INTERRUPT_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <avr/io.h>
+
+/******************************************************************************
+ * Macros
+ ******************************************************************************/
+
+#define cli()                 halCli()
+#define sei()                 halSei()
+
+//ISR attributes: whether the handler runs with interrupts enabled
+#define ISR_BLOCK             | 0
+#define ISR_NOBLOCK           | 1
+
+#define ISR(vector, ...)      HAL_ISR(vector, __VA_ARGS__)
+#define HAL_ISR(vector, ...) \
+    extern "C" void vector(void); \
+    static HalVector vector##_hal(#vector, vector, (0 __VA_ARGS__)); \
+    extern "C" void vector(void)
+
+/******************************************************************************
+ * Types
+ ******************************************************************************/
+
+typedef void (*HalHandler)(void);
+
+//Registers an interrupt handler when the program starts
+class HalVector {
+    public:
+        HalVector(const char *name, HalHandler handler, bool noBlock);
+};
+
+/******************************************************************************
+ * External function prototypes
+ ******************************************************************************/
+
+void halCli(void);
+void halSei(void);
+
+#endif
@@ -0,0 +1,137 @@
+/**
+ * DMX-84
+ * Host AVR register header
+ *
+ * This file stands in for <avr/io.h> when the firmware is built for the host.
+ * The ATmega328P registers the firmware uses are plain variables, except for
+ * the ones reading has a side effect on (the pin inputs and the EEPROM data
+ * register), which go through the HAL. Only the bits the firmware names are
+ * defined.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HAL_AVR_IO_H
+#define HAL_AVR_IO_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <inttypes.h>
+
+/******************************************************************************
+ * External constants
+ ******************************************************************************/
+
+//The firmware and DmxSimple pick their register layout from this
+#define __AVR_ATmega328P__    1
+
+#ifndef F_CPU
+#define F_CPU                 16000000UL
+#endif
+
+#define RAMEND                0x8FF
+#define E2END                 0x3FF
+
+#define _BV(bit)              (1 << (bit))
+#define bit_is_set(reg, bit)  ((reg) & _BV(bit))
+#define bit_is_clear(reg, bit) (!((reg) & _BV(bit)))
+
+//TIMSK0, TIFR0, TIMSK2
+#define TOIE0                 0
+#define OCIE0A                1
+#define OCIE0B                2
+#define OCF0B                 2
+#define TOIE2                 0
+
+//TCCR2A, TCCR2B
+#define WGM20                 0
+#define CS22                  2
+
+//PCICR
+#define PCIE0                 0
+#define PCIE1                 1
+#define PCIE2                 2
+
+//UCSR0A, UCSR0B, UCSR0C
+#define U2X0                  1
+#define UDRE0                 5
+#define TXC0                  6
+#define UCSZ00                1
+#define UCSZ01                2
+#define USBS0                 3
+#define TXEN0                 3
+#define RXEN0                 4
+#define UDRIE0                5
+#define TXCIE0                6
+
+//ADMUX, ADCSRA
+#define MUX3                  3
+#define REFS0                 6
+#define REFS1                 7
+#define ADSC                  6
+
+//EECR
+#define EERE                  0
+#define EEPE                  1
+#define EEMPE                 2
+
+/******************************************************************************
+ * Registers
+ ******************************************************************************/
+
+extern volatile uint8_t SREG;
+
+extern volatile uint8_t PORTB, DDRB;
+extern volatile uint8_t PORTC, DDRC;
+extern volatile uint8_t PORTD, DDRD;
+
+//Reading a pin register samples the lines as they are now
+volatile uint8_t *halPins(volatile uint8_t *port);
+#define PINB                  (*halPins(&PORTB))
+#define PINC                  (*halPins(&PORTC))
+#define PIND                  (*halPins(&PORTD))
+
+extern volatile uint8_t TIMSK0, TIMSK1, TIMSK2;
+extern volatile uint8_t TCCR2A, TCCR2B;
+extern volatile uint8_t OCR0A, OCR0B, TIFR0;
+
+//The timer 0 counter runs off the simulated clock
+volatile uint8_t *halTcnt0(void);
+#define TCNT0                 (*halTcnt0())
+
+extern volatile uint8_t PCICR, PCIFR;
+extern volatile uint8_t PCMSK0, PCMSK1, PCMSK2;
+
+extern volatile uint8_t UCSR0A, UCSR0B, UCSR0C, UDR0;
+extern volatile uint16_t UBRR0;
+
+//A conversion started with ADSC has finished by the next access to ADCSRA
+extern volatile uint8_t ADMUX, ADCL, ADCH;
+volatile uint8_t *halAdcsra(void);
+#define ADCSRA                (*halAdcsra())
+
+//Setting EERE in EECR reads EEAR into EEDR
+extern volatile uint8_t EECR;
+extern volatile uint16_t EEAR;
+volatile uint8_t *halEedr(void);
+#define EEDR                  (*halEedr())
+
+#endif
@@ -0,0 +1,39 @@
+/**
+ * DMX-84
+ * Host program memory header
+ *
+ * This file stands in for <avr/pgmspace.h> when the firmware is built for the
+ * host, where constants in flash are ordinary constants.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HAL_AVR_PGMSPACE_H
+#define HAL_AVR_PGMSPACE_H
+
+#include <inttypes.h>
+
+#define PROGMEM
+#define PSTR(s)               (s)
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+#define pgm_read_dword(address) (*(const uint32_t *)(address))
+#define pgm_read_ptr(address) (*(void * const *)(address))
+
+#endif
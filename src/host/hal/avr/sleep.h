@@ -0,0 +1,39 @@
+/**
+ * DMX-84
+ * Host sleep header
+ *
+ * This file stands in for <avr/sleep.h> when the firmware is built for the
+ * host. Nothing sleeps.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HAL_AVR_SLEEP_H
+#define HAL_AVR_SLEEP_H
+
+#define SLEEP_MODE_IDLE       0
+#define SLEEP_MODE_PWR_DOWN   2
+
+#define set_sleep_mode(mode)  ((void)(mode))
+#define sleep_enable()
+#define sleep_disable()
+#define sleep_cpu()
+#define sleep_mode()
+
+#endif
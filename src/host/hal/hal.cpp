@@ -0,0 +1,735 @@
+/**
+ * DMX-84
+ * Host HAL code
+ *
+ * This file contains the stub Arduino core the firmware runs on when it is
+ * built for the host: a simulated clock with the timer and pin change
+ * interrupts the firmware uses, the pins and the devices wired to them, the
+ * serial port and the EEPROM.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include <avr/eeprom.h>
+#include <util/atomic.h>
+#include <util/delay_basic.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <deque>
+#include <vector>
+
+#include "hal.h"
+
+/******************************************************************************
+ * Internal constants
+ ******************************************************************************/
+
+#define SREG_I                0x80
+
+//Interrupt vectors the HAL can raise, highest priority first (as on the chip)
+#define VECTOR_PCINT0         0
+#define VECTOR_PCINT1         1
+#define VECTOR_PCINT2         2
+#define VECTOR_TIMER2_OVF     3
+#define VECTOR_TIMER0_COMPA   4
+#define VECTOR_TIMER0_COMPB   5
+#define VECTOR_USART_UDRE     6
+#define VECTOR_USART_TX       7
+#define VECTOR_COUNT          8
+
+//Ports, in the order of the pin tables
+#define PORT_B                0
+#define PORT_C                1
+#define PORT_D                2
+#define PORT_COUNT            3
+
+//How often a connected serial file descriptor is read (nanoseconds)
+#define SERIAL_POLL_PERIOD    1000000
+
+//Raw reading of the temperature sensor (about 27 degrees C, see readTemp())
+#define ADC_TEMPERATURE       352
+
+/******************************************************************************
+ * Internal types
+ ******************************************************************************/
+
+struct Vector {
+  const char *name;
+  HalHandler handler;
+  bool noBlock;
+};
+
+/******************************************************************************
+ * Registers
+ ******************************************************************************/
+
+volatile uint8_t SREG = SREG_I; //The core enables interrupts before setup()
+
+volatile uint8_t PORTB, DDRB, PORTC, DDRC, PORTD, DDRD;
+volatile uint8_t TIMSK0, TIMSK1, TIMSK2, TCCR2A, TCCR2B, OCR0A, OCR0B, TIFR0;
+volatile uint8_t PCICR, PCIFR, PCMSK0, PCMSK1, PCMSK2;
+volatile uint8_t UCSR0A, UCSR0B, UCSR0C, UDR0;
+volatile uint16_t UBRR0;
+volatile uint8_t ADMUX, ADCL, ADCH;
+volatile uint8_t EECR;
+volatile uint16_t EEAR;
+
+/******************************************************************************
+ * Internal global variables
+ ******************************************************************************/
+
+static Vector vectors[VECTOR_COUNT] = {
+  {"PCINT0_vect", NULL, false},
+  {"PCINT1_vect", NULL, false},
+  {"PCINT2_vect", NULL, false},
+  {"TIMER2_OVF_vect", NULL, false},
+  {"TIMER0_COMPA_vect", NULL, false},
+  {"TIMER0_COMPB_vect", NULL, false},
+  {"USART_UDRE_vect", NULL, false},
+  {"USART_TX_vect", NULL, false}
+};
+static uint8_t vectorFlags; //Raised and not yet run, one bit per vector
+
+static uint64_t now;
+static uint64_t nextTimer0 = HAL_TIMER0_PERIOD;
+static uint64_t timer0Count; //Timer 0 counts (not wrapped) at the last step
+static uint8_t tcnt0;
+static uint64_t nextTimer2 = HAL_TIMER2_PERIOD;
+
+//Pins, by port
+static volatile uint8_t *const ports[PORT_COUNT] = {&PORTB, &PORTC, &PORTD};
+static volatile uint8_t *const ddrs[PORT_COUNT] = {&DDRB, &DDRC, &DDRD};
+static volatile uint8_t *const pcmsks[PORT_COUNT] = {&PCMSK0, &PCMSK1, &PCMSK2};
+static volatile uint8_t pins[PORT_COUNT]; //Levels at the last sample
+static uint8_t pulls[PORT_COUNT]; //Pulled low from outside
+static std::vector<HalDevice *> devices;
+static uint64_t nextDevice;
+
+//Serial port
+static uint64_t charTime = 10000000000ULL / 9600;
+static std::deque<uint8_t> serialWire; //Sent to the firmware, not yet arrived
+static uint64_t nextChar;
+static uint8_t rxBuffer[SERIAL_RX_BUFFER_SIZE];
+static uint8_t rxHead, rxCount;
+static uint32_t rxOverruns;
+static std::vector<uint8_t> serialOutput;
+static int serialIn = -1, serialOut = -1;
+static uint64_t nextSerialPoll;
+
+static uint8_t adcsra;
+static uint8_t eedr;
+static uint8_t eeprom[E2END + 1];
+static bool eepromErased;
+
+HardwareSerial Serial;
+
+/******************************************************************************
+ * Internal function definitions
+ ******************************************************************************/
+
+/**
+ * portOf - Finds the pin table index and bit of an Arduino pin.
+ */
+static uint8_t portOf(uint8_t pin, uint8_t *mask) {
+  *mask = digitalPinToBitMask(pin);
+  return pin < 8 ? PORT_D : (pin < 14 ? PORT_B : PORT_C);
+}
+
+/**
+ * sample - Works out the level of every pin and raises the pin change
+ * interrupts of the ones that changed.
+ *
+ * A pin is low if the chip drives it low or something outside pulls it low.
+ * Inputs without a pullup read high (the link lines are pulled up by the
+ * calculator).
+ */
+static void sample(void) {
+  for (uint8_t i = 0; i < PORT_COUNT; i++) {
+    uint8_t level = ~(*ddrs[i] & ~*ports[i]) & ~pulls[i];
+    uint8_t changed = (level ^ pins[i]) & *pcmsks[i];
+    pins[i] = level;
+    if (changed) {
+      PCIFR |= _BV(i);
+      vectorFlags |= _BV(VECTOR_PCINT0 + i);
+    }
+  }
+}
+
+/**
+ * enabled - Checks whether a raised interrupt would be taken.
+ */
+static bool enabled(uint8_t vector) {
+  switch (vector) {
+    case VECTOR_PCINT0:
+    case VECTOR_PCINT1:
+    case VECTOR_PCINT2:
+      return PCICR & _BV(vector - VECTOR_PCINT0);
+    case VECTOR_TIMER2_OVF:
+      return TIMSK2 & _BV(TOIE2);
+    case VECTOR_TIMER0_COMPA:
+      return TIMSK0 & _BV(OCIE0A);
+    case VECTOR_TIMER0_COMPB:
+      return TIMSK0 & _BV(OCIE0B);
+    default:
+      return false; //The USART isn't simulated
+  }
+}
+
+/**
+ * dispatch - Runs the raised interrupts, highest priority first, for as long
+ * as interrupts are enabled.
+ */
+static void dispatch(void) {
+  while (SREG & SREG_I) {
+    uint8_t vector = 0;
+    while (vector < VECTOR_COUNT &&
+        !((vectorFlags & _BV(vector)) && enabled(vector))) {
+      vector++;
+    }
+    if (vector == VECTOR_COUNT) {
+      return;
+    }
+    vectorFlags &= ~_BV(vector);
+    if (vector <= VECTOR_PCINT2) {
+      PCIFR &= ~_BV(vector - VECTOR_PCINT0);
+    }
+    if (!vectors[vector].handler) {
+      continue;
+    }
+    uint8_t sreg = SREG;
+    if (!vectors[vector].noBlock) {
+      SREG &= ~SREG_I;
+    }
+    vectors[vector].handler();
+    SREG = sreg; //reti
+  }
+}
+
+/**
+ * serialEvents - Moves characters along the serial line.
+ */
+static void serialEvents(void) {
+  if (serialIn >= 0 && now >= nextSerialPoll) {
+    nextSerialPoll = now + SERIAL_POLL_PERIOD;
+    uint8_t data[256];
+    ssize_t length = read(serialIn, data, sizeof(data));
+    if (length > 0) {
+      halSerialInput(data, length);
+    }
+  }
+  while (!serialWire.empty() && now >= nextChar) {
+    if (rxCount < SERIAL_RX_BUFFER_SIZE) {
+      rxBuffer[(rxHead + rxCount++) % SERIAL_RX_BUFFER_SIZE] =
+          serialWire.front();
+    } else {
+      rxOverruns++; //Lost, as when the receive buffer is full on the chip
+    }
+    serialWire.pop_front();
+    nextChar += charTime;
+  }
+}
+
+/**
+ * eepromReady - Makes sure the EEPROM reads as erased before first use.
+ */
+static void eepromReady(void) {
+  if (!eepromErased) {
+    memset(eeprom, 0xFF, sizeof(eeprom));
+    eepromErased = true;
+  }
+}
+
+/**
+ * compareB - Finds the first timer 0 count after a given one at which the
+ * counter matches OCR0B.
+ */
+static uint64_t compareB(uint64_t count) {
+  return count + 1 + ((uint8_t)(OCR0B - (count + 1)));
+}
+
+/******************************************************************************
+ * HAL function definitions
+ ******************************************************************************/
+
+/**
+ * halNow - Reads the simulated clock.
+ *
+ * Returns:
+ *    uint64_t now: nanoseconds since power up
+ */
+uint64_t halNow(void) {
+  return now;
+}
+
+/**
+ * halAdvance - Moves the simulated clock forward, raising the timer
+ * interrupts that come due and stepping the devices on the way. Interrupts
+ * run as they come in while they are enabled.
+ *
+ * Parameter:
+ *    uint64_t ns: how far to move it (0 just runs what is waiting)
+ */
+void halAdvance(uint64_t ns) {
+  uint64_t target = now + ns;
+  do {
+    uint64_t next = min(target, now + HAL_MAX_STEP);
+    next = min(next, min(nextTimer0, nextTimer2));
+    if (TIMSK0 & _BV(OCIE0B)) {
+      next = min(next, compareB(now / HAL_TIMER0_COUNT) * HAL_TIMER0_COUNT);
+    }
+    if (nextDevice && nextDevice > now) {
+      next = min(next, nextDevice);
+    }
+    if (!serialWire.empty()) {
+      next = min(next, max(nextChar, now));
+    }
+    if (next > now) {
+      now = next;
+    }
+
+    while (now >= nextTimer0) {
+      vectorFlags |= _BV(VECTOR_TIMER0_COMPA);
+      nextTimer0 += HAL_TIMER0_PERIOD;
+    }
+    //Compare B is only raised while enabled (the firmware clears its flag
+    //before enabling it anyway)
+    uint64_t count = now / HAL_TIMER0_COUNT;
+    if ((TIMSK0 & _BV(OCIE0B)) && compareB(timer0Count) <= count) {
+      vectorFlags |= _BV(VECTOR_TIMER0_COMPB);
+    }
+    timer0Count = count;
+    while (now >= nextTimer2) {
+      vectorFlags |= _BV(VECTOR_TIMER2_OVF);
+      nextTimer2 += HAL_TIMER2_PERIOD;
+    }
+    serialEvents();
+    nextDevice = 0;
+    for (size_t i = 0; i < devices.size(); i++) {
+      uint64_t wake = devices[i]->step(now);
+      if (wake && (!nextDevice || wake < nextDevice)) {
+        nextDevice = wake;
+      }
+    }
+    sample();
+    dispatch();
+  } while (now < target);
+}
+
+/**
+ * halAttach - Wires a device to the pins.
+ */
+void halAttach(HalDevice *device) {
+  devices.push_back(device);
+  halAdvance(0);
+}
+
+/**
+ * halDetach - Takes a device off the pins. It should release its pulls first.
+ */
+void halDetach(HalDevice *device) {
+  for (size_t i = 0; i < devices.size(); i++) {
+    if (devices[i] == device) {
+      devices.erase(devices.begin() + i);
+      break;
+    }
+  }
+}
+
+/**
+ * halPull - Pulls a pin low from outside the chip, or lets it go.
+ *
+ * Parameters:
+ *    uint8_t pin: the Arduino pin number
+ *    bool low: true to pull it low
+ */
+void halPull(uint8_t pin, bool low) {
+  uint8_t mask;
+  uint8_t port = portOf(pin, &mask);
+  if (low) {
+    pulls[port] |= mask;
+  } else {
+    pulls[port] &= ~mask;
+  }
+}
+
+/**
+ * halLevel - Reads the level of a pin on the wire.
+ *
+ * Parameter:
+ *    uint8_t pin: the Arduino pin number
+ * Returns:
+ *    bool high: true if nothing pulls it low
+ */
+bool halLevel(uint8_t pin) {
+  uint8_t mask;
+  uint8_t port = portOf(pin, &mask);
+  return ~(*ddrs[port] & ~*ports[port]) & ~pulls[port] & mask;
+}
+
+/**
+ * halSerialInput - Sends characters to the firmware's serial port. They
+ * arrive one character time apart.
+ */
+void halSerialInput(const uint8_t *data, size_t length) {
+  if (serialWire.empty() && nextChar < now + charTime) {
+    nextChar = now + charTime;
+  }
+  serialWire.insert(serialWire.end(), data, data + length);
+}
+
+/**
+ * halSerialPending - Counts the characters sent to the firmware that it
+ * hasn't read yet, on the line or in the receive buffer.
+ */
+size_t halSerialPending(void) {
+  return serialWire.size() + rxCount;
+}
+
+/**
+ * halSerialConnect - Connects the serial port to file descriptors (such as a
+ * pty), as well as to halSerialInput() and halSerialOutput().
+ *
+ * Parameters:
+ *    int in: read for characters to the firmware (non-blocking), or -1
+ *    int out: what the firmware prints is written here, or -1
+ */
+void halSerialConnect(int in, int out) {
+  serialIn = in;
+  serialOut = out;
+}
+
+/**
+ * halSerialOutput - Gets everything the firmware has printed since the last
+ * halSerialClearOutput().
+ */
+const uint8_t *halSerialOutput(size_t *length) {
+  *length = serialOutput.size();
+  return serialOutput.data();
+}
+
+void halSerialClearOutput(void) {
+  serialOutput.clear();
+}
+
+/**
+ * halSerialOverruns - Counts the characters lost because the receive buffer
+ * was full.
+ */
+uint32_t halSerialOverruns(void) {
+  return rxOverruns;
+}
+
+/**
+ * halEeprom - Gets the EEPROM contents, to look at or change directly.
+ */
+uint8_t *halEeprom(void) {
+  eepromReady();
+  return eeprom;
+}
+
+/**
+ * halPins - Samples the pins of a port for its PINx register.
+ */
+volatile uint8_t *halPins(volatile uint8_t *port) {
+  halAdvance(HAL_PIN_READ_COST);
+  uint8_t i = port == &PORTB ? PORT_B : (port == &PORTC ? PORT_C : PORT_D);
+  return &pins[i];
+}
+
+/**
+ * halTcnt0 - Gets TCNT0, the timer 0 counter.
+ */
+volatile uint8_t *halTcnt0(void) {
+  tcnt0 = now / HAL_TIMER0_COUNT;
+  return (volatile uint8_t *)&tcnt0;
+}
+
+/**
+ * halEedr - Gets EEDR, finishing a read started by setting EERE.
+ */
+volatile uint8_t *halEedr(void) {
+  if (EECR & _BV(EERE)) {
+    EECR &= ~_BV(EERE);
+    eedr = halEeprom()[EEAR & E2END];
+  }
+  return (volatile uint8_t *)&eedr;
+}
+
+/**
+ * halAdcsra - Gets ADCSRA, finishing a conversion started by setting ADSC.
+ */
+volatile uint8_t *halAdcsra(void) {
+  if (adcsra & _BV(ADSC)) {
+    adcsra &= ~_BV(ADSC);
+    ADCL = ADC_TEMPERATURE & 0xFF;
+    ADCH = ADC_TEMPERATURE >> 8;
+  }
+  return (volatile uint8_t *)&adcsra;
+}
+
+/**
+ * halDelayCycles - Busy-waits a number of CPU cycles.
+ */
+void halDelayCycles(uint32_t cycles) {
+  halAdvance((uint64_t)cycles * 1000000000ULL / F_CPU);
+}
+
+HalVector::HalVector(const char *name, HalHandler handler, bool noBlock) {
+  for (uint8_t i = 0; i < VECTOR_COUNT; i++) {
+    if (!strcmp(vectors[i].name, name)) {
+      vectors[i].handler = handler;
+      vectors[i].noBlock = noBlock;
+    }
+  }
+}
+
+void halCli(void) {
+  SREG &= ~SREG_I;
+}
+
+void halSei(void) {
+  SREG |= SREG_I;
+  dispatch();
+}
+
+void halRestoreState(const uint8_t *sreg) {
+  SREG = *sreg;
+  dispatch();
+}
+
+/******************************************************************************
+ * Arduino core function definitions
+ ******************************************************************************/
+
+uint32_t millis(void) {
+  halAdvance(HAL_CLOCK_READ_COST);
+  return now / 1000000;
+}
+
+uint32_t micros(void) {
+  halAdvance(HAL_CLOCK_READ_COST);
+  return now / 1000;
+}
+
+void delay(uint32_t ms) {
+  halAdvance((uint64_t)ms * 1000000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  halAdvance((uint64_t)us * 1000);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  uint8_t mask;
+  uint8_t port = portOf(pin, &mask);
+  if (mode == OUTPUT) {
+    *ddrs[port] |= mask;
+  } else {
+    *ddrs[port] &= ~mask;
+    if (mode == INPUT_PULLUP) {
+      *ports[port] |= mask;
+    } else {
+      *ports[port] &= ~mask;
+    }
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  uint8_t mask;
+  uint8_t port = portOf(pin, &mask);
+  if (value) {
+    *ports[port] |= mask;
+  } else {
+    *ports[port] &= ~mask;
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  uint8_t mask;
+  uint8_t port = portOf(pin, &mask);
+  halPins(ports[port]);
+  return pins[port] & mask ? HIGH : LOW;
+}
+
+long random(long howBig) {
+  return howBig > 0 ? rand() % howBig : 0;
+}
+
+long random(long howSmall, long howBig) {
+  return howBig > howSmall ? howSmall + random(howBig - howSmall) : howSmall;
+}
+
+void randomSeed(unsigned long seed) {
+  srand(seed);
+}
+
+/******************************************************************************
+ * EEPROM function definitions
+ ******************************************************************************/
+
+uint8_t eeprom_read_byte(const uint8_t *address) {
+  return halEeprom()[(uintptr_t)address & E2END];
+}
+
+uint16_t eeprom_read_word(const uint16_t *address) {
+  uintptr_t a = (uintptr_t)address;
+  return eeprom_read_byte((const uint8_t *)a) |
+      eeprom_read_byte((const uint8_t *)(a + 1)) << 8;
+}
+
+void eeprom_read_block(void *dst, const void *src, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    ((uint8_t *)dst)[i] = eeprom_read_byte((const uint8_t *)src + i);
+  }
+}
+
+void eeprom_write_byte(uint8_t *address, uint8_t value) {
+  halEeprom()[(uintptr_t)address & E2END] = value;
+  EECR |= _BV(EEPE); //Busy while the byte is written
+  halAdvance(HAL_EEPROM_WRITE_TIME);
+  EECR &= ~_BV(EEPE);
+}
+
+void eeprom_update_byte(uint8_t *address, uint8_t value) {
+  if (eeprom_read_byte(address) != value) {
+    eeprom_write_byte(address, value);
+  }
+}
+
+void eeprom_update_word(uint16_t *address, uint16_t value) {
+  uintptr_t a = (uintptr_t)address;
+  eeprom_update_byte((uint8_t *)a, value & 0xFF);
+  eeprom_update_byte((uint8_t *)(a + 1), value >> 8);
+}
+
+void eeprom_update_block(const void *src, void *dst, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    eeprom_update_byte((uint8_t *)dst + i, ((const uint8_t *)src)[i]);
+  }
+}
+
+/******************************************************************************
+ * Serial port function definitions
+ ******************************************************************************/
+
+void HardwareSerial::begin(unsigned long baud) {
+  charTime = 10000000000ULL / baud; //Start bit, 8 data bits, stop bit
+}
+
+void HardwareSerial::end(void) {
+}
+
+int HardwareSerial::available(void) {
+  return rxCount;
+}
+
+int HardwareSerial::peek(void) {
+  return rxCount ? rxBuffer[rxHead] : -1;
+}
+
+int HardwareSerial::read(void) {
+  if (!rxCount) {
+    return -1;
+  }
+  uint8_t c = rxBuffer[rxHead];
+  rxHead = (rxHead + 1) % SERIAL_RX_BUFFER_SIZE;
+  rxCount--;
+  return c;
+}
+
+int HardwareSerial::availableForWrite(void) {
+  return SERIAL_TX_BUFFER_SIZE - 1; //Sent characters go out at once
+}
+
+void HardwareSerial::flush(void) {
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *data, size_t length) {
+  serialOutput.insert(serialOutput.end(), data, data + length);
+  if (serialOut >= 0 && ::write(serialOut, data, length) < 0) {
+    serialOut = -1; //The other end went away
+  }
+  return length;
+}
+
+size_t HardwareSerial::print(const __FlashStringHelper *s) {
+  return print(reinterpret_cast<const char *>(s));
+}
+
+size_t HardwareSerial::print(const char *s) {
+  return write((const uint8_t *)s, strlen(s));
+}
+
+size_t HardwareSerial::print(char c) {
+  return write(c);
+}
+
+size_t HardwareSerial::print(unsigned char n, int base) {
+  return printNumber(n, base);
+}
+
+size_t HardwareSerial::print(int n, int base) {
+  return print((long)n, base);
+}
+
+size_t HardwareSerial::print(unsigned int n, int base) {
+  return printNumber(n, base);
+}
+
+size_t HardwareSerial::print(long n, int base) {
+  if (n < 0 && base == DEC) {
+    return print('-') + printNumber(-(unsigned long)n, base);
+  }
+  return printNumber(n, base);
+}
+
+size_t HardwareSerial::print(unsigned long n, int base) {
+  return printNumber(n, base);
+}
+
+size_t HardwareSerial::print(double n, int digits) {
+  char text[32];
+  snprintf(text, sizeof(text), "%.*f", digits, n);
+  return print(text);
+}
+
+size_t HardwareSerial::println(void) {
+  return print("\r\n");
+}
+
+size_t HardwareSerial::printNumber(unsigned long n, int base) {
+  char text[8 * sizeof(n) + 1];
+  char *p = text + sizeof(text) - 1;
+  *p = '\0';
+  do {
+    uint8_t digit = n % base;
+    *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    n /= base;
+  } while (n);
+  return print(p);
+}
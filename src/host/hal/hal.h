@@ -0,0 +1,107 @@
+/**
+ * DMX-84
+ * Host HAL header
+ *
+ * This file contains the external defines and prototypes for driving the
+ * stub Arduino core from host programs: the simulated clock, the timer and
+ * pin change interrupts, devices wired to the pins, the serial port and the
+ * EEPROM.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HAL_H
+#define HAL_H
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <inttypes.h>
+#include <stddef.h>
+
+/******************************************************************************
+ * External constants
+ ******************************************************************************/
+
+/* The host runs the firmware's code as fast as it can, so the simulated clock
+ * only moves when the firmware waits or reads it: delays, EEPROM writes, and
+ * these costs for each read of the clock or a pin register (nanoseconds,
+ * about what they take on the chip). Loops that poll with micros() therefore
+ * still see time pass.
+ */
+#define HAL_CLOCK_READ_COST   4000
+#define HAL_PIN_READ_COST     250
+
+//Timer interrupt periods with the Arduino core's timer setup (nanoseconds)
+#define HAL_TIMER0_COUNT      4000    //64 prescaler
+#define HAL_TIMER0_PERIOD     1024000 //256 counts
+#define HAL_TIMER2_PERIOD     2040000 //64 prescaler, 510 counts (phase correct)
+
+//Time to write one EEPROM byte (nanoseconds)
+#define HAL_EEPROM_WRITE_TIME 3400000
+
+//Longest the clock can go without a device being stepped (nanoseconds)
+#define HAL_MAX_STEP          1000000
+
+/******************************************************************************
+ * Class definition
+ ******************************************************************************/
+
+/* Something outside the chip that runs on the simulated clock, like the
+ * calculator on the link. It pulls pins low through halPull() (the lines are
+ * open collector) and reads them with halLevel().
+ */
+class HalDevice {
+    public:
+        virtual ~HalDevice() {}
+
+        /* Called every time the clock moves or the chip samples a pin.
+         * Returns the next time (nanoseconds) it has something to do even if
+         * nothing changes on the pins, or 0 for none.
+         */
+        virtual uint64_t step(uint64_t now) = 0;
+};
+
+/******************************************************************************
+ * External function prototypes
+ ******************************************************************************/
+
+//Simulated clock (nanoseconds since power up)
+uint64_t halNow(void);
+void halAdvance(uint64_t ns);
+
+//Devices on the pins
+void halAttach(HalDevice *device);
+void halDetach(HalDevice *device);
+void halPull(uint8_t pin, bool low);
+bool halLevel(uint8_t pin);
+
+//Serial port: characters sent to the firmware, and what it has printed
+void halSerialInput(const uint8_t *data, size_t length);
+size_t halSerialPending(void);
+void halSerialConnect(int in, int out);
+const uint8_t *halSerialOutput(size_t *length);
+void halSerialClearOutput(void);
+uint32_t halSerialOverruns(void);
+
+//EEPROM contents (E2END + 1 bytes)
+uint8_t *halEeprom(void);
+
+#endif
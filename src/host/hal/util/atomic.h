@@ -0,0 +1,50 @@
+/**
+ * DMX-84
+ * Host atomic block header
+ *
+ * This file stands in for <util/atomic.h> when the firmware is built for the
+ * host. It works the same way as avr-libc's: interrupts are disabled for the
+ * block and SREG is put back however the block is left.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HAL_UTIL_ATOMIC_H
+#define HAL_UTIL_ATOMIC_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+void halRestoreState(const uint8_t *sreg);
+
+//Inline, like avr-libc's, so the compiler sees every block runs once
+static __inline__ uint8_t halCliOnce(void) {
+  cli();
+  return 1;
+}
+
+#define ATOMIC_RESTORESTATE \
+    uint8_t halSregSave __attribute__((__cleanup__(halRestoreState))) = SREG
+#define ATOMIC_FORCEON \
+    uint8_t halSregSave __attribute__((__cleanup__(halRestoreState))) = 0x80
+
+#define ATOMIC_BLOCK(type) \
+    for (type, halAtomicToDo = halCliOnce(); halAtomicToDo; halAtomicToDo = 0)
+
+#endif
@@ -0,0 +1,35 @@
+/**
+ * DMX-84
+ * Host delay header
+ *
+ * This file stands in for <util/delay.h> when the firmware is built for the
+ * host. Delays move the simulated clock.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HAL_UTIL_DELAY_H
+#define HAL_UTIL_DELAY_H
+
+#include <util/delay_basic.h>
+
+#define _delay_us(us)         halDelayCycles((uint32_t)((us) * (F_CPU / 1000000)))
+#define _delay_ms(ms)         halDelayCycles((uint32_t)((ms) * (F_CPU / 1000)))
+
+#endif
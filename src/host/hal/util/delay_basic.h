@@ -0,0 +1,40 @@
+/**
+ * DMX-84
+ * Host delay loop header
+ *
+ * This file stands in for <util/delay_basic.h> when the firmware is built for
+ * the host. The loops take as many cycles as on the chip, on the simulated
+ * clock.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HAL_UTIL_DELAY_BASIC_H
+#define HAL_UTIL_DELAY_BASIC_H
+
+#include <avr/io.h>
+
+void halDelayCycles(uint32_t cycles);
+
+//3 cycles per loop; 0 means 256 loops
+#define _delay_loop_1(count)  halDelayCycles(3 * ((uint8_t)(count) ? (uint8_t)(count) : 256))
+//4 cycles per loop; 0 means 65536 loops
+#define _delay_loop_2(count)  halDelayCycles(4 * ((uint16_t)(count) ? (uint32_t)(uint16_t)(count) : 65536))
+
+#endif
@@ -0,0 +1,574 @@
+/**
+ * DMX-84
+ * Host firmware tests
+ *
+ * Runs the firmware built for the host (see hal.h) and checks what it does
+ * with commands, the status and error flags and the LED, without a chip.
+ * Each check prints what failed; the exit status is the number of failures.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include <avr/eeprom.h>
+#include <DmxSimple.h>
+#include <stdio.h>
+
+#include "firmware.h"
+#include "link.h"
+#include "status.h"
+#include "LED.h"
+#include "cue.h"
+#include "master.h"
+#include "effects.h"
+#include "fade.h"
+#include "scene.h"
+#include "hal.h"
+
+/******************************************************************************
+ * Internal constants
+ ******************************************************************************/
+
+#define REPLY_LENGTH          16
+
+//Long enough for a commit to reach dmxOutput at the default frame length
+#define COMMIT_WAIT           50000000ULL //50 ms
+
+//LED samples, taken halfway through each blink step
+#define LED_SAMPLES           30
+
+//How often loop() runs in runLoop() (nanoseconds)
+#define LOOP_PERIOD           100000
+
+//The bit-banged transmitter's budget per TIMER2 tick, in DMX bit periods
+#define TICK_BUDGET           127
+#define SLOT_BITS             11
+
+//Bit periods (4us each) the slow slot filter in testSlotBudget() takes
+#define SLOW_FILTER_BITS      2
+
+//TIMER2 ticks testSlotBudget() counts slots over
+#define BUDGET_TICKS          10
+
+/******************************************************************************
+ * Internal variables
+ ******************************************************************************/
+
+static int failures;
+
+//The replies of the last run(), each after its length (as in a batch reply)
+static uint8_t reply[REPLY_LENGTH];
+static uint16_t replyLength;
+
+//Slots the test slot filter has seen, and how long it takes on each
+static uint32_t filterCalls;
+static uint8_t filterBits;
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+static void check(bool passed, const char *what, int line) {
+  if (!passed) {
+    printf("test.cpp:%d: failed: %s\n", line, what);
+    failures++;
+  }
+}
+
+/**
+ * run - Runs one command packet the way loop() does, gathering its replies.
+ */
+static void run(const uint8_t *packet, uint16_t length) {
+  uint8_t copy[1 + DMX_SIZE];
+  memcpy(copy, packet, length);
+  Link.packetData = copy;
+  Link.packetLength = length;
+  Link.collect(reply, REPLY_LENGTH);
+  DmxSimple.beginWrite();
+  processCommand(copy[0]);
+  DmxSimple.endWrite();
+  replyLength = Link.collected();
+}
+
+/**
+ * runLoop - Runs the main loop for a while, as the Arduino core would.
+ */
+static void runLoop(uint64_t ns) {
+  uint64_t end = halNow() + ns;
+  while (halNow() < end) {
+    loop();
+    halAdvance(LOOP_PERIOD);
+  }
+}
+
+/**
+ * serialLine - Sends a hex command line to the serial port.
+ */
+static void serialLine(const char *line) {
+  halSerialInput((const uint8_t *)line, strlen(line));
+}
+
+/**
+ * countLED - Watches the LED for LED_SAMPLES blink steps and counts how many
+ * it was lit for.
+ */
+static int countLED(void) {
+  halAdvance(MILLISECONDS_PER_BLINK * 1000000ULL / 2);
+  int lit = 0;
+  for (int i = 0; i < LED_SAMPLES; i++) {
+    lit += halLevel(LED_PIN);
+    halAdvance(MILLISECONDS_PER_BLINK * 1000000ULL);
+  }
+  return lit;
+}
+
+static void testChannels(void) {
+  const uint8_t set[] = {0x10, 0x05, 0x80};
+  run(set, sizeof(set));
+  CHECK(dmxBuffer[5] == 0x80);
+  CHECK(dmxOutput[5] != 0x80); //Not committed yet
+
+  DmxSimple.commit();
+  halAdvance(COMMIT_WAIT);
+  CHECK(!DmxSimple.committing());
+  CHECK(dmxOutput[5] == 0x80);
+
+  const uint8_t setHigh[] = {0x11, 0x05, 0x40};
+  run(setHigh, sizeof(setHigh));
+  CHECK(dmxBuffer[0x105] == 0x40);
+  CHECK(dmxBuffer[5] == 0x80);
+
+  const uint8_t read[] = {0x40, 0x05};
+  run(read, sizeof(read));
+  CHECK(replyLength == 3 && reply[1] == 0x40 && reply[2] == 0x80);
+
+  const uint8_t increment[] = {0x16, 0x05, 0x10};
+  run(increment, sizeof(increment));
+  CHECK(dmxBuffer[5] == 0x90);
+
+  //Scatter: channels 5 and 300, then a second group for channel 511
+  const uint8_t scatter[] = {0x2C, 0x02, 0x05, 0x10, 0x2C, 0x20, 0x06, 0x30,
+      0x07, 0x40, 0x08, 0x50, 0x09, 0x60, 0x0A, 0x70, 0x0B, 0x80, 0x02, 0x0C,
+      0x90, 0xFF, 0xA0};
+  run(scatter, sizeof(scatter));
+  CHECK(dmxBuffer[5] == 0x10 && dmxBuffer[300] == 0x20);
+  CHECK(dmxBuffer[6] == 0x30 && dmxBuffer[12] == 0x90);
+  CHECK(dmxBuffer[511] == 0xA0 && dmxBuffer[0xFF] != 0xA0);
+
+  const uint8_t setAll[] = {0x26, 0x00};
+  run(setAll, sizeof(setAll));
+  CHECK(dmxBuffer[5] == 0 && dmxBuffer[0x105] == 0 && dmxBuffer[511] == 0);
+}
+
+static void testClock(void) {
+  const uint8_t read[] = {0x04};
+  uint32_t before = millis();
+  run(read, sizeof(read));
+  uint32_t now = reply[2] | (uint32_t)reply[3] << 8 |
+      (uint32_t)reply[4] << 16 | (uint32_t)reply[5] << 24;
+  CHECK(replyLength >= 10 && reply[1] == 0x04);
+  CHECK(now >= before && now <= millis());
+  CHECK(DmxSimple.frames() > 0);
+}
+
+static void testErrors(void) {
+  Error.reset();
+  CHECK(!Status.test(ERROR_STATUS));
+
+  const uint8_t unknown[] = {0xA5};
+  run(unknown, sizeof(unknown));
+  CHECK(Error.test(UNKNOWN_COMMAND_ERROR));
+  CHECK(Status.test(ERROR_STATUS));
+
+  Error.clear(UNKNOWN_COMMAND_ERROR);
+  CHECK(!Error.get());
+  CHECK(!Status.test(ERROR_STATUS));
+
+  Status.set(DEBUG_STATUS);
+  CHECK(Status.test(DEBUG_STATUS));
+  Status.toggle(DEBUG_STATUS);
+  CHECK(!Status.test(DEBUG_STATUS));
+}
+
+static void testSerial(void) {
+  serialLine("10 08 55\n");
+  runLoop(50000000ULL);
+  CHECK(dmxBuffer[8] == 0x55);
+
+  //A line cut short is dropped, not joined to the next one
+  serialLine("10 08");
+  runLoop(200000000ULL);
+  serialLine("10 09 66\n");
+  runLoop(50000000ULL);
+  CHECK(dmxBuffer[9] == 0x66);
+  CHECK(dmxBuffer[8] == 0x55);
+  CHECK(!halSerialPending());
+
+  //Channel data cut short is taken back out of the universe
+  serialLine("10 00 44\n");
+  runLoop(50000000ULL);
+  DmxSimple.commit();
+  runLoop(COMMIT_WAIT);
+  serialLine("20 99 98");
+  runLoop(200000000ULL);
+  CHECK(dmxBuffer[0] == 0x44 && dmxOutput[0] == 0x44);
+  CHECK(dmxBuffer[1] == dmxOutput[1]);
+
+  //Straight after a change, the line waits for its commit to go out, so
+  //taking the line back out doesn't take the change with it
+  serialLine("10 01 45\n20 99 98");
+  runLoop(200000000ULL);
+  CHECK(dmxBuffer[0] == 0x44 && dmxBuffer[1] == 0x45);
+  CHECK(dmxOutput[1] == 0x45);
+
+  //Changes not yet committed aren't streamed over, so a bad line can't lose
+  //them either
+  serialLine("29 00\n10 01 46\n20 99 98");
+  runLoop(200000000ULL);
+  CHECK(dmxBuffer[0] == 0x44 && dmxBuffer[1] == 0x46);
+  CHECK(dmxOutput[1] == 0x45);
+  serialLine("20 99 98 97\n");
+  runLoop(50000000ULL);
+  CHECK(dmxBuffer[0] == 0x99 && dmxBuffer[2] == 0x97);
+  serialLine("28\n29 01\n");
+  runLoop(COMMIT_WAIT);
+  CHECK(dmxOutput[0] == 0x99 && dmxOutput[2] == 0x97);
+}
+
+static void testCues(void) {
+  //A cue that comes due while a serial line is being streamed into the
+  //universe waits for the line, rather than taking the sink over
+  serialLine("20 01 02");
+  runLoop(10000000ULL);
+  uint32_t now = millis();
+  const uint8_t cue[] = {0x03, 0x00, (uint8_t)now, (uint8_t)(now >> 8),
+      (uint8_t)(now >> 16), (uint8_t)(now >> 24), 0x22, 0x20, 0x01, 0x77};
+  run(cue, sizeof(cue));
+  runLoop(20000000ULL);
+  CHECK(dmxBuffer[0x20] != 0x77);
+  serialLine(" 03\n");
+  runLoop(50000000ULL);
+  CHECK(dmxBuffer[0] == 0x01 && dmxBuffer[1] == 0x02 && dmxBuffer[2] == 0x03);
+  CHECK(dmxBuffer[0x20] == 0x77);
+  CHECK(!Cue.waiting());
+}
+
+static void testGroups(void) {
+  const uint8_t out[] = {0x94, 0x00}; //Submaster 0 at 0
+  run(out, sizeof(out));
+  const uint8_t add[] = {0x91, 0x00, 10, 0, 11, 0, 1}; //Channels 10-20
+  run(add, sizeof(add));
+  const uint8_t touching[] = {0x91, 0x00, 21, 0, 10, 0, 1}; //21-30
+  run(touching, sizeof(touching));
+  const uint8_t split[] = {0x91, 0x00, 12, 0, 3, 0, 0}; //Take out 12-14
+  run(split, sizeof(split));
+  CHECK(!Error.test(INVALID_VALUE_ERROR));
+  CHECK(Master.apply(9, 200) == 200 && Master.apply(10, 200) == 0);
+  CHECK(Master.apply(11, 200) == 0 && Master.apply(12, 200) == 200);
+  CHECK(Master.apply(14, 200) == 200 && Master.apply(15, 200) == 0);
+  CHECK(Master.apply(30, 200) == 0 && Master.apply(31, 200) == 200);
+  CHECK(Master.apply(13, 200) == 200 && Master.apply(25, 200) == 0);
+
+  //A bitmap replaces the channels it covers: the red channel of each RGB
+  //fixture in channels 0-23, so below 24 only the reds stay in the group
+  const uint8_t reds[] = {0x90, 0x00, 0x00, 0x49, 0x92, 0x24};
+  run(reds, sizeof(reds));
+  CHECK(!Error.test(INVALID_VALUE_ERROR));
+  CHECK(Master.apply(0, 200) == 0 && Master.apply(1, 200) == 200);
+  CHECK(Master.apply(2, 200) == 200 && Master.apply(3, 200) == 0);
+  CHECK(Master.apply(21, 200) == 0 && Master.apply(22, 200) == 200);
+  CHECK(Master.apply(11, 200) == 200 && Master.apply(25, 200) == 0);
+
+  //A bitmap running past the end of the group is cut off there
+  const uint8_t past[] = {0x90, 0x00, 0x3F, 0x80, 0xFF};
+  run(past, sizeof(past));
+  CHECK(!Error.test(INVALID_VALUE_ERROR));
+  CHECK(Master.apply(511, 200) == 0 && Master.apply(510, 200) == 200);
+  const uint8_t badGroup[] = {0x90, 0x04, 0x00, 0xFF};
+  run(badGroup, sizeof(badGroup));
+  CHECK(Error.test(INVALID_VALUE_ERROR));
+  Error.reset();
+
+  const uint8_t clear[] = {0x91, 0x00, 0, 0, 0, 2, 0};
+  run(clear, sizeof(clear));
+  const uint8_t full[] = {0x94, 0xFF};
+  run(full, sizeof(full));
+  CHECK(Master.apply(5, 200) == 200);
+}
+
+static void testEffects(void) {
+  const uint8_t set[] = {0x10, 40, 0x20};
+  run(set, sizeof(set));
+  DmxSimple.commit();
+  halAdvance(COMMIT_WAIT);
+  const uint8_t uncommitted[] = {0x10, 40, 0x90};
+  run(uncommitted, sizeof(uncommitted));
+
+  //Square wave held on (rate 0) at half depth on channels 40-41
+  const uint8_t start[] = {0x70, 0x00, EFFECT_SQUARE, 40, 0, 2, 0, 0, 0,
+      0, 0, 0x7F, 0xFF};
+  run(start, sizeof(start));
+  CHECK(!Error.test(INVALID_VALUE_ERROR));
+  CHECK(Effects.apply(40, dmxOutput[40]) == 0x20); //Waits for a frame
+  halAdvance(COMMIT_WAIT);
+  CHECK(dmxOutput[40] == 0x20); //Built on the committed level...
+  CHECK(Effects.apply(40, dmxOutput[40]) == 0x20 + 0x7F);
+  CHECK(Effects.apply(41, dmxOutput[41]) == 0x7F);
+  CHECK(Effects.apply(42, dmxOutput[42]) == 0);
+  CHECK(Effects.top() == 42); //...and kept in frames by auto-trim
+
+  //Moving it waits for a frame too
+  const uint8_t move[] = {0x70, 0x00, EFFECT_SQUARE, 41, 0, 2, 0, 0, 0,
+      0, 0, 0x7F, 0xFF};
+  run(move, sizeof(move));
+  CHECK(Effects.apply(40, 0x20) == 0x20 + 0x7F);
+  halAdvance(COMMIT_WAIT);
+  CHECK(Effects.apply(40, 0x20) == 0x20 && Effects.apply(42, 0) == 0x7F);
+
+  const uint8_t stop[] = {0x71};
+  run(stop, sizeof(stop));
+  CHECK(Effects.apply(42, 0) == 0x7F);
+  halAdvance(COMMIT_WAIT);
+  CHECK(Effects.apply(42, 0) == 0 && Effects.top() == 0);
+  CHECK(dmxOutput[40] == 0x20 && dmxBuffer[40] == 0x90);
+
+  //A 3-step chase and a sine, spread over their channels: levels worked out
+  //slot by slot in order match each one worked out on its own
+  const uint8_t chase[] = {0x70, 0x01, EFFECT_CHASE, 0, 0, 12, 0, 0, 0,
+      0x00, 0x10, 0xFF, 3};
+  run(chase, sizeof(chase));
+  const uint8_t sine[] = {0x70, 0x02, EFFECT_SINE, 4, 0, 12, 0, 0, 0,
+      0x00, 0x20, 0x7F, 0};
+  run(sine, sizeof(sine));
+  halAdvance(COMMIT_WAIT);
+  uint8_t inOrder[16];
+  for (uint16_t i = 0; i < sizeof(inOrder); i++) {
+    inOrder[i] = Effects.apply(i, 0);
+  }
+  CHECK(inOrder[0] == 0xFF && inOrder[1] == 0 && inOrder[3] == 0xFF);
+  bool same = true;
+  for (uint16_t i = sizeof(inOrder); i-- > 0;) {
+    same = same && Effects.apply(i, 0) == inOrder[i];
+  }
+  CHECK(same);
+  run(stop, sizeof(stop));
+  halAdvance(COMMIT_WAIT);
+
+  const uint8_t clear[] = {0x26, 0x00};
+  run(clear, sizeof(clear));
+  DmxSimple.commit();
+  halAdvance(COMMIT_WAIT);
+}
+
+static void testFades(void) {
+  serialLine("10 30 00\n");
+  runLoop(COMMIT_WAIT);
+
+  //A fade that waits for the two packets of its look: neither is
+  //auto-committed, so the output fades rather than snapping
+  serialLine("50 0A 00 02\n"); //1 second
+  runLoop(COMMIT_WAIT);
+  serialLine("10 30 C8\n");
+  runLoop(COMMIT_WAIT);
+  CHECK(dmxOutput[0x30] == 0 && !Fade.active());
+  serialLine("10 31 C8\n");
+  runLoop(COMMIT_WAIT);
+  CHECK(Fade.active());
+  CHECK(dmxOutput[0x30] < 0x64 && dmxOutput[0x30] == dmxOutput[0x31]);
+  runLoop(1000000000ULL);
+  CHECK(!Fade.active() && dmxOutput[0x30] == 0xC8);
+
+  //A channel changed while a fade runs joins it, outside the channels the
+  //fade started with too
+  serialLine("50 0A 00 01\n");
+  runLoop(COMMIT_WAIT);
+  serialLine("10 40 C8\n");
+  runLoop(COMMIT_WAIT);
+  CHECK(Fade.active());
+  serialLine("10 50 C8\n");
+  runLoop(1000000000ULL);
+  CHECK(!Fade.active() && dmxOutput[0x40] == 0xC8 && dmxOutput[0x50] == 0xC8);
+
+  //A fade whose look never all comes stops waiting, and auto-commit works
+  //again once it is done
+  serialLine("50 01 00 02\n");
+  runLoop(COMMIT_WAIT);
+  serialLine("10 60 C8\n");
+  runLoop(COMMIT_WAIT);
+  CHECK(dmxOutput[0x60] == 0 && !Fade.active());
+  runLoop(3000000000ULL);
+  CHECK(!Fade.active() && dmxOutput[0x60] == 0xC8);
+  serialLine("10 61 C8\n");
+  runLoop(COMMIT_WAIT);
+  CHECK(dmxOutput[0x61] == 0xC8);
+
+  serialLine("26 00\n");
+  runLoop(COMMIT_WAIT);
+  CHECK(dmxOutput[0x30] == 0);
+}
+
+static void testScenes(void) {
+  //setup() formatted the erased EEPROM, and does so again over a stranger's
+  //data; 701 bytes are left after the header and directory
+  CHECK(Scene.count() == 0 && Scene.freeSpace() == 701);
+  for (uint16_t i = 0; i < 80; i++) {
+    eeprom_update_byte((uint8_t *)(uintptr_t)i, i * 37);
+  }
+  Scene.begin();
+  CHECK(Scene.count() == 0 && Scene.freeSpace() == 701);
+
+  //The recall time runs to the frame the commit lands in
+  serialLine("10 07 99\n");
+  runLoop(COMMIT_WAIT);
+  serialLine("60 03\n");
+  runLoop(COMMIT_WAIT);
+  serialLine("26 00\n");
+  runLoop(COMMIT_WAIT);
+  CHECK(Scene.count() == 1 && dmxOutput[7] == 0);
+  serialLine("61 03\n");
+  runLoop(COMMIT_WAIT);
+  CHECK(dmxOutput[7] == 0x99);
+  uint32_t recallTime = Scene.recallTime();
+  CHECK(recallTime > 0 && recallTime < COMMIT_WAIT / 1000);
+
+  //Not sent until it is committed
+  const uint8_t manual[] = {0x29, 0x00};
+  run(manual, sizeof(manual));
+  const uint8_t recall[] = {0x61, 0x03};
+  run(recall, sizeof(recall));
+  halAdvance(COMMIT_WAIT);
+  CHECK(Scene.recallTime() == 0);
+  DmxSimple.commit();
+  halAdvance(COMMIT_WAIT);
+  CHECK(Scene.recallTime() > COMMIT_WAIT / 1000);
+
+  const uint8_t automatic[] = {0x29, 0x01};
+  run(automatic, sizeof(automatic));
+
+  //Effects (and fades) keep running while a scene is stored: a slow ramp
+  //moves on through the second or so a look of all different levels takes
+  for (uint16_t i = 0; i < DMX_SIZE; i++) {
+    dmxBuffer[i] = i * 7;
+  }
+  const uint8_t ramp[] = {0x70, 0x00, EFFECT_RAMP, 0, 0, 1, 0, 10, 0, 0, 0,
+      0xFF, 0}; //A tenth of a cycle per second
+  run(ramp, sizeof(ramp));
+  halAdvance(COMMIT_WAIT);
+  uint8_t before = Effects.apply(0, 0);
+  uint64_t start = halNow();
+  serialLine("60 05\n");
+  runLoop(COMMIT_WAIT);
+  uint32_t storeTime = (halNow() - start) / 1000000; //Milliseconds
+  uint8_t moved = Effects.apply(0, 0) - before;
+  CHECK(Scene.count() == 2 && storeTime > 1000);
+  CHECK(moved >= storeTime * 256 / 10000 / 2);
+  const uint8_t stopEffects[] = {0x71};
+  run(stopEffects, sizeof(stopEffects));
+
+  const uint8_t remove[] = {0x63, 0xFF};
+  run(remove, sizeof(remove));
+  serialLine("26 00\n");
+  runLoop(COMMIT_WAIT);
+}
+
+static void testLED(void) {
+  //Normal: lit 10 of every 15 steps
+  Error.reset();
+  int lit = countLED();
+  CHECK(lit >= LED_SAMPLES * 10 / 15 - 2 && lit <= LED_SAMPLES * 10 / 15 + 2);
+
+  //Error: every other step
+  Error.set(TIMEOUT_ERROR);
+  lit = countLED();
+  CHECK(lit >= LED_SAMPLES / 2 - 2 && lit <= LED_SAMPLES / 2 + 2);
+
+  //Debug (shown over errors): 1 of every 10 steps
+  const uint8_t debug[] = {0xDB};
+  run(debug, sizeof(debug));
+  lit = countLED();
+  CHECK(lit >= LED_SAMPLES / 10 - 1 && lit <= LED_SAMPLES / 10 + 1);
+
+  run(debug, sizeof(debug));
+  Error.reset();
+}
+
+/**
+ * countingFilter - A slot filter that counts the slots and takes filterBits
+ * bit periods on each.
+ */
+static uint8_t countingFilter(uint16_t, uint8_t level) {
+  filterCalls++;
+  halAdvance(filterBits * 4000ULL);
+  return level;
+}
+
+/**
+ * testSlotBudget - Checks that the time the slot filter takes counts against
+ * the transmit interrupt's budget. Run last: it replaces the firmware's slot
+ * filter.
+ */
+static void testSlotBudget(void) {
+  DmxSimple.maxChannel(DMX_SIZE);
+  DmxSimple.onSlot(countingFilter);
+  halAdvance(HAL_TIMER2_PERIOD);
+
+  //Free: as many 11-bit slots as fit, less the ticks a break starts in
+  filterBits = 0;
+  filterCalls = 0;
+  halAdvance(BUDGET_TICKS * HAL_TIMER2_PERIOD);
+  CHECK(filterCalls >= (BUDGET_TICKS - 1) * (TICK_BUDGET / SLOT_BITS));
+  CHECK(filterCalls <= BUDGET_TICKS * (TICK_BUDGET / SLOT_BITS));
+
+  //Slow: fewer slots go out, so the interrupt still takes its quarter
+  filterBits = SLOW_FILTER_BITS;
+  halAdvance(HAL_TIMER2_PERIOD);
+  filterCalls = 0;
+  halAdvance(BUDGET_TICKS * HAL_TIMER2_PERIOD);
+  CHECK(filterCalls > 0);
+  CHECK(filterCalls <=
+      BUDGET_TICKS * (TICK_BUDGET / (SLOT_BITS + SLOW_FILTER_BITS)));
+}
+
+int main(void) {
+  setup();
+  halAdvance(COMMIT_WAIT);
+
+  testChannels();
+  testClock();
+  testErrors();
+  testSerial();
+  testCues();
+  testGroups();
+  testEffects();
+  testFades();
+  testScenes();
+  testLED();
+  testSlotBudget();
+
+  if (failures) {
+    printf("%d check(s) failed\n", failures);
+  }
+  return failures;
+}
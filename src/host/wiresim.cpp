@@ -0,0 +1,489 @@
+/**
+ * DMX-84
+ * Link wire simulator
+ *
+ * Runs the firmware built for the host against a simulated calculator on the
+ * tip and ring lines (see calculator.h), so the link code (the receive
+ * interrupt, par_put() and par_get()) is exercised bit by bit with no
+ * hardware. Each kind of packet is sent over and over, with a fault put on
+ * every few packets:
+ *    delay      every handshake step of the packet is slowed down
+ *    drop       the adapter's acknowledgment of one bit is lost
+ *    stuck      ring is held low for a while as the packet starts
+ *    checksum   the packet's checksum is wrong
+ * The calculator recovers like a real sender: it resends after ERR, and after
+ * a timeout it waits for the adapter to give up on the packet first. Stream
+ * packets go back to the sequence number the sync answer asks for.
+ *
+ * For each packet kind and fault it prints the packets and data bytes per
+ * second, the time from each fault to the next packet accepted (the
+ * recovery time) and the number of resends, and checks that the universe
+ * ends up as sent. It fails if a packet never gets through or the universe is
+ * wrong.
+ *
+ * Usage: firmware_wiresim [-n packets] [-e every] [-s step] [-q]
+ *    -n packets  packets of each kind per run (default 40)
+ *    -e every    put the fault on every nth packet (default 5)
+ *    -s step     the calculator's reaction time in microseconds (default 10)
+ *    -q          quiet: only print runs that failed
+ *
+ * All times are on the simulated clock.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include <DmxSimple.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "firmware.h"
+#include "link.h"
+#include "calculator.h"
+#include "hal.h"
+
+/******************************************************************************
+ * Internal constants
+ ******************************************************************************/
+
+//Simulated times (nanoseconds)
+#define LOOP_PERIOD           20000     //Between runs of loop()
+#define SEND_TIMEOUT          5000000000ULL //Longest a packet takes to send
+#define REPLY_TIMEOUT         100000000 //Wait for an answer after sending
+#define QUIET_TIME            30000000  //Longer than the adapter's rxTimeout
+#define SETTLE_TIME           50000000  //For the main loop to catch up
+
+#define MAX_TRIES             8
+#define STREAM_WINDOW         8
+
+#define FAULT_NONE            0
+#define FAULT_DELAY           1
+#define FAULT_DROP            2
+#define FAULT_STUCK           3
+#define FAULT_CHECKSUM        4
+#define FAULT_KINDS           5
+
+#define DELAY_EXTRA           200000 //Added to each step (nanoseconds)
+#define STUCK_TIME            5000000
+
+/******************************************************************************
+ * Internal types
+ ******************************************************************************/
+
+struct Workload {
+  const char *name;
+  uint8_t command;  //The firmware command sent
+  bool stream;      //Sent as CMD_STREAM packets with syncs
+};
+
+struct Result {
+  uint32_t packets;
+  uint32_t bytes;
+  uint64_t time;
+  uint32_t faults;
+  uint64_t recoveryTotal;
+  uint64_t recoveryMax;
+  uint32_t resends;
+  uint32_t failed;
+};
+
+/******************************************************************************
+ * Internal variables
+ ******************************************************************************/
+
+static const Workload workloads[] = {
+  {"Set channel",      0x10, false},
+  {"Set 64 channels",  0x22, false},
+  {"Set universe",     0x27, false},
+  {"Heartbeat",        0x00, false},
+  {"Stream channel",   0x10, true}
+};
+
+static const char *faultNames[FAULT_KINDS] = {
+  "none", "delay", "drop", "stuck", "checksum"
+};
+
+static Calculator calc;
+static uint8_t expected[DMX_SIZE];
+static uint8_t runs;
+
+//When the last fault was put on the wire, or 0 once a packet got through
+static uint64_t faultStart;
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**
+ * runUntil - Runs the firmware until a condition holds or time runs out.
+ *
+ * Returns:
+ *    bool met: true if the condition held
+ */
+template <typename Condition>
+static bool runUntil(Condition condition, uint64_t timeout) {
+  uint64_t end = halNow() + timeout;
+  while (!condition()) {
+    if (halNow() >= end) {
+      return false;
+    }
+    loop();
+    halAdvance(LOOP_PERIOD);
+  }
+  return true;
+}
+
+/**
+ * sent - Runs until the calculator has sent everything queued, or given up.
+ *
+ * Returns:
+ *    bool sent: false if it gave up
+ */
+static bool sent(void) {
+  return runUntil([] { return calc.aborted || !calc.sending(); },
+      SEND_TIMEOUT) && !calc.aborted;
+}
+
+/**
+ * answered - Sends what is queued and waits for the adapter's answer.
+ *
+ * Returns:
+ *    uint8_t answer: the answer's command ID (CMD_ACK or CMD_ERR), or 0 if
+ *                    none came
+ */
+static uint8_t answered(void) {
+  if (!sent() || !runUntil([] { return calc.aborted ||
+      (!calc.replies.empty() && !calc.sending()); }, REPLY_TIMEOUT) ||
+      calc.aborted) {
+    return 0;
+  }
+  return calc.replies.front()[1];
+}
+
+/**
+ * settle - Waits for the adapter to give up on a broken packet and clears the
+ * calculator.
+ */
+static void settle(void) {
+  calc.abort();
+  runUntil([] { return false; }, QUIET_TIME);
+  calc.abort();
+  calc.replies.clear();
+  calc.aborted = false;
+}
+
+/**
+ * injectFault - Puts a fault on the next packet queued.
+ *
+ * Returns:
+ *    bool badChecksum: whether the packet's checksum must be wrong
+ */
+static bool injectFault(uint8_t fault) {
+  faultStart = halNow();
+  switch (fault) {
+    case FAULT_DELAY:
+      calc.delaySteps(DELAY_EXTRA, 0xFFFF);
+      break;
+    case FAULT_DROP:
+      calc.dropEdge(2);
+      break;
+    case FAULT_STUCK:
+      calc.stick(TI_RING_PIN, STUCK_TIME);
+      break;
+    case FAULT_CHECKSUM:
+      return true;
+  }
+  return false;
+}
+
+/**
+ * accepted - Records that a packet got through, ending any recovery.
+ */
+static void accepted(Result &result) {
+  if (faultStart) {
+    uint64_t time = halNow() - faultStart;
+    result.recoveryTotal += time;
+    result.recoveryMax = max(result.recoveryMax, time);
+    faultStart = 0;
+  }
+}
+
+/**
+ * makeCommand - Builds the command for the nth packet of a workload and
+ * notes what it does to the universe.
+ */
+static Packet makeCommand(uint8_t command, uint32_t n) {
+  Packet data(1, command);
+  uint8_t value = n * 37 + runs * 11; //Different in every run
+  switch (command) {
+    case 0x10:
+      data.push_back(n % 128);
+      data.push_back(value);
+      expected[n % 128] = value;
+      break;
+    case 0x22:
+      data.push_back(0);
+      data.push_back(64);
+      for (uint16_t i = 0; i < 64; i++) {
+        data.push_back(value + i);
+        expected[i] = value + i;
+      }
+      break;
+    case 0x27:
+      for (uint16_t i = 0; i < DMX_SIZE; i++) {
+        data.push_back(value ^ i);
+        expected[i] = value ^ i;
+      }
+      break;
+  }
+  return data;
+}
+
+/**
+ * exchange - Sends a data packet until it is acknowledged, and waits for the
+ * adapter's answer to commands that send one.
+ *
+ * Returns:
+ *    bool sent: false if it never got through
+ */
+static bool exchange(const Packet &data, uint8_t fault, Result &result) {
+  for (uint8_t tries = 0; tries < MAX_TRIES; tries++) {
+    calc.replies.clear();
+    calc.packets.clear();
+    calc.aborted = false;
+    bool bad = tries == 0 && fault ? injectFault(fault) : false;
+    calc.send(CMD_DATA, &data[0], data.size(), bad);
+    if (tries) {
+      result.resends++;
+    }
+
+    uint8_t answer = answered();
+    if (answer == CMD_ERR) {
+      continue; //Resend at once
+    }
+    if (answer != CMD_ACK) {
+      settle();
+      continue;
+    }
+    accepted(result);
+    if (data[0] == 0x00) {
+      //The heartbeat is echoed back in a data packet
+      if (!runUntil([] { return !calc.packets.empty() && !calc.sending(); },
+          REPLY_TIMEOUT) || calc.packets.front() != data) {
+        return false;
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
+/**
+ * sync - Sends a stream sync until it is answered.
+ *
+ * Parameter:
+ *    uint8_t &next: set to the sequence number the adapter expects next
+ *
+ * Returns:
+ *    uint8_t answer: CMD_ACK, CMD_ERR, or 0 if it never got an answer
+ */
+static uint8_t sync(uint8_t &next) {
+  for (uint8_t tries = 0; tries < MAX_TRIES; tries++) {
+    calc.replies.clear();
+    calc.aborted = false;
+    calc.send(CMD_STREAM_SYNC);
+    uint8_t answer = answered();
+    if (answer == CMD_ACK || answer == CMD_ERR) {
+      next = calc.replies.front()[2];
+      return answer;
+    }
+    settle();
+  }
+  return 0;
+}
+
+/**
+ * stream - Sends stream packets in windows, going back to where the adapter
+ * asks after each sync.
+ *
+ * Returns:
+ *    uint32_t failed: the number of packets that never got through
+ */
+static uint32_t stream(const Workload &load, uint32_t count, uint32_t every,
+    uint8_t fault, Result &result) {
+  //Carry on from the adapter's sequence number
+  uint8_t sequence;
+  if (!sync(sequence)) {
+    return count;
+  }
+
+  uint32_t base = 0; //First packet of the window
+  uint32_t highest = 0; //Packets sent at least once
+  uint32_t windows = 0;
+  std::vector<bool> faulted(count, false);
+  while (base < count) {
+    if (++windows > count * MAX_TRIES) {
+      return count - base;
+    }
+    uint32_t end = min(base + STREAM_WINDOW, count);
+    for (uint32_t n = base; n < end; n++) {
+      Packet data(1, (uint8_t)(sequence + (n - base)));
+      Packet command = makeCommand(load.command, n);
+      data.insert(data.end(), command.begin(), command.end());
+      bool bad = false;
+      if (fault && n % every == every - 1 && !faulted[n]) {
+        faulted[n] = true;
+        bad = injectFault(fault);
+      }
+      if (n < highest) {
+        result.resends++;
+      }
+      highest = max(highest, n + 1);
+      calc.aborted = false;
+      calc.send(CMD_STREAM, &data[0], data.size(), bad);
+      if (!sent()) {
+        settle();
+      }
+    }
+
+    //Ask how the window went, and go back to where the adapter says
+    uint8_t next;
+    uint8_t answer = sync(next);
+    if (!answer) {
+      return count - base;
+    }
+    uint32_t done = (uint8_t)(next - sequence);
+    if (done > end - base) {
+      done = 0; //Not in this window; send it again
+    }
+    if (answer == CMD_ACK && done) {
+      accepted(result);
+    }
+    base += done;
+    sequence += done;
+  }
+  return 0;
+}
+
+/**
+ * run - Sends one workload with one kind of fault.
+ */
+static Result run(const Workload &load, uint32_t count, uint32_t every,
+    uint8_t fault) {
+  Result result = {};
+  faultStart = 0;
+  runs++;
+  memcpy(expected, (const void *)dmxBuffer, DMX_SIZE);
+  uint64_t start = halNow();
+
+  if (load.stream) {
+    result.failed = stream(load, count, every, fault, result);
+    for (uint32_t n = 0; n < count; n++) {
+      result.bytes += 1 + makeCommand(load.command, n).size(); //Sequence too
+    }
+  } else {
+    for (uint32_t n = 0; n < count; n++) {
+      Packet data = makeCommand(load.command, n);
+      bool faulty = fault && n % every == every - 1;
+      if (!exchange(data, faulty ? fault : FAULT_NONE, result)) {
+        result.failed++;
+      }
+      result.bytes += data.size();
+    }
+  }
+  result.packets = count;
+  result.time = halNow() - start;
+  if (fault) {
+    result.faults = count / every;
+  }
+
+  //Let the main loop apply everything, then check the universe
+  runUntil([] { return false; }, SETTLE_TIME);
+  if (memcmp(expected, (const void *)dmxBuffer, DMX_SIZE)) {
+    result.failed++;
+  }
+  return result;
+}
+
+int main(int argc, char **argv) {
+  uint32_t count = 40, every = 5;
+  bool quiet = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:e:s:q")) != -1) {
+    switch (opt) {
+      case 'n': count = strtoul(optarg, 0, 0); break;
+      case 'e': every = strtoul(optarg, 0, 0); break;
+      case 's': calc.stepTime = strtoul(optarg, 0, 0) * 1000; break;
+      case 'q': quiet = true; break;
+      default:
+        fprintf(stderr, "Usage: %s [-n packets] [-e every] [-s step] [-q]\n",
+            argv[0]);
+        return 2;
+    }
+  }
+  if (count < 1 || every < 2) {
+    fprintf(stderr, "%s: -n must be at least 1 and -e at least 2\n", argv[0]);
+    return 2;
+  }
+
+  //Connect the calculator first, so it hears the adapter's CTS
+  halAttach(&calc);
+  setup();
+  calc.send(CMD_RDY);
+  if (!runUntil([] { return !calc.replies.empty() &&
+      calc.replies.back()[1] == CMD_ACK; }, REPLY_TIMEOUT)) {
+    printf("No answer to the ready check\n");
+    return 1;
+  }
+
+  if (!quiet) {
+    printf("%-16s %-9s %10s %10s %13s %8s %7s\n", "Packets", "Fault",
+        "packets/s", "bytes/s", "recovery ms", "resends", "failed");
+  }
+  int failed = 0;
+  for (unsigned i = 0; i < sizeof(workloads) / sizeof(workloads[0]); i++) {
+    for (uint8_t fault = FAULT_NONE; fault < FAULT_KINDS; fault++) {
+      Result result = run(workloads[i], count, every, fault);
+      double seconds = result.time / 1e9;
+      if (!quiet || result.failed) {
+        printf("%-16s %-9s %10.1f %10.0f ", workloads[i].name,
+            faultNames[fault], result.packets / seconds,
+            result.bytes / seconds);
+        if (result.faults) {
+          printf("%6.1f/%6.1f", result.recoveryTotal / 1e6 / result.faults,
+              result.recoveryMax / 1e6);
+        } else {
+          printf("%13s", "-");
+        }
+        printf(" %8u %7u\n", result.resends, result.failed);
+      }
+      failed += result.failed;
+    }
+  }
+  if (!quiet) {
+    printf("(recovery: average/worst from the fault to the next packet "
+        "accepted)\n");
+  }
+  return failed ? 1 : 0;
+}
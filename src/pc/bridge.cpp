@@ -0,0 +1,669 @@
+/**
+ * DMX-84
+ * Art-Net/sACN bridge
+ *
+ * Receives one DMX universe as Art-Net or E1.31 (sACN) over UDP and keeps the
+ * adapter up to date through its serial debug port, which accepts commands as
+ * lines of hex (see LinkClass::parseSerial).
+ *
+ * The serial port is far slower than the network, so incoming frames are
+ * merged into one universe and sent only as fast as the port can carry them.
+ * Each update sends just what changed since the last one, using whichever of
+ * the single channel (0x10/0x11), block (0x22/0x23) or codec packets (raw
+ * 0x27, RLE 0x2A, delta 0x2B) takes the fewest characters on the wire.
+ *
+ * Every update ends with a heartbeat (0x00), and the next update waits for
+ * the adapter to echo it, so updates never queue up in the port's buffers
+ * however fast the adapter really is. The port speed (-b, -u) is only used
+ * to model how long the characters take on the wire.
+ *
+ * Usage: dmxbridge [options] <serial port>
+ *    -a universe   Art-Net port address to follow (default 0)
+ *    -e universe   sACN universe to follow (default 1)
+ *    -A port       Art-Net UDP port (default 6454, 0 to disable)
+ *    -E port       sACN UDP port (default 5568, 0 to disable)
+ *    -b baud       serial speed (default 9600, as SERIAL_SPEED in link.h)
+ *    -u percent    share of the serial port to use (default 90)
+ *    -s seconds    print stats this often (default 5, 0 for only at exit)
+ *    -v            copy the adapter's serial output to stderr
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "codec.h"
+#include "trace.h"
+
+/******************************************************************************
+ * Internal constants
+ ******************************************************************************/
+
+#define ARTNET_PORT           6454
+#define SACN_PORT             5568
+
+//Largest UDP payload either protocol uses
+#define MAX_DATAGRAM          640
+
+//Art-Net ArtDmx layout
+#define ARTNET_OPDMX          0x5000
+#define ARTNET_HEADER_LENGTH  18
+
+//E1.31 layout (root, framing and DMP layers)
+#define SACN_ROOT_VECTOR      0x00000004
+#define SACN_FRAME_VECTOR     0x00000002
+#define SACN_DMP_VECTOR       0x02
+#define SACN_HEADER_LENGTH    126
+
+//Serial characters per packet byte (two hex digits), plus one per line
+#define CHARS_PER_BYTE        2
+#define CHARS_PER_LINE        1
+
+//Longest update: every channel as a single channel command
+#define MAX_UPDATE_CHARS      (CODEC_UNIVERSE_SIZE * (3 * CHARS_PER_BYTE + \
+                                  CHARS_PER_LINE))
+
+//Sent after each update; the adapter echoes it once it has run the update
+#define HEARTBEAT_LINE        "00\n"
+#define HEARTBEAT_CHARS       3
+
+//Seconds to wait for the echo, after the update would have gone out at the
+//port speed, before sending the next update anyway
+#define REPLY_TIMEOUT         1.0
+
+//Bytes of a trace record after TRACE_SYNC (tracing comes with serial debugging)
+#define TRACE_RECORD_LENGTH   8
+
+//Longest line read back from the adapter
+#define MAX_REPLY_LINE        256
+
+/******************************************************************************
+ * Internal types
+ ******************************************************************************/
+
+struct Stats {
+  unsigned long artnetFrames;  //Matching frames received
+  unsigned long sacnFrames;
+  unsigned long changedFrames; //Frames that changed the universe
+  unsigned long updates;       //Updates sent to the adapter
+  unsigned long packets;       //Lines sent (an update can be several)
+  unsigned long chars;         //Characters sent
+  unsigned long answered;      //Updates whose heartbeat was echoed
+  unsigned long unanswered;    //Updates given up on after REPLY_TIMEOUT
+  double latencyTotal;         //Seconds from first change to the echo, summed
+  double latencyMax;
+  double modelTotal;           //Seconds from first change until the last
+  double modelMax;             //character would leave at the port speed
+};
+
+/******************************************************************************
+ * Internal variables
+ ******************************************************************************/
+
+static uint8_t latest[CODEC_UNIVERSE_SIZE]; //Newest values from the network
+static uint8_t sent[CODEC_UNIVERSE_SIZE];   //What the adapter has
+static bool sentKnown = false;              //Whether sent is valid yet
+static double changedAt = 0;                //When latest first differed
+
+static Stats total, interval;
+static volatile sig_atomic_t quit = 0;
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**
+ * now - Returns a monotonic time in seconds.
+ */
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void onSignal(int) {
+  quit = 1;
+}
+
+/**
+ * openPort - Opens the adapter's serial port raw.
+ *
+ * Parameters:
+ *    const char *path: the serial device (or a pty standing in for it)
+ *    unsigned baud: the serial speed
+ * Returns:
+ *    int fd: the open port, or -1 on failure
+ */
+static int openPort(const char *path, unsigned baud) {
+  int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (fd < 0) {
+    return -1;
+  }
+  struct termios tio;
+  if (tcgetattr(fd, &tio) == 0) {
+    speed_t speed = baud == 115200 ? B115200 : baud == 57600 ? B57600 :
+        baud == 38400 ? B38400 : baud == 19200 ? B19200 : B9600;
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+  return fd;
+}
+
+/**
+ * openUdp - Opens a UDP socket listening on a port on every interface.
+ *
+ * Returns:
+ *    int fd: the socket, or -1 on failure
+ */
+static int openUdp(unsigned port) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  int yes = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/**
+ * joinSacn - Joins the multicast group of an sACN universe. Unicast sACN
+ * still works if this fails.
+ */
+static void joinSacn(int fd, unsigned universe) {
+  struct ip_mreq mreq;
+  memset(&mreq, 0, sizeof(mreq));
+  mreq.imr_multiaddr.s_addr = htonl(0xEFFF0000 | (universe & 0xFFFF));
+  mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+  if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+    fprintf(stderr, "Could not join sACN multicast: %s\n", strerror(errno));
+  }
+}
+
+/**
+ * apply - Merges received channel values into the universe.
+ *
+ * Parameters:
+ *    const uint8_t *data: the values, starting at channel 0
+ *    unsigned count: the number of values
+ * Returns:
+ *    bool changed: whether any channel changed
+ */
+static bool apply(const uint8_t *data, unsigned count) {
+  if (count > CODEC_UNIVERSE_SIZE) {
+    count = CODEC_UNIVERSE_SIZE;
+  }
+  if (!memcmp(latest, data, count)) {
+    return false;
+  }
+  memcpy(latest, data, count);
+  return true;
+}
+
+/**
+ * parseArtnet - Applies an ArtDmx packet for our universe.
+ *
+ * Returns:
+ *    int result: -1 if it is not for us, otherwise whether anything changed
+ */
+static int parseArtnet(const uint8_t *p, unsigned length, unsigned universe) {
+  if (length < ARTNET_HEADER_LENGTH || memcmp(p, "Art-Net", 8) ||
+      (p[8] | p[9] << 8) != ARTNET_OPDMX ||
+      (p[14] | (p[15] & 0x7F) << 8) != universe) {
+    return -1;
+  }
+  unsigned count = p[16] << 8 | p[17];
+  if (count > length - ARTNET_HEADER_LENGTH) {
+    count = length - ARTNET_HEADER_LENGTH;
+  }
+  return apply(p + ARTNET_HEADER_LENGTH, count);
+}
+
+/**
+ * parseSacn - Applies an E1.31 data packet for our universe.
+ *
+ * Returns:
+ *    int result: -1 if it is not for us, otherwise whether anything changed
+ *
+ * Only null start code data is used. Priorities and multiple sources are not
+ * merged; the newest packet wins.
+ */
+static int parseSacn(const uint8_t *p, unsigned length, unsigned universe) {
+  static const uint8_t acnId[] = "ASC-E1.17\0\0";
+  if (length < SACN_HEADER_LENGTH || memcmp(p + 4, acnId, 12) ||
+      (uint32_t)(p[18] << 24 | p[19] << 16 | p[20] << 8 | p[21]) !=
+          SACN_ROOT_VECTOR ||
+      (uint32_t)(p[40] << 24 | p[41] << 16 | p[42] << 8 | p[43]) !=
+          SACN_FRAME_VECTOR ||
+      (unsigned)(p[113] << 8 | p[114]) != universe ||
+      p[117] != SACN_DMP_VECTOR || p[125] != 0) {
+    return -1;
+  }
+  if (p[112] & 0x40) {
+    return 0; //Stream terminated: keep the last look
+  }
+  unsigned count = (p[123] << 8 | p[124]) - 1; //Less the start code
+  if (count > length - SACN_HEADER_LENGTH) {
+    count = length - SACN_HEADER_LENGTH;
+  }
+  return apply(p + SACN_HEADER_LENGTH, count);
+}
+
+/**
+ * addLine - Appends a packet to the text of an update as a line of hex.
+ *
+ * Parameters:
+ *    char *text: the update
+ *    unsigned *length: the characters in text so far (updated)
+ *    const uint8_t *packet: the packet
+ *    unsigned count: the packet length
+ */
+static void addLine(char *text, unsigned *length, const uint8_t *packet,
+    unsigned count) {
+  static const char hex[] = "0123456789ABCDEF";
+  for (unsigned i = 0; i < count; i++) {
+    text[(*length)++] = hex[packet[i] >> 4];
+    text[(*length)++] = hex[packet[i] & 0x0F];
+  }
+  text[(*length)++] = '\n';
+}
+
+/**
+ * buildUpdate - Builds the shortest serial text that brings the adapter from
+ * sent to latest.
+ *
+ * Parameters:
+ *    char *text: where to put the update (MAX_UPDATE_CHARS)
+ *    unsigned *lines: set to the number of packets in the update
+ * Returns:
+ *    unsigned length: the characters in the update, or 0 if nothing changed
+ */
+static unsigned buildUpdate(char *text, unsigned *lines) {
+  uint8_t packet[CODEC_MAX_PACKET];
+  unsigned length = 0;
+
+  //The codec packet (raw, RLE or delta) is always a candidate
+  unsigned packetLength = Codec.pack(latest, sentKnown ? sent : 0, packet);
+  if (!packetLength) {
+    return 0;
+  }
+  addLine(text, &length, packet, packetLength);
+  *lines = 1;
+  if (!sentKnown) {
+    return length;
+  }
+
+  unsigned first = 0, end = CODEC_UNIVERSE_SIZE, changed = 0;
+  while (latest[first] == sent[first]) {
+    first++;
+  }
+  while (latest[end - 1] == sent[end - 1]) {
+    end--;
+  }
+  for (unsigned i = first; i < end; i++) {
+    changed += latest[i] != sent[i];
+  }
+
+  //A block command covering every change
+  unsigned span = end - first;
+  unsigned blockChars = (3 + span) * CHARS_PER_BYTE + CHARS_PER_LINE;
+  //One single channel command per change
+  unsigned singleChars = changed * (3 * CHARS_PER_BYTE + CHARS_PER_LINE);
+
+  if (span <= 255 && blockChars < length && blockChars <= singleChars) {
+    length = 0;
+    packet[0] = 0x22 | first >> 8;
+    packet[1] = first & 0xFF;
+    packet[2] = span;
+    memcpy(&packet[3], &latest[first], span);
+    addLine(text, &length, packet, 3 + span);
+  } else if (singleChars < length) {
+    length = 0;
+    *lines = 0;
+    for (unsigned i = first; i < end; i++) {
+      if (latest[i] != sent[i]) {
+        packet[0] = 0x10 | i >> 8;
+        packet[1] = i & 0xFF;
+        packet[2] = latest[i];
+        addLine(text, &length, packet, 3);
+        (*lines)++;
+      }
+    }
+  }
+  return length;
+}
+
+/**
+ * readReplies - Reads what the adapter has printed and looks for the echo of
+ * a heartbeat: "Sent: " and the reply packet in hex, whose data is just 00.
+ * Trace records are skipped.
+ *
+ * Returns:
+ *    int echoes: the number of heartbeat echoes read, or -1 if the port failed
+ */
+static int readReplies(int fd, bool verbose) {
+  static char line[MAX_REPLY_LINE];
+  static unsigned length = 0, skip = 0;
+  char data[256];
+  ssize_t n = read(fd, data, sizeof(data));
+  if (n < 0) {
+    return errno == EAGAIN || errno == EINTR ? 0 : -1;
+  }
+  if (verbose) {
+    fwrite(data, 1, n, stderr);
+  }
+
+  int echoes = 0;
+  for (ssize_t i = 0; i < n; i++) {
+    unsigned char c = data[i];
+    if (skip) {
+      skip--;
+    } else if (c == TRACE_SYNC) {
+      skip = TRACE_RECORD_LENGTH;
+    } else if (c == '\n') {
+      line[length] = 0;
+      length = 0;
+      unsigned bytes[5];
+      if (sscanf(line, "Sent: %x %x %x %x %x", &bytes[0], &bytes[1],
+          &bytes[2], &bytes[3], &bytes[4]) == 5 && bytes[1] == 0x15 &&
+          bytes[2] == 1 && bytes[3] == 0 && bytes[4] == 0) {
+        echoes++;
+      }
+    } else if (c != '\r' && length + 1 < sizeof(line)) {
+      line[length++] = c;
+    }
+  }
+  return echoes;
+}
+
+/**
+ * writeAll - Writes all of a buffer to the (non-blocking) serial port.
+ *
+ * Returns:
+ *    bool written: false if the port failed
+ */
+static bool writeAll(int fd, const char *text, unsigned length) {
+  while (length) {
+    ssize_t n = write(fd, text, length);
+    if (n < 0) {
+      if (errno != EAGAIN && errno != EINTR) {
+        return false;
+      }
+      struct pollfd p = {fd, POLLOUT, 0};
+      poll(&p, 1, 100);
+      continue;
+    }
+    text += n;
+    length -= n;
+  }
+  return true;
+}
+
+/**
+ * printStats - Prints a line of statistics.
+ *
+ * Parameters:
+ *    const char *label: what the stats cover
+ *    const Stats &s: the counts
+ *    double seconds: the time they cover
+ *    double charRate: the characters per second the port can carry
+ */
+static void printStats(const char *label, const Stats &s, double seconds,
+    double charRate) {
+  if (seconds <= 0) {
+    return;
+  }
+  printf("%s %.1fs: in %.1f/s (Art-Net %lu, sACN %lu, %lu changed), "
+      "out %.1f updates/s, %.1f lines/s, %.0f chars/s (%.0f%% of port), "
+      "latency to echo avg %.1fms max %.1fms (%lu unanswered), "
+      "modelled wire latency avg %.1fms max %.1fms\n",
+      label, seconds, (s.artnetFrames + s.sacnFrames) / seconds,
+      s.artnetFrames, s.sacnFrames, s.changedFrames,
+      s.updates / seconds, s.packets / seconds, s.chars / seconds,
+      100 * s.chars / seconds / charRate,
+      s.answered ? 1000 * s.latencyTotal / s.answered : 0,
+      1000 * s.latencyMax, s.unanswered,
+      s.updates ? 1000 * s.modelTotal / s.updates : 0,
+      1000 * s.modelMax);
+  fflush(stdout);
+}
+
+/**
+ * count - Adds one sent update to a set of stats.
+ *
+ * Parameters:
+ *    Stats &s: the stats
+ *    unsigned lines: the lines sent, heartbeat included
+ *    unsigned chars: the characters sent
+ *    double model: the modelled latency (seconds)
+ */
+static void count(Stats &s, unsigned lines, unsigned chars, double model) {
+  s.updates++;
+  s.packets += lines;
+  s.chars += chars;
+  s.modelTotal += model;
+  if (model > s.modelMax) {
+    s.modelMax = model;
+  }
+}
+
+/**
+ * countAnswer - Adds the measured latency of an update to a set of stats,
+ * once the adapter has echoed its heartbeat.
+ */
+static void countAnswer(Stats &s, double latency) {
+  s.answered++;
+  s.latencyTotal += latency;
+  if (latency > s.latencyMax) {
+    s.latencyMax = latency;
+  }
+}
+
+int main(int argc, char **argv) {
+  unsigned artnetUniverse = 0, sacnUniverse = 1;
+  unsigned artnetPort = ARTNET_PORT, sacnPort = SACN_PORT;
+  unsigned baud = 9600, usePercent = 90;
+  double statsEvery = 5;
+  bool verbose = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "a:e:A:E:b:u:s:v")) != -1) {
+    switch (opt) {
+      case 'a': artnetUniverse = strtoul(optarg, 0, 0); break;
+      case 'e': sacnUniverse = strtoul(optarg, 0, 0); break;
+      case 'A': artnetPort = strtoul(optarg, 0, 0); break;
+      case 'E': sacnPort = strtoul(optarg, 0, 0); break;
+      case 'b': baud = strtoul(optarg, 0, 0); break;
+      case 'u': usePercent = strtoul(optarg, 0, 0); break;
+      case 's': statsEvery = atof(optarg); break;
+      case 'v': verbose = true; break;
+      default:
+        fprintf(stderr, "Usage: %s [-a universe] [-e universe] [-A port] "
+            "[-E port] [-b baud] [-u percent] [-s seconds] [-v] "
+            "<serial port>\n", argv[0]);
+        return 2;
+    }
+  }
+  if (optind >= argc || !usePercent || usePercent > 100) {
+    fprintf(stderr, "%s: need a serial port (and -u 1-100)\n", argv[0]);
+    return 2;
+  }
+
+  int serialFd = openPort(argv[optind], baud);
+  if (serialFd < 0) {
+    perror(argv[optind]);
+    return 1;
+  }
+  int artnetFd = artnetPort ? openUdp(artnetPort) : -1;
+  int sacnFd = sacnPort ? openUdp(sacnPort) : -1;
+  if (artnetPort && artnetFd < 0) {
+    fprintf(stderr, "Art-Net port %u: %s\n", artnetPort, strerror(errno));
+  }
+  if (sacnPort && sacnFd < 0) {
+    fprintf(stderr, "sACN port %u: %s\n", sacnPort, strerror(errno));
+  } else if (sacnFd >= 0) {
+    joinSacn(sacnFd, sacnUniverse);
+  }
+  if (artnetFd < 0 && sacnFd < 0) {
+    return 1;
+  }
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  /* Pacing: the next update waits for the echo of the last one's heartbeat
+   * (or REPLY_TIMEOUT), and also until it would have gone out at the share
+   * of the port's speed we may use. Frames that arrive in the meantime are
+   * merged into the next update. The port speed is only a model of the
+   * wire; the echo is what the adapter really did.
+   */
+  const double charRate = baud / 10.0 * usePercent / 100; //8N1
+  double busyUntil = now();
+  double started = busyUntil, intervalStarted = busyUntil;
+  bool awaiting = false; //Waiting for a heartbeat echo
+  double awaitingChange = 0; //When the update's first change arrived
+
+  static char text[MAX_UPDATE_CHARS];
+  unsigned textLength = 0, textLines = 0;
+
+  while (!quit) {
+    double t = now();
+
+    //An echo that never comes (a lost line, or no adapter) only holds
+    //updates up for a while
+    int wait = 1000;
+    if (awaiting && t - busyUntil >= REPLY_TIMEOUT) {
+      total.unanswered++;
+      interval.unanswered++;
+      awaiting = false;
+    }
+
+    //Send an update if anything changed and the adapter is ready for it
+    if (changedAt) {
+      if (!textLength) {
+        textLength = buildUpdate(text, &textLines);
+      }
+      if (!textLength) {
+        changedAt = 0; //Changed back to what the adapter already has
+      } else if (awaiting) {
+        wait = (int)((busyUntil + REPLY_TIMEOUT - t) * 1000) + 1;
+      } else if (t >= busyUntil) {
+        if (!writeAll(serialFd, text, textLength) ||
+            !writeAll(serialFd, HEARTBEAT_LINE, HEARTBEAT_CHARS)) {
+          perror("serial write");
+          break;
+        }
+        unsigned chars = textLength + HEARTBEAT_CHARS;
+        busyUntil = t + chars / charRate;
+        double model = busyUntil - changedAt; //Until the last character
+        count(total, textLines + 1, chars, model);
+        count(interval, textLines + 1, chars, model);
+        awaiting = true;
+        awaitingChange = changedAt;
+        memcpy(sent, latest, sizeof(sent));
+        sentKnown = true;
+        changedAt = 0;
+        textLength = 0;
+      } else {
+        wait = (int)((busyUntil - t) * 1000) + 1;
+      }
+    }
+
+    if (statsEvery > 0 && t - intervalStarted >= statsEvery) {
+      printStats("last", interval, t - intervalStarted, charRate);
+      memset(&interval, 0, sizeof(interval));
+      intervalStarted = t;
+    }
+
+    struct pollfd fds[3] = {
+      {serialFd, POLLIN, 0}, {artnetFd, POLLIN, 0}, {sacnFd, POLLIN, 0},
+    };
+    if (poll(fds, 3, wait) < 0) {
+      continue; //Interrupted
+    }
+
+    if (fds[0].revents & POLLIN) {
+      int echoes = readReplies(serialFd, verbose);
+      if (echoes < 0) {
+        perror("serial read");
+        break;
+      }
+      if (echoes && awaiting) {
+        double latency = now() - awaitingChange;
+        countAnswer(total, latency);
+        countAnswer(interval, latency);
+        awaiting = false;
+      }
+    }
+    for (int i = 1; i < 3; i++) {
+      if (!(fds[i].revents & POLLIN)) {
+        continue;
+      }
+      uint8_t datagram[MAX_DATAGRAM];
+      ssize_t n = recv(fds[i].fd, datagram, sizeof(datagram), 0);
+      if (n <= 0) {
+        continue;
+      }
+      int result = i == 1 ? parseArtnet(datagram, n, artnetUniverse) :
+          parseSacn(datagram, n, sacnUniverse);
+      if (result < 0) {
+        continue;
+      }
+      (i == 1 ? total.artnetFrames : total.sacnFrames)++;
+      (i == 1 ? interval.artnetFrames : interval.sacnFrames)++;
+      if (result) {
+        total.changedFrames++;
+        interval.changedFrames++;
+        textLength = 0; //Rebuild with the new values
+        if (!changedAt) {
+          changedAt = now();
+        }
+      }
+    }
+  }
+
+  printStats("total", total, now() - started, charRate);
+  return 0;
+}
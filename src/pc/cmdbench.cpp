@@ -0,0 +1,294 @@
+/**
+ * DMX-84
+ * Command benchmark
+ *
+ * Times every protocol command on the adapter and prints a table, so a
+ * firmware change that slows command handling shows up before it is used on
+ * a show. Each command is sent through the serial debug port wrapped in the
+ * timing command (0xF3), which runs it on the adapter a number of times and
+ * replies with the minimum, average and maximum time it took.
+ *
+ * The commands really run, so the adapter's channels, fades, effects and
+ * settings are left changed afterwards.
+ *
+ * Usage: cmdbench [-r repeat] [-b baud] [-w] <serial port>
+ *    -r repeat   times to run each command (default 16)
+ *    -b baud     serial speed (default 9600, as SERIAL_SPEED in link.h)
+ *    -w          also time the commands that write EEPROM (scene store and
+ *                delete), which wears it
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+
+#include "../arduino/firmware/trace.h"
+
+/******************************************************************************
+ * Internal constants
+ ******************************************************************************/
+
+#define BENCH_CMD             0xF3
+
+//Bytes of a trace record after TRACE_SYNC
+#define TRACE_RECORD_LENGTH   8
+
+//Seconds to wait for each reply (long enough for a scene store)
+#define REPLY_TIMEOUT         5
+
+/******************************************************************************
+ * Internal types
+ ******************************************************************************/
+
+struct Command {
+  const char *name;
+  const char *hex;      //The command packet
+  unsigned fill;        //Extra bytes appended after hex, counting up from 0
+  bool writesEeprom;
+};
+
+/******************************************************************************
+ * Internal variables
+ ******************************************************************************/
+
+/* One representative packet per command. 0x27 is left out: with the timing
+ * prefix it is longer than the adapter's largest packet.
+ */
+static const Command suite[] = {
+  {"Heartbeat",                "00",                         0,   false},
+  {"Read clock",               "04",                         0,   false},
+  {"Set channel",              "10 05 80",                   0,   false},
+  {"Set channel (high)",       "11 05 80",                   0,   false},
+  {"Increment channel",        "12 05",                      0,   false},
+  {"Decrement channel",        "14 05",                      0,   false},
+  {"Increment channel by",     "16 05 10",                   0,   false},
+  {"Decrement channel by",     "18 05 10",                   0,   false},
+  {"Set 256 channels",         "20",                         256, false},
+  {"Set 64-channel block",     "22 00 40",                   64,  false},
+  {"Increment all",            "24 01",                      0,   false},
+  {"Decrement all",            "25 01",                      0,   false},
+  {"Set all",                  "26 80",                      0,   false},
+  {"Commit",                   "28",                         0,   false},
+  {"Commit mode",              "29 01",                      0,   false},
+  {"RLE universe",             "2A 00 00 FF 80 FF 80 FF 80 FF 80", 0, false},
+  {"Delta, 2 channels",        "2B 10 00 81 01",             0,   false},
+  {"Scatter, 4 pairs",         "2C 0A 01 10 02 20 03 30 04 40", 0, false},
+  {"Bitmap scatter, 4",        "2E 00 00 01 0F 10 20 30 40", 0,   false},
+  {"Copy high to low",         "30",                         0,   false},
+  {"Copy low to high",         "31",                         0,   false},
+  {"Exchange halves",          "32",                         0,   false},
+  {"Read channel",             "40 05",                      0,   false},
+  {"Read universe",            "42",                         0,   false},
+  {"Read RLE chunk",           "43 00 00",                   0,   false},
+  {"Fade",                     "50 0A 00",                   0,   false},
+  {"Split fade",               "51 0A 00 14 00 00 00 05 00", 0,   false},
+  {"Fade progress",            "52",                         0,   false},
+  {"Stop fade",                "53",                         0,   false},
+  {"Store scene",              "60 0F",                      0,   true},
+  {"Recall scene",             "61 0F",                      0,   false},
+  {"Recall scene with fade",   "62 0F 0A 00",                0,   false},
+  {"Delete scene",             "63 0F",                      0,   true},
+  {"Scene info",               "64",                         0,   false},
+  {"Start effect",             "70 00 01 00 00 10 00 64 00 00 10 FF 00", 0, false},
+  {"Stop effects",             "71",                         0,   false},
+  {"Set curve",                "80 00 00 20 00 01 00",       0,   false},
+  {"Clear curves",             "82",                         0,   false},
+  {"Group bitmap",             "90 00 00",                   64,  false},
+  {"Group range",              "91 01 00 00 40 00 01",       0,   false},
+  {"Grand master",             "93 FF",                      0,   false},
+  {"Submaster",                "94 FF",                      0,   false},
+  {"Stop DMX",                 "E0",                         0,   false},
+  {"Start DMX",                "E1",                         0,   false},
+  {"Max channels",             "E3 00",                      0,   false},
+  {"Start blackout",           "E4",                         0,   false},
+  {"Stop blackout",            "E5",                         0,   false},
+  {"Break timing",             "E6 58 00 08 00",             0,   false},
+  {"Frame rate",               "E7 00 00 00",                0,   false},
+  {"Start code",               "E8 00",                      0,   false},
+  {"Auto-trim",                "E9 00",                      0,   false},
+  {"Trace level",              "F2 02",                      0,   false},
+  {"Stats",                    "F4",                         0,   false},
+  {"Frame timing",             "F6",                         0,   false},
+  {"Status",                   "F8",                         0,   false},
+  {"Errors",                   "F9",                         0,   false},
+  {"Versions",                 "FA",                         0,   false},
+  {"Temperature",              "FD",                         0,   false},
+  {"Uptime",                   "FE",                         0,   false},
+};
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**
+ * openPort - Opens the adapter's serial port raw.
+ *
+ * Returns:
+ *    int fd: the open port, or -1 on failure
+ */
+static int openPort(const char *path, unsigned baud) {
+  int fd = open(path, O_RDWR | O_NOCTTY);
+  if (fd < 0) {
+    return -1;
+  }
+  struct termios tio;
+  if (tcgetattr(fd, &tio) == 0) {
+    speed_t speed = baud == 115200 ? B115200 : baud == 57600 ? B57600 :
+        baud == 38400 ? B38400 : baud == 19200 ? B19200 : B9600;
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+  return fd;
+}
+
+/**
+ * readLine - Reads a line of text from the adapter, skipping trace records.
+ *
+ * Parameters:
+ *    char *line: where to put the line
+ *    unsigned size: the size of line
+ * Returns:
+ *    bool read: false if nothing came in time
+ */
+static bool readLine(int fd, char *line, unsigned size) {
+  unsigned length = 0;
+  unsigned skip = 0;
+  time_t deadline = time(0) + REPLY_TIMEOUT;
+  while (time(0) <= deadline) {
+    struct pollfd p = {fd, POLLIN, 0};
+    if (poll(&p, 1, 100) <= 0) {
+      continue;
+    }
+    unsigned char c;
+    if (read(fd, &c, 1) != 1) {
+      return false;
+    }
+    if (skip) {
+      skip--;
+    } else if (c == TRACE_SYNC) {
+      skip = TRACE_RECORD_LENGTH;
+    } else if (c == '\n') {
+      line[length] = 0;
+      return true;
+    } else if (c != '\r' && length + 1 < size) {
+      line[length++] = c;
+    }
+  }
+  return false;
+}
+
+/**
+ * timeCommand - Times one command on the adapter.
+ *
+ * Parameters:
+ *    const Command &command: the command
+ *    unsigned repeat: the number of runs
+ *    unsigned *times: set to the minimum, average and maximum in microseconds
+ * Returns:
+ *    bool timed: false if the adapter didn't reply
+ */
+static bool timeCommand(int fd, const Command &command, unsigned repeat,
+    unsigned *times) {
+  char text[1200];
+  int length = sprintf(text, "%02X %02X %s", BENCH_CMD, repeat, command.hex);
+  for (unsigned i = 0; i < command.fill; i++) {
+    length += sprintf(text + length, " %02X", i & 0xFF);
+  }
+  text[length++] = '\n';
+  if (write(fd, text, length) != length) {
+    return false;
+  }
+
+  /* The reply is printed as "Sent: " and the whole packet in hex: the 4-byte
+   * header, the data and the checksum.
+   */
+  char line[1200];
+  while (readLine(fd, line, sizeof(line))) {
+    unsigned bytes[11];
+    if (sscanf(line, "Sent: %x %x %x %x %x %x %x %x %x %x %x",
+        &bytes[0], &bytes[1], &bytes[2], &bytes[3], &bytes[4], &bytes[5],
+        &bytes[6], &bytes[7], &bytes[8], &bytes[9], &bytes[10]) == 11 &&
+        bytes[4] == BENCH_CMD) {
+      for (int i = 0; i < 3; i++) {
+        times[i] = bytes[5 + 2 * i] | bytes[6 + 2 * i] << 8;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+int main(int argc, char **argv) {
+  unsigned repeat = 16, baud = 9600;
+  bool eeprom = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "r:b:w")) != -1) {
+    switch (opt) {
+      case 'r': repeat = strtoul(optarg, 0, 0); break;
+      case 'b': baud = strtoul(optarg, 0, 0); break;
+      case 'w': eeprom = true; break;
+      default:
+        fprintf(stderr, "Usage: %s [-r repeat] [-b baud] [-w] <serial port>\n",
+            argv[0]);
+        return 2;
+    }
+  }
+  if (optind >= argc || repeat < 1 || repeat > 255) {
+    fprintf(stderr, "%s: need a serial port (and -r 1-255)\n", argv[0]);
+    return 2;
+  }
+  int fd = openPort(argv[optind], baud);
+  if (fd < 0) {
+    perror(argv[optind]);
+    return 1;
+  }
+
+  printf("Cmd  %-24s %8s %8s %8s\n", "", "min us", "avg us", "max us");
+  int failed = 0;
+  for (unsigned i = 0; i < sizeof(suite) / sizeof(suite[0]); i++) {
+    const Command &command = suite[i];
+    if (command.writesEeprom && !eeprom) {
+      continue;
+    }
+    unsigned times[3];
+    printf("0x%.2s %-24s ", command.hex, command.name);
+    if (timeCommand(fd, command, repeat, times)) {
+      printf("%8u %8u %8u\n", times[0], times[1], times[2]);
+    } else {
+      printf("%8s\n", "no reply");
+      failed++;
+    }
+    fflush(stdout);
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,216 @@
+/**
+ * DMX-84
+ * Codec size table
+ *
+ * Packs some typical cue changes with Codec.pack() (../arduino/firmware/
+ * codec.cpp), with and without knowing the previous universe, and prints
+ * the bytes each takes on the wire (command byte included) as the table in
+ * ../arduino/README.md. Every packet is decoded back with Codec.decode() and
+ * checked against the universe it was packed from.
+ *
+ * The looks are made with a fixed seed, so the table is the same every run.
+ * The rig is 32 fixtures of 8 channels at random levels, the rest of the
+ * universe dark.
+ *
+ * Usage: codecsize
+ * Fails if a packet doesn't decode back to its universe.
+ *
+ * Last modified October 16, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "codec.h"
+
+/******************************************************************************
+ * Internal constants
+ ******************************************************************************/
+
+//RLE and delta packets: the command and a 16-bit start channel
+#define RLE_HEADER_LENGTH     3
+
+#define FIXTURES              32
+#define FIXTURE_CHANNELS      8
+
+/******************************************************************************
+ * Internal types
+ ******************************************************************************/
+
+struct Change {
+  const char *name;
+  void (*make)(uint8_t *before, uint8_t *after);
+};
+
+/******************************************************************************
+ * Internal variables
+ ******************************************************************************/
+
+static uint32_t seed;
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**
+ * random8 - Returns the next byte from a xorshift generator, the same on
+ * every host.
+ */
+static uint8_t random8(void) {
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed >> 24;
+}
+
+static void makeRig(uint8_t *universe) {
+  memset(universe, 0, CODEC_UNIVERSE_SIZE);
+  for (uint16_t i = 0; i < FIXTURES * FIXTURE_CHANNELS; i++) {
+    universe[i] = random8();
+  }
+}
+
+static void makeRandom(uint8_t *universe) {
+  for (uint16_t i = 0; i < CODEC_UNIVERSE_SIZE; i++) {
+    universe[i] = random8();
+  }
+}
+
+static void scattered(uint8_t *before, uint8_t *after) {
+  makeRig(before);
+  memcpy(after, before, CODEC_UNIVERSE_SIZE);
+  after[10] ^= 0x40;
+  after[150] ^= 0x40;
+  after[230] ^= 0x40;
+}
+
+static void blockToFull(uint8_t *before, uint8_t *after) {
+  makeRig(before);
+  memcpy(after, before, CODEC_UNIVERSE_SIZE);
+  memset(after + 64, 0xFF, 48);
+}
+
+static void sixtyFour(uint8_t *before, uint8_t *after) {
+  makeRig(before);
+  memcpy(after, before, CODEC_UNIVERSE_SIZE);
+  for (uint16_t i = 0; i < 64; i++) {
+    after[i] = i * 4 + 1;
+  }
+}
+
+static void fixtureParameters(uint8_t *before, uint8_t *after) {
+  makeRig(before);
+  memcpy(after, before, CODEC_UNIVERSE_SIZE);
+  for (uint16_t i = 0; i < FIXTURES; i++) {
+    for (uint8_t j = 0; j < 2; j++) {
+      after[i * FIXTURE_CHANNELS + random8() % FIXTURE_CHANNELS] = random8();
+    }
+  }
+}
+
+static void rigUp(uint8_t *before, uint8_t *after) {
+  makeRig(before);
+  memcpy(after, before, CODEC_UNIVERSE_SIZE);
+  for (uint16_t i = 0; i < FIXTURES * FIXTURE_CHANNELS; i++) {
+    after[i] = before[i] > 0xFF - 10 ? 0xFF : before[i] + 10;
+  }
+}
+
+static void nudged(uint8_t *before, uint8_t *after) {
+  makeRandom(before);
+  memcpy(after, before, CODEC_UNIVERSE_SIZE);
+  for (uint16_t i = 0; i < CODEC_UNIVERSE_SIZE; i++) {
+    if (random8() % 8 == 0) {
+      after[i] ^= 1 + random8() % 3;
+    }
+  }
+}
+
+static void blackout(uint8_t *before, uint8_t *after) {
+  makeRig(before);
+  memset(after, 0, CODEC_UNIVERSE_SIZE);
+}
+
+static void randomLook(uint8_t *before, uint8_t *after) {
+  makeRandom(before);
+  makeRandom(after);
+}
+
+static const Change changes[] = {
+  {"3 scattered channels change",         scattered},
+  {"48-channel block to full",            blockToFull},
+  {"64 channels, all at different levels", sixtyFour},
+  {"32 fixtures, 2 random parameters each", fixtureParameters},
+  {"Whole rig up by 10",                  rigUp},
+  {"Random universe, 1 in 8 channels nudged", nudged},
+  {"Back to blackout",                    blackout},
+  {"Random universe",                     randomLook}
+};
+
+/**
+ * roundTrip - Packs a universe and checks that the packet brings a receiver
+ * holding another universe to it.
+ *
+ * Parameters:
+ *    const uint8_t *after: the universe to send
+ *    const uint8_t *last: what pack() is told the receiver has, or 0
+ *    const uint8_t *held: what the receiver really has
+ * Returns:
+ *    uint16_t length: the packet length, or 0 if it decoded wrong
+ */
+static uint16_t roundTrip(const uint8_t *after, const uint8_t *last,
+    const uint8_t *held) {
+  uint8_t packet[CODEC_MAX_PACKET];
+  uint16_t length = Codec.pack(after, last, packet);
+  uint8_t universe[CODEC_UNIVERSE_SIZE];
+  memcpy(universe, held, sizeof(universe));
+  if (packet[0] == CODEC_RAW_CMD) {
+    memcpy(universe, packet + 1, sizeof(universe));
+  } else if (length < RLE_HEADER_LENGTH ||
+      !Codec.decode(universe, packet[1] | packet[2] << 8,
+      packet + RLE_HEADER_LENGTH, length - RLE_HEADER_LENGTH,
+      packet[0] == CODEC_DELTA_CMD)) {
+    return 0;
+  }
+  return memcmp(universe, after, sizeof(universe)) ? 0 : length;
+}
+
+int main(void) {
+  printf("| %-40s | Delta known | No history |\n", "Change");
+  printf("|------------------------------------------|------------:"
+      "|-----------:|\n");
+  int failed = 0;
+  for (unsigned i = 0; i < sizeof(changes) / sizeof(changes[0]); i++) {
+    uint8_t before[CODEC_UNIVERSE_SIZE], after[CODEC_UNIVERSE_SIZE];
+    seed = 0x84 + i;
+    changes[i].make(before, after);
+    uint16_t delta = roundTrip(after, before, before);
+    uint16_t fresh = roundTrip(after, 0, before);
+    printf("| %-40s | %11u | %10u |\n", changes[i].name, delta, fresh);
+    if (!delta || !fresh) {
+      fprintf(stderr, "%s: a packet didn't decode back\n", changes[i].name);
+      failed++;
+    }
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,178 @@
+/**
+ * DMX-84
+ * Trace decoder
+ *
+ * Reads the firmware's serial output and prints the binary trace records (see
+ * src/arduino/firmware/trace.h) as text. Text messages from the firmware are
+ * passed through as they are.
+ *
+ * Usage: tracedump [serial port]
+ * Without a port, reads a capture from standard input.
+ *
+ * Last modified October 15, 2026
+ *
+ *
+ * Copyright (C) 2014  Alex Cordonnier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "../arduino/firmware/trace.h"
+
+/******************************************************************************
+ * Internal constants
+ ******************************************************************************/
+
+//Must match SERIAL_SPEED in link.h
+#define SERIAL_BAUD           B9600
+
+//Bytes in a record on the wire, after TRACE_SYNC
+#define RECORD_LENGTH         8
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**
+ * openPort - Opens a serial port raw at the firmware's speed.
+ *
+ * Parameter:
+ *    const char *path: the serial device
+ * Returns:
+ *    int fd: the open port, or -1 on failure
+ */
+static int openPort(const char *path) {
+  int fd = open(path, O_RDONLY | O_NOCTTY);
+  if (fd < 0) {
+    return -1;
+  }
+  struct termios tio;
+  if (tcgetattr(fd, &tio) == 0) {
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, SERIAL_BAUD);
+    cfsetospeed(&tio, SERIAL_BAUD);
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+  return fd;
+}
+
+/**
+ * nextByte - Reads one byte.
+ *
+ * Returns:
+ *    int byte: the byte, or -1 at the end of the input
+ */
+static int nextByte(int fd) {
+  unsigned char c;
+  return read(fd, &c, 1) == 1 ? c : -1;
+}
+
+/**
+ * printRecord - Prints one decoded record.
+ *
+ * Parameter:
+ *    const unsigned char *r: the RECORD_LENGTH record bytes
+ */
+static void printRecord(const unsigned char *r) {
+  unsigned long time = r[0] | r[1] << 8 | r[2] << 16 | (unsigned long)r[3] << 24;
+  unsigned event = r[4];
+  unsigned a = r[5];
+  unsigned b = r[6] | r[7] << 8;
+
+  printf("[%4lu.%06lu] ", time / 1000000, time % 1000000);
+  switch (event) {
+    case TRACE_EVENT_BOOT:
+      printf("boot\n");
+      break;
+    case TRACE_EVENT_DROPPED:
+      printf("dropped %u records\n", b);
+      break;
+    case TRACE_EVENT_ERROR:
+      printf("error flag 0x%02X\n", a);
+      break;
+    case TRACE_EVENT_LINK_TIMEOUT:
+      printf("link timed out\n");
+      break;
+    case TRACE_EVENT_LINK_BUSY:
+      printf("link busy\n");
+      break;
+    case TRACE_EVENT_SEND_ERROR:
+      printf("error sending %s: %u\n",
+          a == 0 ? "head" : a == 3 ? "checksum" : "data", b);
+      break;
+    case TRACE_EVENT_COMMAND:
+      printf("command 0x%02X, %u bytes\n", a, b);
+      break;
+    case TRACE_EVENT_COMMAND_DONE:
+      printf("command 0x%02X done\n", a);
+      break;
+    case TRACE_EVENT_CUE:
+      printf("cued command 0x%02X, %u bytes\n", a, b);
+      break;
+    case TRACE_EVENT_RECEIVED:
+      printf("received %u bytes, first 0x%02X\n", b, a);
+      break;
+    case TRACE_EVENT_SENT:
+      printf("sent %u bytes, first 0x%02X\n", b, a);
+      break;
+    case TRACE_EVENT_SENT_ID:
+      printf("sent TI command 0x%02X\n", a);
+      break;
+    default:
+      printf("event 0x%02X a=0x%02X b=%u\n", event, a, b);
+      break;
+  }
+}
+
+int main(int argc, char **argv) {
+  int fd = 0;
+  if (argc > 1) {
+    fd = openPort(argv[1]);
+    if (fd < 0) {
+      perror(argv[1]);
+      return 1;
+    }
+  }
+
+  int c;
+  while ((c = nextByte(fd)) >= 0) {
+    if (c != TRACE_SYNC) {
+      putchar(c); //Text message
+      continue;
+    }
+    unsigned char record[RECORD_LENGTH];
+    int i;
+    for (i = 0; i < RECORD_LENGTH && (c = nextByte(fd)) >= 0; i++) {
+      record[i] = c;
+    }
+    if (i < RECORD_LENGTH) {
+      break;
+    }
+    printRecord(record);
+    fflush(stdout);
+  }
+  return 0;
+}